@@ -5,12 +5,16 @@
 
 #pragma once
 
+#include "flatgeobuf_p.hpp"
+#include "geobuf_p.hpp"
 #include "geojson_p.hpp"
 #include "types.hpp"
 
 #include <mbgl/style/conversion/geojson.hpp>
 #include <mbgl/style/conversion_impl.hpp>
 
+#include <QtCore/QAssociativeIterable>
+#include <QtCore/QSequentialIterable>
 #include <QtCore/QVariant>
 #include <QtGui/QColor>
 
@@ -19,6 +23,7 @@
 namespace mbgl::style::conversion {
 
 std::string convertColor(const QColor &color);
+QVariant normalized(const QVariant &value);
 
 template <>
 class ConversionTraits<QVariant> {
@@ -32,9 +37,19 @@ public:
         return QMetaType::canConvert(value.metaType(), QMetaType(QMetaType::QVariantList));
     }
 
-    static std::size_t arrayLength(const QVariant &value) { return value.toList().size(); }
+    static std::size_t arrayLength(const QVariant &value) {
+        if (const QVariantList *list = asList(value)) {
+            return list->size();
+        }
+        return value.toList().size();
+    }
 
-    static QVariant arrayMember(const QVariant &value, std::size_t i) { return value.toList()[static_cast<int>(i)]; }
+    static QVariant arrayMember(const QVariant &value, std::size_t i) {
+        if (const QVariantList *list = asList(value)) {
+            return list->at(static_cast<qsizetype>(i));
+        }
+        return value.toList()[static_cast<qsizetype>(i)];
+    }
 
     static bool isObject(const QVariant &value) {
         return QMetaType::canConvert(value.metaType(), QMetaType(QMetaType::QVariantMap)) ||
@@ -46,31 +61,18 @@ public:
     }
 
     static std::optional<QVariant> objectMember(const QVariant &value, const char *key) {
-        auto map = value.toMap();
-        auto iter = map.constFind(key);
-
-        if (iter != map.constEnd()) {
-            return iter.value();
+        if (const QVariantMap *map = asMap(value)) {
+            return member(*map, key);
         }
-
-        return {};
+        return member(value.toMap(), key);
     }
 
     template <class Fn>
     static std::optional<Error> eachMember(const QVariant &value, Fn &&fn) {
-        auto map = value.toMap();
-        auto iter = map.constBegin();
-
-        while (iter != map.constEnd()) {
-            std::optional<Error> result = fn(iter.key().toStdString(), QVariant(iter.value()));
-            if (result) {
-                return result;
-            }
-
-            ++iter;
+        if (const QVariantMap *map = asMap(value)) {
+            return eachMember(*map, std::forward<Fn>(fn));
         }
-
-        return {};
+        return eachMember(value.toMap(), std::forward<Fn>(fn));
     }
 
     static std::optional<bool> toBool(const QVariant &value) {
@@ -142,6 +144,17 @@ public:
             return GeoJSON{QMapLibre::GeoJSON::asFeature(value.value<QMapLibre::Feature>())};
         }
 
+        if (value.userType() == qMetaTypeId<QMapLibre::FeatureBatch>()) {
+            std::string message;
+            std::optional<mbgl::FeatureCollection> collection = QMapLibre::GeoJSON::asFeatureCollection(
+                *static_cast<const QMapLibre::FeatureBatch *>(value.constData()), message);
+            if (!collection) {
+                error = {message};
+                return {};
+            }
+            return GeoJSON{std::move(*collection)};
+        }
+
         if (value.userType() == qMetaTypeId<QVector<QMapLibre::Feature>>()) {
             return featureCollectionToGeoJSON(value.value<QVector<QMapLibre::Feature>>());
         }
@@ -160,16 +173,148 @@ public:
         }
 
         const QByteArray data = value.toByteArray();
-        return parseGeoJSON(std::string(data.constData(), data.size()), error);
+        const auto size = static_cast<std::size_t>(data.size());
+
+        // Binary formats are decoded directly, without a text stage.
+        std::string message;
+        std::optional<GeoJSON> geojson;
+        if (QMapLibre::FlatGeobuf::isFlatGeobuf(data.constData(), size)) {
+            geojson = QMapLibre::FlatGeobuf::decode(data.constData(), size, std::nullopt, message);
+        } else if (QMapLibre::Geobuf::isGeobuf(data.constData(), size)) {
+            geojson = QMapLibre::Geobuf::decode(data.constData(), size, message);
+        } else {
+            return parseGeoJSON(std::string(data.constData(), size), error);
+        }
+
+        if (!geojson) {
+            error = {message};
+        }
+        return geojson;
+    }
+
+    // Returns true and sets normalized if value or any nested container had
+    // to be converted. Containers which are left as they are stay shared.
+    static bool normalize(const QVariant &value, QVariant &normalized) {
+        if (const QVariantList *list = asList(value)) {
+            QVariantList result;
+            bool changed = false;
+            for (qsizetype i = 0; i < list->size(); ++i) {
+                QVariant item;
+                if (normalize(list->at(i), item)) {
+                    if (!changed) {
+                        result = *list;
+                        changed = true;
+                    }
+                    result[i] = std::move(item);
+                }
+            }
+            if (!changed) {
+                return false;
+            }
+            normalized = std::move(result);
+            return true;
+        }
+
+        if (const QVariantMap *map = asMap(value)) {
+            QVariantMap result;
+            bool changed = false;
+            for (auto iter = map->constBegin(); iter != map->constEnd(); ++iter) {
+                QVariant item;
+                if (normalize(iter.value(), item)) {
+                    if (!changed) {
+                        result = *map;
+                        changed = true;
+                    }
+                    result.insert(iter.key(), std::move(item));
+                }
+            }
+            if (!changed) {
+                return false;
+            }
+            normalized = std::move(result);
+            return true;
+        }
+
+        // Skip the iterable lookup for scalars, most values in a style are.
+        const int typeId = value.typeId();
+        if (typeId < QMetaType::User && typeId != QMetaType::QStringList && typeId != QMetaType::QByteArrayList &&
+            typeId != QMetaType::QVariantHash) {
+            return false;
+        }
+
+        // Feature lists are sequential containers, but are converted as GeoJSON.
+        if (value.userType() == qMetaTypeId<QVector<QMapLibre::Feature>>() ||
+            value.userType() == qMetaTypeId<QList<QMapLibre::Feature>>() ||
+            value.userType() == qMetaTypeId<std::list<QMapLibre::Feature>>()) {
+            return false;
+        }
+
+        if (value.canView<QAssociativeIterable>()) {
+            const QVariant map(value.toMap());
+            if (!normalize(map, normalized)) {
+                normalized = map;
+            }
+            return true;
+        }
+
+        if (value.canView<QSequentialIterable>()) {
+            const QVariant list(value.toList());
+            if (!normalize(list, normalized)) {
+                normalized = list;
+            }
+            return true;
+        }
+
+        return false;
     }
 
 private:
+    // Views into the variant, so members can be accessed without copying the
+    // container. Other containers are converted on every access, which is why
+    // convert() normalizes them once up front.
+    static const QVariantList *asList(const QVariant &value) {
+        return value.typeId() == QMetaType::QVariantList ? static_cast<const QVariantList *>(value.constData())
+                                                         : nullptr;
+    }
+
+    static const QVariantMap *asMap(const QVariant &value) {
+        return value.typeId() == QMetaType::QVariantMap ? static_cast<const QVariantMap *>(value.constData())
+                                                        : nullptr;
+    }
+
+    static std::optional<QVariant> member(const QVariantMap &map, const char *key) {
+        auto iter = map.constFind(QString::fromUtf8(key));
+
+        if (iter != map.constEnd()) {
+            return iter.value();
+        }
+
+        return {};
+    }
+
+    template <class Fn>
+    static std::optional<Error> eachMember(const QVariantMap &map, Fn &&fn) {
+        auto iter = map.constBegin();
+
+        while (iter != map.constEnd()) {
+            std::optional<Error> result = fn(iter.key().toStdString(), QVariant(iter.value()));
+            if (result) {
+                return result;
+            }
+
+            ++iter;
+        }
+
+        return {};
+    }
+
     template <typename T>
     static GeoJSON featureCollectionToGeoJSON(const T &features) {
         mapbox::feature::feature_collection<double> collection;
         collection.reserve(static_cast<std::size_t>(features.size()));
+        QMapLibre::GeoJSON::PropertyConverter converter;
         for (const auto &feature : features) {
-            collection.push_back(QMapLibre::GeoJSON::asFeature(feature));
+            collection.push_back(QMapLibre::GeoJSON::asFeature(feature, converter));
         }
         return GeoJSON{std::move(collection)};
     }
@@ -177,7 +322,14 @@ private:
 
 template <class T, class... Args>
 std::optional<T> convert(const QVariant &value, Error &error, Args &&...args) {
-    return convert<T>(Convertible(value), error, std::forward<Args>(args)...);
+    return convert<T>(Convertible(normalized(value)), error, std::forward<Args>(args)...);
+}
+
+// Converts nested containers other than QVariantList and QVariantMap once, so
+// that ConversionTraits<QVariant> can walk the whole value in place.
+inline QVariant normalized(const QVariant &value) {
+    QVariant result;
+    return ConversionTraits<QVariant>::normalize(value, result) ? result : value;
 }
 
 inline std::string convertColor(const QColor &color) {
@@ -0,0 +1,555 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "flatgeobuf_p.hpp"
+
+#include <mapbox/geometry/envelope.hpp>
+#include <mbgl/util/feature.hpp>
+#include <mbgl/util/geometry.hpp>
+
+#include <QtCore/QtEndian>
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// See https://github.com/flatgeobuf/flatgeobuf/tree/master/src/fbs for the
+// schema the field indices below refer to.
+constexpr std::size_t MagicSize = 8;
+constexpr std::size_t NodeItemSize = 40;
+// Nesting of geometry collections, deeper input is rejected before it can
+// exhaust the stack.
+constexpr int MaxGeometryDepth = 64;
+
+enum GeometryType : std::uint8_t {
+    UnknownGeometry = 0,
+    PointGeometry,
+    LineStringGeometry,
+    PolygonGeometry,
+    MultiPointGeometry,
+    MultiLineStringGeometry,
+    MultiPolygonGeometry,
+    GeometryCollectionGeometry
+};
+
+enum ColumnType : std::uint8_t {
+    ByteColumn = 0,
+    UByteColumn,
+    BoolColumn,
+    ShortColumn,
+    UShortColumn,
+    IntColumn,
+    UIntColumn,
+    LongColumn,
+    ULongColumn,
+    FloatColumn,
+    DoubleColumn,
+    StringColumn,
+    JsonColumn,
+    DateTimeColumn,
+    BinaryColumn
+};
+
+enum HeaderField {
+    HeaderGeometryType = 2,
+    HeaderColumns = 7,
+    HeaderFeaturesCount = 8,
+    HeaderIndexNodeSize = 9
+};
+
+enum ColumnField {
+    ColumnName = 0,
+    ColumnTypeField = 1
+};
+
+enum GeometryField {
+    GeometryEnds = 0,
+    GeometryXY = 1,
+    GeometryTypeField = 6,
+    GeometryParts = 7
+};
+
+enum FeatureField {
+    FeatureGeometry = 0,
+    FeatureProperties = 1,
+    FeatureColumns = 2
+};
+
+// Bounds checked little endian reads. A failed read marks the buffer as
+// invalid and returns a default value, so decoding can check once at the end.
+class Buffer {
+public:
+    Buffer(const char *data, std::size_t size)
+        : m_data(data),
+          m_size(size) {}
+
+    template <typename T>
+    T read(std::size_t pos) {
+        if (!contains(pos, sizeof(T))) {
+            return T{};
+        }
+        return qFromLittleEndian<T>(m_data + pos);
+    }
+
+    bool contains(std::size_t pos, std::size_t size) {
+        if (pos > m_size || m_size - pos < size) {
+            m_valid = false;
+        }
+        return m_valid;
+    }
+
+    const char *data(std::size_t pos) const { return m_data + pos; }
+    [[nodiscard]] std::size_t size() const { return m_size; }
+    [[nodiscard]] bool isValid() const { return m_valid; }
+    void invalidate() { m_valid = false; }
+
+private:
+    const char *m_data;
+    std::size_t m_size;
+    bool m_valid{true};
+};
+
+struct Vector {
+    std::size_t pos{};
+    std::uint32_t length{};
+};
+
+// FlatBuffers table, fields are addressed by their index in the schema.
+class Table {
+public:
+    Table() = default;
+    Table(Buffer *buffer, std::size_t pos)
+        : m_buffer(buffer),
+          m_pos(pos) {
+        const auto vtable = static_cast<std::int64_t>(pos) - buffer->read<std::int32_t>(pos);
+        if (vtable < 0) {
+            buffer->invalidate();
+            m_buffer = nullptr;
+            return;
+        }
+        m_vtable = static_cast<std::size_t>(vtable);
+        m_vtableSize = buffer->read<std::uint16_t>(m_vtable);
+    }
+
+    static Table root(Buffer &buffer, std::size_t pos) { return {&buffer, pos + buffer.read<std::uint32_t>(pos)}; }
+
+    [[nodiscard]] bool isNull() const { return m_buffer == nullptr; }
+
+    template <typename T>
+    T scalar(int index, T defaultValue = {}) const {
+        const std::size_t pos = field(index);
+        return pos != 0 ? m_buffer->read<T>(pos) : defaultValue;
+    }
+
+    [[nodiscard]] Table table(int index) const {
+        const std::size_t pos = indirect(index);
+        return pos != 0 ? Table(m_buffer, pos) : Table();
+    }
+
+    [[nodiscard]] Vector vector(int index, std::size_t elementSize) const {
+        const std::size_t pos = indirect(index);
+        if (pos == 0) {
+            return {};
+        }
+        const auto length = m_buffer->read<std::uint32_t>(pos);
+        if (!m_buffer->contains(pos + 4, std::size_t{length} * elementSize)) {
+            return {};
+        }
+        return {pos + 4, length};
+    }
+
+    [[nodiscard]] Table vectorTable(const Vector &vector, std::uint32_t i) const {
+        const std::size_t pos = vector.pos + 4 * std::size_t{i};
+        return {m_buffer, pos + m_buffer->read<std::uint32_t>(pos)};
+    }
+
+    [[nodiscard]] std::string string(int index) const {
+        const Vector characters = vector(index, 1);
+        return {m_buffer->data(characters.pos), characters.length};
+    }
+
+private:
+    // Position of the field, or 0 if it is not set.
+    [[nodiscard]] std::size_t field(int index) const {
+        const std::size_t entry = 4 + 2 * static_cast<std::size_t>(index);
+        if (m_buffer == nullptr || entry + 2 > m_vtableSize) {
+            return 0;
+        }
+        const auto offset = m_buffer->read<std::uint16_t>(m_vtable + entry);
+        return offset != 0 ? m_pos + offset : 0;
+    }
+
+    // Position an offset field points to, or 0 if it is not set.
+    [[nodiscard]] std::size_t indirect(int index) const {
+        const std::size_t pos = field(index);
+        return pos != 0 ? pos + m_buffer->read<std::uint32_t>(pos) : 0;
+    }
+
+    Buffer *m_buffer{};
+    std::size_t m_pos{};
+    std::size_t m_vtable{};
+    std::uint16_t m_vtableSize{};
+};
+
+struct Column {
+    std::string name;
+    std::uint8_t type{};
+};
+
+std::vector<Column> readColumns(const Table &table, int index) {
+    const Vector vector = table.vector(index, 4);
+    std::vector<Column> columns;
+    columns.reserve(vector.length);
+    for (std::uint32_t i = 0; i < vector.length; ++i) {
+        const Table column = table.vectorTable(vector, i);
+        columns.push_back({column.string(ColumnName), column.scalar<std::uint8_t>(ColumnTypeField)});
+    }
+    return columns;
+}
+
+mbgl::PropertyMap readProperties(Buffer &buffer, const Vector &properties, const std::vector<Column> &columns) {
+    mbgl::PropertyMap map;
+    std::size_t pos = properties.pos;
+    const std::size_t end = properties.pos + properties.length;
+    while (pos < end && buffer.isValid()) {
+        const auto index = buffer.read<std::uint16_t>(pos);
+        pos += 2;
+        if (index >= columns.size()) {
+            buffer.invalidate();
+            break;
+        }
+
+        const Column &column = columns[index];
+        switch (column.type) {
+            case ByteColumn:
+                map.emplace(column.name, std::int64_t{buffer.read<std::int8_t>(pos)});
+                pos += 1;
+                break;
+            case UByteColumn:
+                map.emplace(column.name, std::uint64_t{buffer.read<std::uint8_t>(pos)});
+                pos += 1;
+                break;
+            case BoolColumn:
+                map.emplace(column.name, buffer.read<std::uint8_t>(pos) != 0);
+                pos += 1;
+                break;
+            case ShortColumn:
+                map.emplace(column.name, std::int64_t{buffer.read<std::int16_t>(pos)});
+                pos += 2;
+                break;
+            case UShortColumn:
+                map.emplace(column.name, std::uint64_t{buffer.read<std::uint16_t>(pos)});
+                pos += 2;
+                break;
+            case IntColumn:
+                map.emplace(column.name, std::int64_t{buffer.read<std::int32_t>(pos)});
+                pos += 4;
+                break;
+            case UIntColumn:
+                map.emplace(column.name, std::uint64_t{buffer.read<std::uint32_t>(pos)});
+                pos += 4;
+                break;
+            case LongColumn:
+                map.emplace(column.name, buffer.read<std::int64_t>(pos));
+                pos += 8;
+                break;
+            case ULongColumn:
+                map.emplace(column.name, buffer.read<std::uint64_t>(pos));
+                pos += 8;
+                break;
+            case FloatColumn:
+                map.emplace(column.name, double{buffer.read<float>(pos)});
+                pos += 4;
+                break;
+            case DoubleColumn:
+                map.emplace(column.name, buffer.read<double>(pos));
+                pos += 8;
+                break;
+            case StringColumn:
+            case JsonColumn:
+            case DateTimeColumn: {
+                const auto length = buffer.read<std::uint32_t>(pos);
+                pos += 4;
+                if (buffer.contains(pos, length)) {
+                    map.emplace(column.name, std::string(buffer.data(pos), length));
+                }
+                pos += length;
+            } break;
+            case BinaryColumn:
+                // Binary values have no property value equivalent.
+                pos += 4 + std::size_t{buffer.read<std::uint32_t>(pos)};
+                break;
+            default:
+                buffer.invalidate();
+                break;
+        }
+    }
+
+    return map;
+}
+
+mbgl::Geometry<double> readGeometry(Buffer &buffer, const Table &geometry, std::uint8_t type, int depth = 0) {
+    if (depth > MaxGeometryDepth) {
+        buffer.invalidate();
+        return mapbox::geometry::empty{};
+    }
+
+    const Vector xy = geometry.vector(GeometryXY, 2 * sizeof(double));
+    const Vector ends = geometry.vector(GeometryEnds, sizeof(std::uint32_t));
+    const std::uint32_t pointCount = xy.length / 2;
+
+    const auto point = [&buffer, &xy](std::uint32_t i) {
+        const std::size_t pos = xy.pos + 16 * std::size_t{i};
+        return mbgl::Point<double>{buffer.read<double>(pos), buffer.read<double>(pos + 8)};
+    };
+    const auto points = [&point](auto &line, std::uint32_t begin, std::uint32_t end) {
+        line.reserve(end - begin);
+        for (std::uint32_t i = begin; i < end; ++i) {
+            line.emplace_back(point(i));
+        }
+    };
+    // Without ends all points form a single line or ring.
+    const auto lines = [&](auto &result) {
+        const std::uint32_t count = ends.length != 0 ? ends.length : 1;
+        std::uint32_t begin = 0;
+        for (std::uint32_t i = 0; i < count; ++i) {
+            const std::uint32_t end = ends.length != 0 ? buffer.read<std::uint32_t>(ends.pos + 4 * std::size_t{i})
+                                                       : pointCount;
+            if (end < begin || end > pointCount) {
+                buffer.invalidate();
+                return;
+            }
+            typename std::decay_t<decltype(result)>::value_type line;
+            points(line, begin, end);
+            result.emplace_back(std::move(line));
+            begin = end;
+        }
+    };
+
+    switch (type) {
+        case PointGeometry:
+            if (pointCount == 0) {
+                return mapbox::geometry::empty{};
+            }
+            return point(0);
+        case MultiPointGeometry: {
+            mbgl::MultiPoint<double> multiPoint;
+            points(multiPoint, 0, pointCount);
+            return multiPoint;
+        }
+        case LineStringGeometry: {
+            mbgl::LineString<double> lineString;
+            points(lineString, 0, pointCount);
+            return lineString;
+        }
+        case MultiLineStringGeometry: {
+            mbgl::MultiLineString<double> multiLineString;
+            lines(multiLineString);
+            return multiLineString;
+        }
+        case PolygonGeometry: {
+            mbgl::Polygon<double> polygon;
+            lines(polygon);
+            return polygon;
+        }
+        case MultiPolygonGeometry: {
+            const Vector parts = geometry.vector(GeometryParts, 4);
+            mbgl::MultiPolygon<double> multiPolygon;
+            multiPolygon.reserve(parts.length);
+            for (std::uint32_t i = 0; i < parts.length && buffer.isValid(); ++i) {
+                mbgl::Geometry<double> part = readGeometry(buffer, geometry.vectorTable(parts, i), PolygonGeometry);
+                multiPolygon.emplace_back(std::move(part.get<mbgl::Polygon<double>>()));
+            }
+            return multiPolygon;
+        }
+        case GeometryCollectionGeometry: {
+            const Vector parts = geometry.vector(GeometryParts, 4);
+            mapbox::geometry::geometry_collection<double> collection;
+            collection.reserve(parts.length);
+            for (std::uint32_t i = 0; i < parts.length && buffer.isValid(); ++i) {
+                const Table part = geometry.vectorTable(parts, i);
+                collection.emplace_back(
+                    readGeometry(buffer, part, part.scalar<std::uint8_t>(GeometryTypeField), depth + 1));
+            }
+            return collection;
+        }
+        default:
+            buffer.invalidate();
+            return mapbox::geometry::empty{};
+    }
+}
+
+bool intersects(const mapbox::geometry::box<double> &a, const mapbox::geometry::box<double> &b) {
+    return a.min.x <= b.max.x && a.min.y <= b.max.y && a.max.x >= b.min.x && a.max.y >= b.min.y;
+}
+
+// Start and end node of each level of the packed R-tree, from the leaves up
+// to the root. Nodes are stored from the root down.
+std::vector<std::pair<std::uint64_t, std::uint64_t>> levelBounds(std::uint64_t itemCount, std::uint16_t nodeSize) {
+    std::vector<std::uint64_t> levelSizes{itemCount};
+    std::uint64_t nodeCount = itemCount;
+    std::uint64_t n = itemCount;
+    do {
+        n = (n + nodeSize - 1) / nodeSize;
+        nodeCount += n;
+        levelSizes.push_back(n);
+    } while (n != 1);
+
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> bounds;
+    bounds.reserve(levelSizes.size());
+    for (const std::uint64_t size : levelSizes) {
+        nodeCount -= size;
+        bounds.emplace_back(nodeCount, nodeCount + size);
+    }
+    return bounds;
+}
+
+// Byte offsets of the features intersecting bounds, relative to the first
+// feature and in file order.
+std::vector<std::uint64_t> search(Buffer &buffer,
+                                  std::size_t indexPos,
+                                  const std::vector<std::pair<std::uint64_t, std::uint64_t>> &levels,
+                                  std::uint16_t nodeSize,
+                                  const mapbox::geometry::box<double> &bounds) {
+    const std::uint64_t leavesBegin = levels.front().first;
+
+    std::vector<std::uint64_t> offsets;
+    std::vector<std::pair<std::uint64_t, std::size_t>> queue{{0, levels.size() - 1}};
+    while (!queue.empty() && buffer.isValid()) {
+        const auto [node, level] = queue.back();
+        queue.pop_back();
+
+        const std::uint64_t end = std::min<std::uint64_t>(node + nodeSize, levels[level].second);
+        for (std::uint64_t i = node; i < end; ++i) {
+            const std::size_t pos = indexPos + i * NodeItemSize;
+            const mapbox::geometry::box<double> box{{buffer.read<double>(pos), buffer.read<double>(pos + 8)},
+                                                    {buffer.read<double>(pos + 16), buffer.read<double>(pos + 24)}};
+            if (!intersects(box, bounds)) {
+                continue;
+            }
+
+            const auto offset = buffer.read<std::uint64_t>(pos + 32);
+            if (node >= leavesBegin) {
+                offsets.push_back(offset);
+            } else if (level > 0 && offset >= levels[level - 1].first && offset < levels[level - 1].second) {
+                queue.emplace_back(offset, level - 1);
+            } else {
+                buffer.invalidate();
+            }
+        }
+    }
+
+    std::sort(offsets.begin(), offsets.end());
+    return offsets;
+}
+
+} // namespace
+
+namespace QMapLibre::FlatGeobuf {
+
+bool isFlatGeobuf(const char *data, std::size_t size) {
+    return size >= MagicSize && data[0] == 'f' && data[1] == 'g' && data[2] == 'b' && data[4] == 'f' &&
+           data[5] == 'g' && data[6] == 'b';
+}
+
+std::optional<mbgl::GeoJSON> decode(const char *data,
+                                    std::size_t size,
+                                    const std::optional<mapbox::geometry::box<double>> &bounds,
+                                    std::string &error) {
+    if (!isFlatGeobuf(data, size)) {
+        error = "not a FlatGeobuf";
+        return {};
+    }
+
+    Buffer buffer(data, size);
+    const std::size_t headerSize = buffer.read<std::uint32_t>(MagicSize);
+    const Table header = Table::root(buffer, MagicSize + 4);
+    const auto geometryType = header.scalar<std::uint8_t>(HeaderGeometryType);
+    const std::vector<Column> columns = readColumns(header, HeaderColumns);
+    const auto featureCount = header.scalar<std::uint64_t>(HeaderFeaturesCount);
+    const auto nodeSize = header.scalar<std::uint16_t>(HeaderIndexNodeSize, 16);
+    if (!buffer.isValid()) {
+        error = "invalid FlatGeobuf header";
+        return {};
+    }
+
+    std::size_t featuresPos = MagicSize + 4 + headerSize;
+    std::vector<std::uint64_t> offsets;
+    bool indexed = false;
+    if (nodeSize > 0 && featureCount > 0) {
+        const auto treeNodeSize = std::max<std::uint16_t>(nodeSize, 2);
+        const auto levels = levelBounds(featureCount, treeNodeSize);
+        const std::uint64_t indexSize = levels.front().second * NodeItemSize;
+        if (levels.front().second > size / NodeItemSize || !buffer.contains(featuresPos, indexSize)) {
+            error = "invalid FlatGeobuf index";
+            return {};
+        }
+
+        if (bounds) {
+            offsets = search(buffer, featuresPos, levels, treeNodeSize, *bounds);
+            indexed = true;
+        }
+        featuresPos += indexSize;
+    } else if (!buffer.contains(featuresPos, 0)) {
+        error = "invalid FlatGeobuf header";
+        return {};
+    }
+
+    mbgl::FeatureCollection collection;
+    const auto readFeature = [&](std::size_t pos) {
+        // Each feature is a size prefixed FlatBuffer.
+        const Table feature = Table::root(buffer, pos + 4);
+        const Table geometry = feature.table(FeatureGeometry);
+        const std::uint8_t type = geometryType != UnknownGeometry ? geometryType
+                                                                 : geometry.scalar<std::uint8_t>(GeometryTypeField);
+
+        mbgl::GeoJSONFeature mbglFeature;
+        if (!geometry.isNull()) {
+            mbglFeature.geometry = readGeometry(buffer, geometry, type);
+        }
+        if (bounds && !indexed && !mbglFeature.geometry.is<mapbox::geometry::empty>() &&
+            !intersects(mapbox::geometry::envelope(mbglFeature.geometry), *bounds)) {
+            return;
+        }
+
+        const Vector properties = feature.vector(FeatureProperties, 1);
+        const std::vector<Column> featureColumns = readColumns(feature, FeatureColumns);
+        mbglFeature.properties = readProperties(buffer, properties, featureColumns.empty() ? columns : featureColumns);
+        if (buffer.isValid()) {
+            collection.emplace_back(std::move(mbglFeature));
+        }
+    };
+
+    if (indexed) {
+        collection.reserve(offsets.size());
+        for (const std::uint64_t offset : offsets) {
+            if (offset > size - featuresPos || !buffer.isValid()) {
+                buffer.invalidate();
+                break;
+            }
+            readFeature(featuresPos + offset);
+        }
+    } else {
+        collection.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(featureCount, size / 8)));
+        std::size_t pos = featuresPos;
+        while (pos < size && buffer.isValid()) {
+            const std::size_t featureSize = buffer.read<std::uint32_t>(pos);
+            readFeature(pos);
+            pos += 4 + featureSize;
+        }
+    }
+
+    if (!buffer.isValid()) {
+        error = "invalid FlatGeobuf feature";
+        return {};
+    }
+
+    return mbgl::GeoJSON{std::move(collection)};
+}
+
+} // namespace QMapLibre::FlatGeobuf
@@ -0,0 +1,32 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include <mapbox/geometry/box.hpp>
+#include <mbgl/util/geojson.hpp>
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+namespace QMapLibre::FlatGeobuf {
+
+/*! \cond PRIVATE */
+
+// Checks the magic bytes, the data does not need to be complete.
+bool isFlatGeobuf(const char *data, std::size_t size);
+
+// Decodes FlatGeobuf data into a feature collection. If bounds are given only
+// features whose bounding box intersects them are decoded, using the packed
+// Hilbert R-tree to skip the others when the data has an index. Coordinates
+// are used as they are, the data is expected to be in WGS 84.
+std::optional<mbgl::GeoJSON> decode(const char *data,
+                                    std::size_t size,
+                                    const std::optional<mapbox::geometry::box<double>> &bounds,
+                                    std::string &error);
+
+/*! \endcond */
+
+} // namespace QMapLibre::FlatGeobuf
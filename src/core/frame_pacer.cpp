@@ -0,0 +1,134 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "frame_pacer_p.hpp"
+
+#include <QtGui/QGuiApplication>
+#include <QtGui/QScreen>
+
+#include <algorithm>
+
+namespace {
+
+constexpr double DefaultRefreshRate = 60.0;
+
+double screenRefreshRate() {
+    if (qobject_cast<QGuiApplication *>(QCoreApplication::instance()) != nullptr) {
+        const QScreen *screen = QGuiApplication::primaryScreen();
+        if (screen != nullptr && screen->refreshRate() > 0) {
+            return screen->refreshRate();
+        }
+    }
+
+    return DefaultRefreshRate;
+}
+
+std::chrono::nanoseconds intervalForRate(double rate) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(1.0 / rate));
+}
+
+} // namespace
+
+namespace QMapLibre {
+
+/*! \cond PRIVATE */
+
+FramePacer::FramePacer(int maxFrameRate, QObject *parent)
+    : QObject(parent),
+      m_frameInterval(maxFrameRate > 0 ? intervalForRate(maxFrameRate) : std::chrono::nanoseconds::zero()) {
+    // A frame may wait up to one interval for its slot, and then has one
+    // display refresh to be rendered.
+    m_lateThreshold = m_frameInterval + intervalForRate(screenRefreshRate());
+
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &FramePacer::emitFrame);
+}
+
+FramePacer::~FramePacer() = default;
+
+void FramePacer::requestFrame() {
+    m_requestedUpdates.fetch_add(1, std::memory_order_relaxed);
+
+    if (m_frameQueued.test_and_set()) {
+        m_droppedFrames.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    m_requestTime.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+
+    // Queued to give time to merge redundant requests.
+    QMetaObject::invokeMethod(this, &FramePacer::dispatch, Qt::QueuedConnection);
+}
+
+void FramePacer::beginFrame() {
+    // Cleared before rendering, updates arriving meanwhile need a new frame.
+    m_frameRequestTime = m_requestTime.exchange(0, std::memory_order_relaxed);
+    m_frameQueued.clear();
+    m_frameStart = Clock::now();
+}
+
+void FramePacer::endFrame(std::uint64_t renderTargetWaits) {
+    const Clock::time_point now = Clock::now();
+    m_renderedFrames.fetch_add(1, std::memory_order_relaxed);
+    m_renderTargetWaits.fetch_add(renderTargetWaits, std::memory_order_relaxed);
+    m_totalRenderTime.fetch_add((now - m_frameStart).count(), std::memory_order_relaxed);
+
+    // Frames rendered without a request, e.g. on resize, are not paced.
+    if (m_frameRequestTime != 0) {
+        const Clock::duration latency = now - Clock::time_point(Clock::duration(m_frameRequestTime));
+        m_requestedFrames.fetch_add(1, std::memory_order_relaxed);
+        m_totalLatency.fetch_add(latency.count(), std::memory_order_relaxed);
+        if (latency > m_lateThreshold) {
+            m_lateFrames.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    m_frameRequestTime = 0;
+}
+
+FramePacerStatistics FramePacer::statistics() const {
+    FramePacerStatistics statistics;
+    statistics.requestedUpdates = m_requestedUpdates.load(std::memory_order_relaxed);
+    statistics.renderedFrames = m_renderedFrames.load(std::memory_order_relaxed);
+    statistics.droppedFrames = m_droppedFrames.load(std::memory_order_relaxed);
+    statistics.lateFrames = m_lateFrames.load(std::memory_order_relaxed);
+    statistics.renderTargetWaits = m_renderTargetWaits.load(std::memory_order_relaxed);
+
+    const auto average = [](Clock::rep total, std::uint64_t count) -> qint64 {
+        if (count == 0) {
+            return 0;
+        }
+        const Clock::duration mean(total / static_cast<Clock::rep>(count));
+        return std::chrono::duration_cast<std::chrono::microseconds>(mean).count();
+    };
+    statistics.frameLatency = average(m_totalLatency.load(std::memory_order_relaxed),
+                                      m_requestedFrames.load(std::memory_order_relaxed));
+    statistics.renderTime = average(m_totalRenderTime.load(std::memory_order_relaxed),
+                                    statistics.renderedFrames);
+    return statistics;
+}
+
+void FramePacer::dispatch() {
+    if (m_timer.isActive()) {
+        return;
+    }
+
+    const auto elapsed = Clock::now() - m_lastFrame;
+    if (elapsed >= m_frameInterval) {
+        emitFrame();
+        return;
+    }
+
+    const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(m_frameInterval - elapsed);
+    m_timer.start(std::max(remaining, std::chrono::milliseconds(1)));
+}
+
+void FramePacer::emitFrame() {
+    m_lastFrame = Clock::now();
+    emit frameRequested();
+}
+
+/*! \endcond PRIVATE */
+
+} // namespace QMapLibre
@@ -0,0 +1,74 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include "types.hpp"
+
+#include <QtCore/QObject>
+#include <QtCore/QTimer>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace QMapLibre {
+
+// Turns render requests from any thread into at most one frame request per
+// frame interval. Requests arriving while a frame is pending are merged
+// into it, so nothing is requested while the map is idle.
+class FramePacer : public QObject {
+    Q_OBJECT
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // A maximum frame rate of 0 does not limit the frame rate.
+    explicit FramePacer(int maxFrameRate, QObject *parent = nullptr);
+    ~FramePacer() override;
+
+    // Thread-safe.
+    void requestFrame();
+    // To be called on the render thread around rendering a frame, with the
+    // number of times the frame waited for a free render target.
+    void beginFrame();
+    void endFrame(std::uint64_t renderTargetWaits = 0);
+
+    [[nodiscard]] FramePacerStatistics statistics() const;
+
+signals:
+    void frameRequested();
+
+private:
+    Q_DISABLE_COPY(FramePacer)
+
+    void dispatch();
+    void emitFrame();
+
+    const std::chrono::nanoseconds m_frameInterval;
+    // Rendering this much after the request counts as a late frame.
+    std::chrono::nanoseconds m_lateThreshold;
+
+    QTimer m_timer;
+    Clock::time_point m_lastFrame;
+
+    std::atomic_flag m_frameQueued = ATOMIC_FLAG_INIT;
+    // Time of the request that queued the pending frame, 0 if none.
+    std::atomic<Clock::rep> m_requestTime{0};
+    // Request time of the frame being rendered, render thread only.
+    Clock::rep m_frameRequestTime{0};
+    Clock::time_point m_frameStart;
+
+    std::atomic<std::uint64_t> m_requestedUpdates{0};
+    std::atomic<std::uint64_t> m_renderedFrames{0};
+    std::atomic<std::uint64_t> m_droppedFrames{0};
+    std::atomic<std::uint64_t> m_lateFrames{0};
+    // Frames rendered on request and their summed latency.
+    std::atomic<std::uint64_t> m_requestedFrames{0};
+    std::atomic<Clock::rep> m_totalLatency{0};
+    std::atomic<Clock::rep> m_totalRenderTime{0};
+    std::atomic<std::uint64_t> m_renderTargetWaits{0};
+};
+
+} // namespace QMapLibre
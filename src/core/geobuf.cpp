@@ -0,0 +1,502 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "geobuf_p.hpp"
+
+#include <mbgl/util/feature.hpp>
+#include <mbgl/util/geometry.hpp>
+
+#include <QtCore/QtEndian>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// See https://github.com/mapbox/geobuf/blob/master/geobuf.proto for the
+// schema the field numbers below refer to.
+enum DataField {
+    DataKeys = 1,
+    DataDimensions = 2,
+    DataPrecision = 3,
+    DataFeatureCollection = 4,
+    DataFeature = 5,
+    DataGeometry = 6
+};
+
+enum FeatureField {
+    FeatureGeometry = 1,
+    FeatureId = 11,
+    FeatureIntId = 12,
+    FeatureValues = 13,
+    FeatureProperties = 14
+};
+
+enum GeometryField {
+    GeometryTypeField = 1,
+    GeometryLengths = 2,
+    GeometryCoords = 3,
+    GeometryGeometries = 4
+};
+
+enum GeometryType {
+    PointGeometry = 0,
+    MultiPointGeometry,
+    LineStringGeometry,
+    MultiLineStringGeometry,
+    PolygonGeometry,
+    MultiPolygonGeometry,
+    GeometryCollectionGeometry
+};
+
+enum ValueField {
+    StringValue = 1,
+    DoubleValue = 2,
+    PositiveIntValue = 3,
+    NegativeIntValue = 4,
+    BoolValue = 5,
+    JsonValue = 6
+};
+
+// Coordinates per position, more than x and y are read but ignored.
+constexpr std::uint64_t MinDimensions = 2;
+constexpr std::uint64_t MaxDimensions = 255;
+// Nesting of geometry collections, deeper input is rejected before it can
+// exhaust the stack.
+constexpr int MaxGeometryDepth = 64;
+
+enum WireType {
+    VarintWireType = 0,
+    Fixed64WireType = 1,
+    LengthWireType = 2,
+    Fixed32WireType = 5
+};
+
+// Protocol Buffers reader. Malformed input marks the reader as invalid and
+// ends iteration, so decoding can check once at the end.
+class Reader {
+public:
+    Reader(const char *data, std::size_t size, bool *valid)
+        : m_data(data),
+          m_end(data + size),
+          m_valid(valid) {}
+
+    bool next() {
+        if (m_data == m_end || !*m_valid) {
+            return false;
+        }
+        const std::uint64_t key = varint();
+        m_field = static_cast<int>(key >> 3);
+        m_wireType = static_cast<int>(key & 7);
+        return *m_valid;
+    }
+
+    [[nodiscard]] int field() const { return m_field; }
+
+    std::uint64_t varint() {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64 && m_data != m_end; shift += 7) {
+            const auto byte = static_cast<std::uint8_t>(*m_data++);
+            value |= std::uint64_t{byte & 0x7FU} << shift;
+            if ((byte & 0x80U) == 0) {
+                return value;
+            }
+        }
+        *m_valid = false;
+        return 0;
+    }
+
+    std::int64_t svarint() {
+        const std::uint64_t value = varint();
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+    double fixedDouble() {
+        if (m_wireType != Fixed64WireType || m_end - m_data < 8) {
+            *m_valid = false;
+            return 0;
+        }
+        const auto value = qFromLittleEndian<double>(m_data);
+        m_data += 8;
+        return value;
+    }
+
+    Reader message() {
+        const std::pair<const char *, std::size_t> bytes = lengthDelimited();
+        return {bytes.first, bytes.second, m_valid};
+    }
+
+    std::string string() {
+        const std::pair<const char *, std::size_t> bytes = lengthDelimited();
+        return {bytes.first, bytes.second};
+    }
+
+    template <typename Fn>
+    void packed(Fn &&fn) {
+        if (m_wireType != LengthWireType) {
+            fn(*this);
+            return;
+        }
+        Reader values = message();
+        while (values.m_data != values.m_end && *m_valid) {
+            fn(values);
+        }
+    }
+
+    void skip() {
+        switch (m_wireType) {
+            case VarintWireType:
+                varint();
+                break;
+            case Fixed64WireType:
+                advance(8);
+                break;
+            case LengthWireType:
+                lengthDelimited();
+                break;
+            case Fixed32WireType:
+                advance(4);
+                break;
+            default:
+                *m_valid = false;
+                break;
+        }
+    }
+
+private:
+    void advance(std::size_t size) {
+        if (static_cast<std::size_t>(m_end - m_data) < size) {
+            *m_valid = false;
+            m_data = m_end;
+            return;
+        }
+        m_data += size;
+    }
+
+    std::pair<const char *, std::size_t> lengthDelimited() {
+        if (m_wireType != LengthWireType) {
+            *m_valid = false;
+            return {m_data, 0};
+        }
+        const std::uint64_t size = varint();
+        const char *data = m_data;
+        advance(size);
+        return {data, *m_valid ? static_cast<std::size_t>(size) : 0};
+    }
+
+    const char *m_data;
+    const char *m_end;
+    bool *m_valid;
+    int m_field{};
+    int m_wireType{};
+};
+
+class Decoder {
+public:
+    explicit Decoder(bool *valid)
+        : m_valid(valid) {}
+
+    std::optional<mbgl::GeoJSON> decode(Reader data) {
+        std::optional<mbgl::GeoJSON> geojson;
+        while (data.next()) {
+            switch (data.field()) {
+                case DataKeys:
+                    m_keys.push_back(data.string());
+                    break;
+                case DataDimensions: {
+                    const std::uint64_t dimensions = data.varint();
+                    if (dimensions < MinDimensions || dimensions > MaxDimensions) {
+                        // Ends the loop, geometries need at least x and y.
+                        *m_valid = false;
+                        break;
+                    }
+                    m_dimensions = static_cast<std::size_t>(dimensions);
+                    break;
+                }
+                case DataPrecision:
+                    m_factor = std::pow(10.0, static_cast<double>(data.varint()));
+                    break;
+                case DataFeatureCollection:
+                    geojson = readFeatureCollection(data.message());
+                    break;
+                case DataFeature:
+                    geojson = readFeature(data.message());
+                    break;
+                case DataGeometry:
+                    geojson = readGeometry(data.message());
+                    break;
+                default:
+                    data.skip();
+                    break;
+            }
+        }
+
+        return geojson;
+    }
+
+private:
+    mbgl::FeatureCollection readFeatureCollection(Reader collection) {
+        mbgl::FeatureCollection features;
+        while (collection.next()) {
+            if (collection.field() == 1) {
+                features.emplace_back(readFeature(collection.message()));
+            } else {
+                collection.skip();
+            }
+        }
+        return features;
+    }
+
+    mbgl::GeoJSONFeature readFeature(Reader feature) {
+        mbgl::GeoJSONFeature mbglFeature;
+        std::vector<mbgl::Value> values;
+        std::vector<std::uint32_t> properties;
+
+        while (feature.next()) {
+            switch (feature.field()) {
+                case FeatureGeometry:
+                    mbglFeature.geometry = readGeometry(feature.message());
+                    break;
+                case FeatureId:
+                    mbglFeature.id = feature.string();
+                    break;
+                case FeatureIntId:
+                    mbglFeature.id = feature.svarint();
+                    break;
+                case FeatureValues:
+                    values.push_back(readValue(feature.message()));
+                    break;
+                case FeatureProperties:
+                    feature.packed([&properties](Reader &reader) {
+                        properties.push_back(static_cast<std::uint32_t>(reader.varint()));
+                    });
+                    break;
+                default:
+                    feature.skip();
+                    break;
+            }
+        }
+
+        // Pairs of key and value indices.
+        mbglFeature.properties.reserve(properties.size() / 2);
+        for (std::size_t i = 0; i + 1 < properties.size(); i += 2) {
+            if (properties[i] >= m_keys.size() || properties[i + 1] >= values.size()) {
+                *m_valid = false;
+                break;
+            }
+            mbglFeature.properties.emplace(m_keys[properties[i]], std::move(values[properties[i + 1]]));
+        }
+
+        return mbglFeature;
+    }
+
+    mbgl::Geometry<double> readGeometry(Reader geometry, int depth = 0) {
+        if (depth > MaxGeometryDepth) {
+            *m_valid = false;
+            return mapbox::geometry::empty{};
+        }
+
+        std::uint64_t type = PointGeometry;
+        std::vector<std::uint32_t> lengths;
+        std::vector<std::int64_t> coords;
+        mapbox::geometry::geometry_collection<double> geometries;
+
+        while (geometry.next()) {
+            switch (geometry.field()) {
+                case GeometryTypeField:
+                    type = geometry.varint();
+                    break;
+                case GeometryLengths:
+                    geometry.packed(
+                        [&lengths](Reader &reader) { lengths.push_back(static_cast<std::uint32_t>(reader.varint())); });
+                    break;
+                case GeometryCoords:
+                    geometry.packed([&coords](Reader &reader) { coords.push_back(reader.svarint()); });
+                    break;
+                case GeometryGeometries:
+                    geometries.emplace_back(readGeometry(geometry.message(), depth + 1));
+                    break;
+                default:
+                    geometry.skip();
+                    break;
+            }
+        }
+
+        if (!*m_valid) {
+            return mapbox::geometry::empty{};
+        }
+
+        m_coords = &coords;
+        switch (type) {
+            case PointGeometry:
+                if (coords.size() < m_dimensions) {
+                    return mapbox::geometry::empty{};
+                }
+                return mbgl::Point<double>{static_cast<double>(coords[0]) / m_factor,
+                                           static_cast<double>(coords[1]) / m_factor};
+            case MultiPointGeometry:
+                return line<mbgl::MultiPoint<double>>(0, coords.size(), false);
+            case LineStringGeometry:
+                return line<mbgl::LineString<double>>(0, coords.size(), false);
+            case MultiLineStringGeometry:
+                return lines<mbgl::MultiLineString<double>>(lengths, false);
+            case PolygonGeometry:
+                return lines<mbgl::Polygon<double>>(lengths, true);
+            case MultiPolygonGeometry:
+                return multiPolygon(lengths);
+            case GeometryCollectionGeometry:
+                return geometries;
+            default:
+                *m_valid = false;
+                return mapbox::geometry::empty{};
+        }
+    }
+
+    // Coordinates are delta encoded per line. Closed rings are stored without
+    // repeating the first point at the end.
+    template <typename Line>
+    Line line(std::size_t begin, std::size_t end, bool closed) {
+        Line result;
+        if (end > m_coords->size() || begin > end) {
+            *m_valid = false;
+            return result;
+        }
+
+        result.reserve((end - begin) / m_dimensions + (closed ? 1 : 0));
+        std::int64_t x = 0;
+        std::int64_t y = 0;
+        for (std::size_t i = begin; i + m_dimensions <= end; i += m_dimensions) {
+            x += (*m_coords)[i];
+            y += (*m_coords)[i + 1];
+            result.emplace_back(static_cast<double>(x) / m_factor, static_cast<double>(y) / m_factor);
+        }
+        if (closed && !result.empty()) {
+            result.push_back(result.front());
+        }
+        return result;
+    }
+
+    template <typename Lines>
+    Lines lines(const std::vector<std::uint32_t> &lengths, bool closed) {
+        using Line = typename Lines::value_type;
+
+        Lines result;
+        if (lengths.empty()) {
+            result.push_back(line<Line>(0, m_coords->size(), closed));
+            return result;
+        }
+
+        std::size_t end = 0;
+        for (const std::uint32_t length : lengths) {
+            const std::size_t begin = end;
+            end = begin + length * m_dimensions;
+            result.push_back(line<Line>(begin, end, closed));
+        }
+        return result;
+    }
+
+    // Lengths hold the number of polygons, then for each polygon the number of
+    // rings followed by the length of each ring.
+    mbgl::MultiPolygon<double> multiPolygon(const std::vector<std::uint32_t> &lengths) {
+        mbgl::MultiPolygon<double> result;
+        if (lengths.empty()) {
+            result.push_back({line<mbgl::LinearRing<double>>(0, m_coords->size(), true)});
+            return result;
+        }
+
+        std::size_t index = 1;
+        std::size_t end = 0;
+        for (std::uint32_t polygon = 0; polygon < lengths[0] && index < lengths.size(); ++polygon) {
+            const std::uint32_t ringCount = lengths[index++];
+            mbgl::Polygon<double> rings;
+            for (std::uint32_t ring = 0; ring < ringCount && index < lengths.size(); ++ring) {
+                const std::size_t begin = end;
+                end = begin + lengths[index++] * m_dimensions;
+                rings.push_back(line<mbgl::LinearRing<double>>(begin, end, true));
+            }
+            result.push_back(std::move(rings));
+        }
+        return result;
+    }
+
+    static mbgl::Value readValue(Reader value) {
+        mbgl::Value result;
+        while (value.next()) {
+            switch (value.field()) {
+                case StringValue:
+                case JsonValue:
+                    result = value.string();
+                    break;
+                case DoubleValue:
+                    result = value.fixedDouble();
+                    break;
+                case PositiveIntValue:
+                    result = value.varint();
+                    break;
+                case NegativeIntValue:
+                    result = -static_cast<std::int64_t>(value.varint());
+                    break;
+                case BoolValue:
+                    result = value.varint() != 0;
+                    break;
+                default:
+                    value.skip();
+                    break;
+            }
+        }
+        return result;
+    }
+
+    bool *m_valid;
+    std::vector<std::string> m_keys;
+    std::size_t m_dimensions{2};
+    double m_factor{1e6};
+    const std::vector<std::int64_t> *m_coords{};
+};
+
+} // namespace
+
+namespace QMapLibre::Geobuf {
+
+bool isGeobuf(const char *data, std::size_t size) {
+    const char *end = data + size;
+    const char *text = std::find_if(data, end, [](char c) { return c != ' ' && c != '\t' && c != '\n' && c != '\r'; });
+    if (text == end || *text == '{') {
+        return false;
+    }
+
+    // The first key of the Data message, a field it has with its wire type.
+    // Keys and whitespace share the byte 0x0A, hence the check above first.
+    const auto key = static_cast<std::uint8_t>(data[0]);
+    const int wireType = key & 7;
+    switch (key >> 3) {
+        case DataKeys:
+        case DataFeatureCollection:
+        case DataFeature:
+        case DataGeometry:
+            return wireType == LengthWireType;
+        case DataDimensions:
+        case DataPrecision:
+            return wireType == VarintWireType;
+        default:
+            return false;
+    }
+}
+
+std::optional<mbgl::GeoJSON> decode(const char *data, std::size_t size, std::string &error) {
+    bool valid = true;
+    Decoder decoder(&valid);
+    std::optional<mbgl::GeoJSON> geojson = decoder.decode(Reader(data, size, &valid));
+    if (!valid || !geojson) {
+        error = "invalid Geobuf data";
+        return {};
+    }
+
+    return geojson;
+}
+
+} // namespace QMapLibre::Geobuf
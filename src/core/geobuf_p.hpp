@@ -0,0 +1,27 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include <mbgl/util/geojson.hpp>
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+namespace QMapLibre::Geobuf {
+
+/*! \cond PRIVATE */
+
+// Geobuf has no magic bytes. GeoJSON text always starts with an object after
+// optional whitespace, other data is taken to be Geobuf if it starts with a
+// key of the top level message.
+bool isGeobuf(const char *data, std::size_t size);
+
+// Decodes Geobuf data into a feature collection, feature or geometry.
+std::optional<mbgl::GeoJSON> decode(const char *data, std::size_t size, std::string &error);
+
+/*! \endcond */
+
+} // namespace QMapLibre::Geobuf
@@ -7,8 +7,228 @@
 
 #include <QtCore/QDebug>
 
+#include <array>
+#include <vector>
+
+namespace {
+
+bool checkOffsets(const QVector<qsizetype> &offsets, qsizetype count, const char *name, std::string &error) {
+    if (offsets.isEmpty()) {
+        error = std::string(name) + " must hold at least one offset";
+        return false;
+    }
+
+    if (offsets.first() < 0 || offsets.last() > count) {
+        error = std::string(name) + " are out of range";
+        return false;
+    }
+
+    for (qsizetype i = 1; i < offsets.size(); ++i) {
+        if (offsets[i] < offsets[i - 1]) {
+            error = std::string(name) + " must not decrease";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+mbgl::Value columnValue(const QMapLibre::PropertyColumn &column, qsizetype index) {
+    switch (column.type) {
+        case QMapLibre::PropertyColumn::BoolType:
+            return {column.bools[index]};
+        case QMapLibre::PropertyColumn::IntegerType:
+            return {static_cast<int64_t>(column.integers[index])};
+        case QMapLibre::PropertyColumn::DoubleType:
+            return {column.doubles[index]};
+        case QMapLibre::PropertyColumn::StringType:
+            return {column.strings[index].toStdString()};
+    }
+
+    return {};
+}
+
+mbgl::FeatureIdentifier columnIdentifier(const QMapLibre::PropertyColumn &column, qsizetype index) {
+    switch (column.type) {
+        case QMapLibre::PropertyColumn::IntegerType:
+            return {static_cast<int64_t>(column.integers[index])};
+        case QMapLibre::PropertyColumn::DoubleType:
+            return {column.doubles[index]};
+        case QMapLibre::PropertyColumn::StringType:
+            return {column.strings[index].toStdString()};
+        case QMapLibre::PropertyColumn::BoolType:
+            break;
+    }
+
+    return {};
+}
+
+} // namespace
+
 namespace QMapLibre::GeoJSON {
 
+namespace {
+
+// Builds all features in one pass, independent of how the points are stored.
+template <typename PointFunction>
+std::optional<mbgl::FeatureCollection> buildFeatureCollection(Feature::Type type,
+                                                              qsizetype pointCount,
+                                                              PointFunction point,
+                                                              const QVector<qsizetype> &featureOffsets,
+                                                              const QVector<qsizetype> &partOffsets,
+                                                              const QVector<qsizetype> &ringOffsets,
+                                                              const QVector<PropertyColumn> &properties,
+                                                              const PropertyColumn &ids,
+                                                              std::string &error) {
+    switch (type) {
+        case Feature::PointType:
+            if (!checkOffsets(featureOffsets, pointCount, "feature offsets", error)) {
+                return {};
+            }
+            break;
+        case Feature::LineStringType:
+            if (!checkOffsets(ringOffsets, pointCount, "ring offsets", error) ||
+                !checkOffsets(featureOffsets, ringOffsets.size() - 1, "feature offsets", error)) {
+                return {};
+            }
+            break;
+        case Feature::PolygonType:
+            if (!checkOffsets(ringOffsets, pointCount, "ring offsets", error) ||
+                !checkOffsets(partOffsets, ringOffsets.size() - 1, "part offsets", error) ||
+                !checkOffsets(featureOffsets, partOffsets.size() - 1, "feature offsets", error)) {
+                return {};
+            }
+            break;
+        default:
+            error = "unsupported feature type";
+            return {};
+    }
+
+    const qsizetype featureCount = featureOffsets.size() - 1;
+
+    std::vector<std::string> keys;
+    keys.reserve(static_cast<std::size_t>(properties.size()));
+    for (const PropertyColumn &column : properties) {
+        if (column.size() != featureCount) {
+            error = "property column " + column.name.toStdString() + " does not hold a value for each feature";
+            return {};
+        }
+        keys.emplace_back(column.name.toStdString());
+    }
+
+    if (ids.size() != 0 && (ids.size() != featureCount || ids.type == PropertyColumn::BoolType)) {
+        error = "identifiers must be numbers or strings, one for each feature";
+        return {};
+    }
+
+    // Sized up front so the conversion loop can be vectorized.
+    const auto points = [&point](auto &geometry, qsizetype begin, qsizetype end) {
+        geometry.resize(static_cast<std::size_t>(end - begin));
+        for (qsizetype i = begin; i < end; ++i) {
+            geometry[static_cast<std::size_t>(i - begin)] = point(i);
+        }
+    };
+    const auto polygon = [&](qsizetype part) {
+        mbgl::Polygon<double> mbglPolygon;
+        mbglPolygon.reserve(static_cast<std::size_t>(partOffsets[part + 1] - partOffsets[part]));
+        for (qsizetype ring = partOffsets[part]; ring < partOffsets[part + 1]; ++ring) {
+            mbgl::LinearRing<double> mbglLinearRing;
+            points(mbglLinearRing, ringOffsets[ring], ringOffsets[ring + 1]);
+            mbglPolygon.emplace_back(std::move(mbglLinearRing));
+        }
+        return mbglPolygon;
+    };
+
+    mbgl::FeatureCollection collection;
+    collection.reserve(static_cast<std::size_t>(featureCount));
+    for (qsizetype feature = 0; feature < featureCount; ++feature) {
+        mbgl::PropertyMap mbglProperties;
+        mbglProperties.reserve(keys.size());
+        for (qsizetype column = 0; column < properties.size(); ++column) {
+            mbglProperties.emplace(keys[static_cast<std::size_t>(column)], columnValue(properties[column], feature));
+        }
+
+        const qsizetype begin = featureOffsets[feature];
+        const qsizetype end = featureOffsets[feature + 1];
+
+        mbgl::Geometry<double> geometry;
+        if (type == Feature::PointType) {
+            if (end - begin == 1) {
+                geometry = point(begin);
+            } else {
+                mbgl::MultiPoint<double> multiPoint;
+                points(multiPoint, begin, end);
+                geometry = std::move(multiPoint);
+            }
+        } else if (type == Feature::LineStringType) {
+            if (end - begin == 1) {
+                mbgl::LineString<double> lineString;
+                points(lineString, ringOffsets[begin], ringOffsets[begin + 1]);
+                geometry = std::move(lineString);
+            } else {
+                mbgl::MultiLineString<double> multiLineString;
+                multiLineString.reserve(static_cast<std::size_t>(end - begin));
+                for (qsizetype ring = begin; ring < end; ++ring) {
+                    mbgl::LineString<double> lineString;
+                    points(lineString, ringOffsets[ring], ringOffsets[ring + 1]);
+                    multiLineString.emplace_back(std::move(lineString));
+                }
+                geometry = std::move(multiLineString);
+            }
+        } else {
+            if (end - begin == 1) {
+                geometry = polygon(begin);
+            } else {
+                mbgl::MultiPolygon<double> multiPolygon;
+                multiPolygon.reserve(static_cast<std::size_t>(end - begin));
+                for (qsizetype part = begin; part < end; ++part) {
+                    multiPolygon.emplace_back(polygon(part));
+                }
+                geometry = std::move(multiPolygon);
+            }
+        }
+
+        collection.emplace_back(std::move(geometry),
+                                std::move(mbglProperties),
+                                ids.size() != 0 ? columnIdentifier(ids, feature) : mbgl::FeatureIdentifier());
+    }
+
+    return collection;
+}
+
+// Longitude and latitude pairs in one buffer, converted to degrees by
+// toDegrees on the fly.
+template <typename T, typename ToDegrees>
+std::optional<mbgl::FeatureCollection> interleavedFeatureCollection(Feature::Type type,
+                                                                    const QVector<T> &coordinates,
+                                                                    ToDegrees toDegrees,
+                                                                    const QVector<qsizetype> &featureOffsets,
+                                                                    const QVector<qsizetype> &partOffsets,
+                                                                    const QVector<qsizetype> &ringOffsets,
+                                                                    const QVector<PropertyColumn> &properties,
+                                                                    std::string &error) {
+    if (coordinates.size() % 2 != 0) {
+        error = "coordinates must hold longitude and latitude pairs";
+        return {};
+    }
+
+    const T *data = coordinates.constData();
+    return buildFeatureCollection(
+        type,
+        coordinates.size() / 2,
+        [data, toDegrees](qsizetype index) {
+            return mbgl::Point<double>{toDegrees(data[2 * index], 0), toDegrees(data[2 * index + 1], 1)};
+        },
+        featureOffsets,
+        partOffsets,
+        ringOffsets,
+        properties,
+        PropertyColumn(),
+        error);
+}
+
+} // namespace
+
 mbgl::Point<double> asPoint(const Coordinate &coordinate) {
     return mbgl::Point<double>{coordinate.second, coordinate.first};
 }
@@ -63,54 +283,116 @@ mbgl::MultiPolygon<double> asMultiPolygon(const CoordinatesCollections &multiPol
     return mbglMultiPolygon;
 };
 
-mbgl::Value asPropertyValue(const QVariant &value) {
-    auto valueList = [](const QVariantList &list) {
-        std::vector<mbgl::Value> mbglList;
-        mbglList.reserve(list.size());
-        for (const auto &listValue : list) {
-            mbglList.emplace_back(asPropertyValue(listValue));
-        }
-        return mbglList;
-    };
+mbgl::PropertyMap PropertyConverter::properties(const QVariantMap &properties) {
+    // Only dropped between features, keys of nested maps are looked up while
+    // references to the outer ones are still held.
+    if (m_keys.size() >= MaxKeyCount) {
+        m_keys.clear();
+    }
 
-    auto valueMap = [](const QVariantMap &map) {
-        std::unordered_map<std::string, mbgl::Value> mbglMap;
-        mbglMap.reserve(map.size());
-        for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
-            mbglMap.emplace(it.key().toStdString(), asPropertyValue(it.value()));
-        }
-        return mbglMap;
-    };
+    mbgl::PropertyMap mbglProperties;
+    mbglProperties.reserve(static_cast<std::size_t>(properties.size()));
+    for (auto it = properties.constBegin(); it != properties.constEnd(); ++it) {
+        mbglProperties.emplace(key(it.key()), value(it.value()));
+    }
+    return mbglProperties;
+}
 
+// Containers and strings are read in place, without copying the QVariant
+// contents first.
+mbgl::Value PropertyConverter::value(const QVariant &value) {
     switch (value.typeId()) {
         case QMetaType::UnknownType:
+        case QMetaType::Nullptr:
             return mbgl::NullValue{};
         case QMetaType::Bool:
             return {value.toBool()};
-        case QMetaType::ULongLong:
-            return {static_cast<uint64_t>(value.toULongLong())};
+        case QMetaType::Char:
+        case QMetaType::SChar:
+        case QMetaType::Short:
+        case QMetaType::Int:
+        case QMetaType::Long:
         case QMetaType::LongLong:
             return {static_cast<int64_t>(value.toLongLong())};
+        case QMetaType::UChar:
+        case QMetaType::UShort:
+        case QMetaType::UInt:
+        case QMetaType::ULong:
+        case QMetaType::ULongLong:
+            return {static_cast<uint64_t>(value.toULongLong())};
+        case QMetaType::Float:
         case QMetaType::Double:
             return {value.toDouble()};
         case QMetaType::QString:
-            return {value.toString().toStdString()};
-        case QMetaType::QVariantList:
-            return valueList(value.toList());
-        case QMetaType::QVariantMap:
-            return valueMap(value.toMap());
+            return {string(*static_cast<const QString *>(value.constData()))};
+        case QMetaType::QStringList: {
+            const auto &list = *static_cast<const QStringList *>(value.constData());
+            std::vector<mbgl::Value> mbglList;
+            mbglList.reserve(static_cast<std::size_t>(list.size()));
+            for (const QString &item : list) {
+                mbglList.emplace_back(string(item));
+            }
+            return mbglList;
+        }
+        case QMetaType::QVariantList: {
+            const auto &list = *static_cast<const QVariantList *>(value.constData());
+            std::vector<mbgl::Value> mbglList;
+            mbglList.reserve(static_cast<std::size_t>(list.size()));
+            for (const QVariant &item : list) {
+                mbglList.emplace_back(this->value(item));
+            }
+            return mbglList;
+        }
+        case QMetaType::QVariantMap: {
+            const auto &map = *static_cast<const QVariantMap *>(value.constData());
+            std::unordered_map<std::string, mbgl::Value> mbglMap;
+            mbglMap.reserve(static_cast<std::size_t>(map.size()));
+            for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+                mbglMap.emplace(key(it.key()), this->value(it.value()));
+            }
+            return mbglMap;
+        }
+        case QMetaType::QVariantHash: {
+            const auto &hash = *static_cast<const QVariantHash *>(value.constData());
+            std::unordered_map<std::string, mbgl::Value> mbglMap;
+            mbglMap.reserve(static_cast<std::size_t>(hash.size()));
+            for (auto it = hash.constBegin(); it != hash.constEnd(); ++it) {
+                mbglMap.emplace(key(it.key()), this->value(it.value()));
+            }
+            return mbglMap;
+        }
         default:
             qWarning() << "Unsupported feature property value:" << value;
             return {};
     }
 }
 
+const std::string &PropertyConverter::key(const QString &key) {
+    auto it = m_keys.find(key);
+    if (it == m_keys.end()) {
+        it = m_keys.emplace(key, string(key)).first;
+    }
+    return it->second;
+}
+
+std::string PropertyConverter::string(QStringView text) {
+    m_buffer.resize(m_encoder.requiredSpace(text.size()));
+    const char *end = m_encoder.appendToBuffer(m_buffer.data(), text);
+    return {m_buffer.constData(), static_cast<std::size_t>(end - m_buffer.constData())};
+}
+
+mbgl::Value asPropertyValue(const QVariant &value) {
+    return PropertyConverter().value(value);
+}
+
 mbgl::FeatureIdentifier asFeatureIdentifier(const QVariant &id) {
     switch (id.typeId()) {
         case QMetaType::UnknownType:
             return {};
+        case QMetaType::UInt:
         case QMetaType::ULongLong:
             return {static_cast<uint64_t>(id.toULongLong())};
+        case QMetaType::Int:
         case QMetaType::LongLong:
             return {static_cast<int64_t>(id.toLongLong())};
         case QMetaType::Double:
@@ -124,12 +406,12 @@ mbgl::FeatureIdentifier asFeatureIdentifier(const QVariant &id) {
 }
 
 mbgl::GeoJSONFeature asFeature(const Feature &feature) {
-    mbgl::PropertyMap properties;
-    properties.reserve(feature.properties.size());
-    for (auto it = feature.properties.constBegin(); it != feature.properties.constEnd(); ++it) {
-        properties.emplace(std::make_pair(it.key().toStdString(), asPropertyValue(it.value())));
-    }
+    PropertyConverter converter;
+    return asFeature(feature, converter);
+}
 
+mbgl::GeoJSONFeature asFeature(const Feature &feature, PropertyConverter &converter) {
+    mbgl::PropertyMap properties = converter.properties(feature.properties);
     mbgl::FeatureIdentifier id = asFeatureIdentifier(feature.id);
 
     if (feature.type == Feature::PointType) {
@@ -159,4 +441,133 @@ mbgl::GeoJSONFeature asFeature(const Feature &feature) {
     throw std::runtime_error("Unsupported feature type");
 };
 
+std::optional<mbgl::FeatureCollection> asFeatureCollection(Feature::Type type,
+                                                           const QVector<double> &coordinates,
+                                                           const QVector<qsizetype> &featureOffsets,
+                                                           const QVector<qsizetype> &partOffsets,
+                                                           const QVector<qsizetype> &ringOffsets,
+                                                           const QVector<PropertyColumn> &properties,
+                                                           std::string &error) {
+    return interleavedFeatureCollection(
+        type,
+        coordinates,
+        [](double value, int /* axis */) { return value; },
+        featureOffsets,
+        partOffsets,
+        ringOffsets,
+        properties,
+        error);
+}
+
+std::optional<mbgl::FeatureCollection> asFeatureCollection(Feature::Type type,
+                                                           const QVector<float> &coordinates,
+                                                           const QVector<qsizetype> &featureOffsets,
+                                                           const QVector<qsizetype> &partOffsets,
+                                                           const QVector<qsizetype> &ringOffsets,
+                                                           const QVector<PropertyColumn> &properties,
+                                                           std::string &error) {
+    return interleavedFeatureCollection(
+        type,
+        coordinates,
+        [](float value, int /* axis */) { return static_cast<double>(value); },
+        featureOffsets,
+        partOffsets,
+        ringOffsets,
+        properties,
+        error);
+}
+
+std::optional<mbgl::FeatureCollection> asFeatureCollection(Feature::Type type,
+                                                           const QVector<qint32> &coordinates,
+                                                           const CoordinateQuantization &quantization,
+                                                           const QVector<qsizetype> &featureOffsets,
+                                                           const QVector<qsizetype> &partOffsets,
+                                                           const QVector<qsizetype> &ringOffsets,
+                                                           const QVector<PropertyColumn> &properties,
+                                                           std::string &error) {
+    if (!(quantization.resolution > 0)) {
+        error = "quantization resolution must be positive";
+        return {};
+    }
+
+    const std::array<double, 2> origin{quantization.origin.second, quantization.origin.first};
+    const double resolution = quantization.resolution;
+    return interleavedFeatureCollection(
+        type,
+        coordinates,
+        [origin, resolution](qint32 value, int axis) {
+            return origin[static_cast<std::size_t>(axis)] + resolution * static_cast<double>(value);
+        },
+        featureOffsets,
+        partOffsets,
+        ringOffsets,
+        properties,
+        error);
+}
+
+std::optional<mbgl::FeatureCollection> asFeatureCollection(const FeatureBatch &batch, std::string &error) {
+    if (batch.longitudes.size() != batch.latitudes.size()) {
+        error = "longitudes and latitudes must have the same size";
+        return {};
+    }
+
+    const double *longitudes = batch.longitudes.constData();
+    const double *latitudes = batch.latitudes.constData();
+    return buildFeatureCollection(
+        batch.type,
+        batch.longitudes.size(),
+        [longitudes, latitudes](qsizetype index) { return mbgl::Point<double>{longitudes[index], latitudes[index]}; },
+        batch.featureOffsets,
+        batch.partOffsets,
+        batch.ringOffsets,
+        batch.properties,
+        batch.ids,
+        error);
+}
+
+bool FeatureSet::add(const Feature &feature) {
+    mbgl::GeoJSONFeature mbglFeature = asFeature(feature, m_converter);
+    if (mbglFeature.id.is<mbgl::NullValue>()) {
+        return false;
+    }
+
+    const auto [it, inserted] = m_index.try_emplace(mbglFeature.id, m_features.size());
+    if (inserted) {
+        m_features.emplace_back(std::move(mbglFeature));
+    } else {
+        m_features[it->second] = std::move(mbglFeature);
+    }
+
+    return true;
+}
+
+bool FeatureSet::update(const Feature &feature) {
+    mbgl::GeoJSONFeature mbglFeature = asFeature(feature, m_converter);
+    const auto it = m_index.find(mbglFeature.id);
+    if (it == m_index.end()) {
+        return false;
+    }
+
+    m_features[it->second] = std::move(mbglFeature);
+    return true;
+}
+
+bool FeatureSet::remove(const QVariant &id) {
+    const auto it = m_index.find(asFeatureIdentifier(id));
+    if (it == m_index.end()) {
+        return false;
+    }
+
+    // Move the last feature into the gap to keep removal constant time.
+    const std::size_t index = it->second;
+    m_index.erase(it);
+    if (index != m_features.size() - 1) {
+        m_features[index] = std::move(m_features.back());
+        m_index[m_features[index].id] = index;
+    }
+    m_features.pop_back();
+
+    return true;
+}
+
 } // namespace QMapLibre::GeoJSON
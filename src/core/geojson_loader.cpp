@@ -0,0 +1,311 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "geojson_loader_p.hpp"
+#include "flatgeobuf_p.hpp"
+#include "geobuf_p.hpp"
+
+#include <mbgl/style/conversion/geojson.hpp>
+#include <mbgl/style/conversion_impl.hpp>
+#include <mbgl/style/rapidjson_conversion.hpp>
+#include <mbgl/util/rapidjson.hpp>
+
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QIODevice>
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+namespace {
+
+constexpr qint64 ChunkSize = 256 * 1024;
+// Enough to tell binary formats apart from GeoJSON text.
+constexpr qint64 MagicSize = 8;
+constexpr qint64 ProgressInterval = 4 * 1024 * 1024;
+
+// RapidJSON input stream reading a QIODevice in chunks, or a memory mapped
+// file in windows of the same size. Cancellation and progress are checked
+// once per chunk, a cancelled stream ends early and fails the parser.
+class InputStream {
+public:
+    using Ch = char;
+
+    InputStream(QIODevice &device, const std::atomic<bool> &cancelled, std::function<void(qint64)> progress)
+        : m_device(device),
+          m_cancelled(cancelled),
+          m_progress(std::move(progress)) {
+        if (auto *file = qobject_cast<QFile *>(&device)) {
+            m_mappedSize = file->size();
+            if (m_mappedSize > 0) {
+                m_mapped = reinterpret_cast<const char *>(file->map(0, m_mappedSize));
+            }
+        }
+
+        if (m_mapped == nullptr) {
+            m_buffer.resize(ChunkSize);
+        }
+    }
+
+    Ch Peek() { return m_pos != m_end || next() ? *m_pos : '\0'; }
+    Ch Take() {
+        const Ch c = Peek();
+        if (m_pos != m_end) {
+            ++m_pos;
+        }
+        return c;
+    }
+    [[nodiscard]] std::size_t Tell() const { return static_cast<std::size_t>(m_offset + (m_pos - m_begin)); }
+
+    // Only used for in situ parsing.
+    Ch *PutBegin() {
+        Q_ASSERT(false);
+        return nullptr;
+    }
+    void Put(Ch /* c */) { Q_ASSERT(false); }
+    void Flush() { Q_ASSERT(false); }
+    std::size_t PutEnd(Ch * /* begin */) {
+        Q_ASSERT(false);
+        return 0;
+    }
+
+    [[nodiscard]] qint64 bytesRead() const { return m_offset + (m_pos - m_begin); }
+
+private:
+    bool next() {
+        m_offset += m_end - m_begin;
+        m_begin = m_end;
+        m_pos = m_end;
+
+        if (m_cancelled.load(std::memory_order_relaxed)) {
+            return false;
+        }
+
+        qint64 size = 0;
+        if (m_mapped != nullptr) {
+            size = std::min(ChunkSize, m_mappedSize - m_offset);
+            m_begin = m_mapped + m_offset;
+        } else {
+            size = m_device.read(m_buffer.data(), ChunkSize);
+            m_begin = m_buffer.constData();
+        }
+
+        if (size <= 0) {
+            m_begin = m_end;
+            return false;
+        }
+
+        m_end = m_begin + size;
+        m_pos = m_begin;
+
+        if (m_offset - m_reported >= ProgressInterval) {
+            m_reported = m_offset;
+            m_progress(m_offset);
+        }
+
+        return true;
+    }
+
+    QIODevice &m_device;
+    const std::atomic<bool> &m_cancelled;
+    std::function<void(qint64)> m_progress;
+
+    const char *m_mapped{};
+    qint64 m_mappedSize{};
+    QByteArray m_buffer;
+
+    const char *m_begin{};
+    const char *m_end{};
+    const char *m_pos{};
+    qint64 m_offset{};
+    qint64 m_reported{};
+};
+
+} // namespace
+
+namespace QMapLibre {
+
+/*! \cond PRIVATE */
+
+struct GeoJSONLoader::Job : std::enable_shared_from_this<Job> {
+    QString id;
+    std::atomic<bool> cancelled{false};
+
+    // Written by the worker before finish() is queued.
+    std::optional<mbgl::GeoJSON> geojson;
+    std::shared_ptr<mbgl::style::GeoJSONData> data;
+    QString error;
+};
+
+GeoJSONLoader::GeoJSONLoader(ApplyFunction apply, PrepareFunction prepare, QObject *parent)
+    : QObject(parent),
+      m_apply(std::move(apply)),
+      m_prepare(std::move(prepare)) {}
+
+GeoJSONLoader::~GeoJSONLoader() {
+    for (const auto &job : std::as_const(m_jobs)) {
+        job->cancelled = true;
+    }
+    m_pool.waitForDone();
+}
+
+void GeoJSONLoader::load(const QString &id,
+                         const QString &path,
+                         const std::optional<mapbox::geometry::box<double>> &bounds) {
+    start(id, [this, path, bounds](Job &job) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            job.error = file.errorString();
+            return;
+        }
+
+        parse(job, file, bounds);
+    });
+}
+
+void GeoJSONLoader::load(const QString &id, QIODevice *device) {
+    if (device == nullptr || !device->isReadable()) {
+        qWarning() << "Unable to load GeoJSON for source" << id << ": device is not readable.";
+
+        // Supersedes the load in flight and fails later, like any other load.
+        cancel(id);
+        QMetaObject::invokeMethod(
+            this, [this, id] { emit failed(id, QStringLiteral("device is not readable")); }, Qt::QueuedConnection);
+        return;
+    }
+
+    start(id, [this, device](Job &job) { parse(job, *device, std::nullopt); });
+}
+
+void GeoJSONLoader::cancel(const QString &id) {
+    const std::shared_ptr<Job> job = m_jobs.take(id);
+    if (job) {
+        job->cancelled = true;
+    }
+}
+
+void GeoJSONLoader::start(const QString &id, std::function<void(Job &)> run) {
+    cancel(id);
+
+    auto job = std::make_shared<Job>();
+    job->id = id;
+    m_jobs.insert(id, job);
+
+    m_pool.start([this, job, run = std::move(run), index = m_prepare(id)] {
+        run(*job);
+        // Tiling large data takes long as well, it is done here instead of
+        // on the loader thread when the source gets the data.
+        if (job->geojson && !job->cancelled) {
+            job->data = index(std::move(*job->geojson));
+            job->geojson.reset();
+        }
+        QMetaObject::invokeMethod(this, [this, job] { finish(job); }, Qt::QueuedConnection);
+    });
+}
+
+void GeoJSONLoader::finish(const std::shared_ptr<Job> &job) {
+    // Cancelled or superseded by a newer load.
+    if (m_jobs.value(job->id) != job) {
+        return;
+    }
+    m_jobs.remove(job->id);
+
+    if (!job->data) {
+        emit failed(job->id, job->error);
+        return;
+    }
+
+    if (!m_apply(job->id, std::move(job->data))) {
+        emit failed(job->id, QStringLiteral("not a GeoJSON source"));
+        return;
+    }
+
+    emit loaded(job->id);
+}
+
+// Progress is reported on the loader thread, and dropped once the job is
+// cancelled or superseded as its result would be.
+void GeoJSONLoader::reportProgress(Job &job, qint64 bytesRead, qint64 bytesTotal) {
+    QMetaObject::invokeMethod(
+        this,
+        [this, job = job.shared_from_this(), bytesRead, bytesTotal] {
+            if (m_jobs.value(job->id) == job) {
+                emit progress(job->id, bytesRead, bytesTotal);
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+void GeoJSONLoader::parse(Job &job, QIODevice &device, const std::optional<mapbox::geometry::box<double>> &bounds) {
+    const QByteArray head = device.peek(MagicSize);
+    if (QMapLibre::FlatGeobuf::isFlatGeobuf(head.constData(), static_cast<std::size_t>(head.size())) ||
+        QMapLibre::Geobuf::isGeobuf(head.constData(), static_cast<std::size_t>(head.size()))) {
+        decode(job, device, bounds);
+        return;
+    }
+
+    const qint64 bytesTotal = device.isSequential() ? -1 : device.size();
+    InputStream stream(device, job.cancelled, [this, &job, bytesTotal](qint64 bytesRead) {
+        reportProgress(job, bytesRead, bytesTotal);
+    });
+
+    mbgl::JSDocument document;
+    document.ParseStream(stream);
+    if (job.cancelled) {
+        return;
+    }
+
+    reportProgress(job, stream.bytesRead(), bytesTotal);
+
+    if (document.HasParseError()) {
+        job.error = QStringLiteral("JSON parse error at offset %1").arg(document.GetErrorOffset());
+        return;
+    }
+
+    mbgl::style::conversion::Error error;
+    const mbgl::JSValue *value = &document;
+    job.geojson = mbgl::style::conversion::convert<mbgl::GeoJSON>(mbgl::style::conversion::Convertible(value), error);
+    if (!job.geojson) {
+        job.error = QString::fromStdString(error.message);
+    }
+}
+
+// Binary formats are decoded from one block of memory, the mapped file if
+// possible.
+void GeoJSONLoader::decode(Job &job, QIODevice &device, const std::optional<mapbox::geometry::box<double>> &bounds) {
+    QByteArray buffer;
+    const char *data = nullptr;
+    qint64 size = 0;
+    if (auto *file = qobject_cast<QFile *>(&device)) {
+        size = file->size();
+        data = reinterpret_cast<const char *>(file->map(0, size));
+    }
+    if (data == nullptr) {
+        buffer = device.readAll();
+        data = buffer.constData();
+        size = buffer.size();
+    }
+
+    if (job.cancelled) {
+        return;
+    }
+
+    reportProgress(job, size, device.isSequential() ? -1 : device.size());
+
+    std::string error;
+    if (QMapLibre::FlatGeobuf::isFlatGeobuf(data, static_cast<std::size_t>(size))) {
+        job.geojson = QMapLibre::FlatGeobuf::decode(data, static_cast<std::size_t>(size), bounds, error);
+    } else {
+        job.geojson = QMapLibre::Geobuf::decode(data, static_cast<std::size_t>(size), error);
+    }
+
+    if (!job.geojson) {
+        job.error = QString::fromStdString(error);
+    }
+}
+
+/*! \endcond */
+
+} // namespace QMapLibre
@@ -0,0 +1,81 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include <mapbox/geometry/box.hpp>
+#include <mbgl/style/sources/geojson_source.hpp>
+#include <mbgl/util/geojson.hpp>
+
+#include <QtCore/QHash>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtCore/QThreadPool>
+
+#include <functional>
+#include <memory>
+#include <optional>
+
+QT_BEGIN_NAMESPACE
+class QIODevice;
+QT_END_NAMESPACE
+
+namespace QMapLibre {
+
+/*! \cond PRIVATE */
+
+// Reads, parses and indexes GeoJSON on worker threads and hands the result to
+// the apply function on the thread the loader lives in. Files are memory
+// mapped when possible, everything else is streamed into the parser in chunks.
+// FlatGeobuf and Geobuf data is detected and decoded directly.
+class GeoJSONLoader : public QObject {
+    Q_OBJECT
+
+public:
+    using Index = std::function<std::shared_ptr<mbgl::style::GeoJSONData>(mbgl::GeoJSON geojson)>;
+    // Returns false if the data could not be applied to the source.
+    using ApplyFunction = std::function<bool(const QString &id, std::shared_ptr<mbgl::style::GeoJSONData> data)>;
+    // Called when a load starts, returns the function building the source
+    // data from the parsed GeoJSON on the worker thread.
+    using PrepareFunction = std::function<Index(const QString &id)>;
+
+    GeoJSONLoader(ApplyFunction apply, PrepareFunction prepare, QObject *parent = nullptr);
+    ~GeoJSONLoader() override;
+
+    // A new load for the same id supersedes the one in flight. Bounds only
+    // apply to FlatGeobuf data.
+    void load(const QString &id,
+              const QString &path,
+              const std::optional<mapbox::geometry::box<double>> &bounds = std::nullopt);
+    void load(const QString &id, QIODevice *device);
+    void cancel(const QString &id);
+
+    [[nodiscard]] bool isLoading(const QString &id) const { return m_jobs.contains(id); }
+
+signals:
+    // Only emitted for the current load of the id, like the other signals.
+    void progress(const QString &id, qint64 bytesRead, qint64 bytesTotal);
+    void loaded(const QString &id);
+    void failed(const QString &id, const QString &error);
+
+private:
+    Q_DISABLE_COPY(GeoJSONLoader)
+
+    struct Job;
+
+    void start(const QString &id, std::function<void(Job &)> run);
+    void finish(const std::shared_ptr<Job> &job);
+    void reportProgress(Job &job, qint64 bytesRead, qint64 bytesTotal);
+    void parse(Job &job, QIODevice &device, const std::optional<mapbox::geometry::box<double>> &bounds);
+    void decode(Job &job, QIODevice &device, const std::optional<mapbox::geometry::box<double>> &bounds);
+
+    ApplyFunction m_apply;
+    PrepareFunction m_prepare;
+    QThreadPool m_pool;
+    QHash<QString, std::shared_ptr<Job>> m_jobs;
+};
+
+/*! \endcond */
+
+} // namespace QMapLibre
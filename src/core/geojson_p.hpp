@@ -9,14 +9,43 @@
 
 #include <mapbox/geojson.hpp>
 #include <mbgl/util/feature.hpp>
+#include <mbgl/util/geojson.hpp>
 #include <mbgl/util/geometry.hpp>
 
+#include <QtCore/QString>
+#include <QtCore/QStringEncoder>
 #include <QtCore/QVariant>
 
+#include <cstddef>
+#include <map>
+#include <optional>
 #include <string>
+#include <unordered_map>
 
 namespace QMapLibre::GeoJSON {
 
+// Converts the properties of many features. Each distinct key is converted to
+// UTF-8 once and strings are encoded through one reused buffer, so converting
+// a collection allocates little more than the resulting values.
+class PropertyConverter {
+public:
+    // Converted keys kept for reuse, the cache starts over once full.
+    static constexpr std::size_t MaxKeyCount = 4096;
+
+    mbgl::PropertyMap properties(const QVariantMap &properties);
+    mbgl::Value value(const QVariant &value);
+    // The reference stays valid until the next call to properties().
+    const std::string &key(const QString &key);
+    [[nodiscard]] std::size_t keyCount() const { return m_keys.size(); }
+
+private:
+    std::string string(QStringView text);
+
+    std::unordered_map<QString, std::string> m_keys;
+    QStringEncoder m_encoder{QStringEncoder::Utf8};
+    QByteArray m_buffer;
+};
+
 mbgl::Point<double> asPoint(const Coordinate &coordinate);
 mbgl::MultiPoint<double> asMultiPoint(const Coordinates &multiPoint);
 mbgl::LineString<double> asLineString(const Coordinates &lineString);
@@ -26,5 +55,56 @@ mbgl::MultiPolygon<double> asMultiPolygon(const CoordinatesCollections &multiPol
 mbgl::Value asPropertyValue(const QVariant &value);
 mbgl::FeatureIdentifier asFeatureIdentifier(const QVariant &id);
 mbgl::GeoJSONFeature asFeature(const Feature &feature);
+mbgl::GeoJSONFeature asFeature(const Feature &feature, PropertyConverter &converter);
+
+// Builds all features from contiguous buffers in one pass, see
+// Map::setSourceGeometry() for the layout. Single precision and quantized
+// coordinates are converted while the features are built, without an
+// intermediate buffer.
+std::optional<mbgl::FeatureCollection> asFeatureCollection(Feature::Type type,
+                                                           const QVector<double> &coordinates,
+                                                           const QVector<qsizetype> &featureOffsets,
+                                                           const QVector<qsizetype> &partOffsets,
+                                                           const QVector<qsizetype> &ringOffsets,
+                                                           const QVector<PropertyColumn> &properties,
+                                                           std::string &error);
+std::optional<mbgl::FeatureCollection> asFeatureCollection(Feature::Type type,
+                                                           const QVector<float> &coordinates,
+                                                           const QVector<qsizetype> &featureOffsets,
+                                                           const QVector<qsizetype> &partOffsets,
+                                                           const QVector<qsizetype> &ringOffsets,
+                                                           const QVector<PropertyColumn> &properties,
+                                                           std::string &error);
+std::optional<mbgl::FeatureCollection> asFeatureCollection(Feature::Type type,
+                                                           const QVector<qint32> &coordinates,
+                                                           const CoordinateQuantization &quantization,
+                                                           const QVector<qsizetype> &featureOffsets,
+                                                           const QVector<qsizetype> &partOffsets,
+                                                           const QVector<qsizetype> &ringOffsets,
+                                                           const QVector<PropertyColumn> &properties,
+                                                           std::string &error);
+// Builds all features of a batch in one pass.
+std::optional<mbgl::FeatureCollection> asFeatureCollection(const FeatureBatch &batch, std::string &error);
+
+// Features of a GeoJSON source keyed by their identifier, so single features
+// can be changed without converting all the others again.
+class FeatureSet {
+public:
+    // Replaces a feature with the same identifier. Returns false for features
+    // without identifier.
+    bool add(const Feature &feature);
+    // Returns false if no feature with the same identifier exists.
+    bool update(const Feature &feature);
+    // Returns false if no feature with the identifier exists.
+    bool remove(const QVariant &id);
+
+    [[nodiscard]] std::size_t size() const { return m_features.size(); }
+    [[nodiscard]] const mbgl::FeatureCollection &features() const { return m_features; }
+
+private:
+    mbgl::FeatureCollection m_features;
+    std::map<mbgl::FeatureIdentifier, std::size_t> m_index;
+    PropertyConverter m_converter;
+};
 
 } // namespace QMapLibre::GeoJSON
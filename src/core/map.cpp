@@ -62,6 +62,7 @@
 #include <mbgl/style/layers/custom_layer.hpp>
 
 #include <QtCore/QDebug>
+#include <QtCore/QPromise>
 #include <QtCore/QThreadStorage>
 #include <QtCore/QVariant>
 #include <QtCore/QVariantList>
@@ -98,6 +99,8 @@ namespace {
 
 QThreadStorage<std::shared_ptr<mbgl::util::RunLoop>> loop;
 
+constexpr std::chrono::milliseconds runLoopProbeInterval{50};
+
 // Conversion helper functions.
 
 QVariant variantFromValue(const mbgl::Value &value) {
@@ -341,6 +344,12 @@ namespace QMapLibre {
     \var Map::MapChangeSourceDidChange
     A source has changed.
 */
+/*!
+    \var Map::MapChangeDidBecomeIdle
+    A fully rendered frame was drawn and no further frames are needed until
+    the map changes, all sources are loaded and the symbol placement has
+    settled.
+*/
 
 /*!
     \enum Map::MapLoadingFailure
@@ -443,6 +452,7 @@ QString Map::styleJson() const {
     signal with Map::MapChangeDidFailLoadingMap as argument.
 */
 void Map::setStyleJson(const QString &style) {
+    d_ptr->featureSets.clear();
     d_ptr->mapObj->getStyle().loadJSON(style.toStdString());
 }
 
@@ -477,6 +487,7 @@ QString Map::styleUrl() const {
     signal with Map::MapChangeDidFailLoadingMap as argument.
 */
 void Map::setStyleUrl(const QString &url) {
+    d_ptr->featureSets.clear();
     d_ptr->mapObj->getStyle().loadURL(url.toStdString());
 }
 
@@ -1263,17 +1274,40 @@ void Map::setMargins(const QMargins &margins) {
 
         map->addSource("routeSource", routeSource);
     \endcode
+
+    The \c data of a GeoJSON source can also be FlatGeobuf or Geobuf in a
+    \c QByteArray, a Feature, a list of Feature or a FeatureBatch. A
+    FeatureBatch is the most compact way to pass many features.
 */
 void Map::addSource(const QString &id, const QVariantMap &params) {
+    d_ptr->supersedeSourceUpdates(id);
+
+    // Simplified data is converted up front and set once the source exists.
+    QVariantMap sourceParams = params;
+    std::optional<mbgl::GeoJSON> data;
+    const auto simplify = d_ptr->sourceSimplifier(id);
+    if (simplify && params.contains(QStringLiteral("data"))) {
+        mbgl::style::conversion::Error error;
+        data = mbgl::style::conversion::convert<mbgl::GeoJSON>(params[QStringLiteral("data")], error);
+        if (data) {
+            simplify(*data);
+            sourceParams[QStringLiteral("data")] = QByteArrayLiteral(R"({"type":"FeatureCollection","features":[]})");
+        }
+    }
+
     mbgl::style::conversion::Error error;
     std::optional<std::unique_ptr<mbgl::style::Source>> source =
         mbgl::style::conversion::convert<std::unique_ptr<mbgl::style::Source>>(
-            QVariant(params), error, id.toStdString());
+            QVariant(sourceParams), error, id.toStdString());
     if (!source) {
         qWarning() << "Unable to add source with id" << id << ":" << error.message.c_str();
         return;
     }
 
+    if (auto *sourceGeoJSON = (*source)->as<mbgl::style::GeoJSONSource>(); sourceGeoJSON != nullptr && data) {
+        sourceGeoJSON->setGeoJSON(*data);
+    }
+
     d_ptr->mapObj->getStyle().addSource(std::move(*source));
 }
 
@@ -1292,9 +1326,12 @@ bool Map::sourceExists(const QString &id) {
     \param params The source parameters.
 
     If the source does not exist, it will be added like in addSource(). Only
-    image and GeoJSON sources can be updated.
+    image and GeoJSON sources can be updated. Like with addSource(), the
+    \c data of a GeoJSON source can be a URL in a \c QString.
 */
 void Map::updateSource(const QString &id, const QVariantMap &params) {
+    d_ptr->supersedeSourceUpdates(id);
+
     mbgl::style::Source *source = d_ptr->mapObj->getStyle().getSource(id.toStdString());
     if (source == nullptr) {
         addSource(id, params);
@@ -1324,15 +1361,384 @@ void Map::updateSource(const QString &id, const QVariantMap &params) {
             }
             sourceImage->setCoordinates(coordinates);
         }
+    } else if (sourceGeoJSON != nullptr && params["data"].typeId() == QMetaType::QString) {
+        // Loaded by the source, like the data URL of addSource().
+        d_ptr->featureSets.erase(id.toStdString());
+        sourceGeoJSON->setURL(params["data"].toString().toStdString());
     } else if (sourceGeoJSON != nullptr && params.contains("data")) {
         mbgl::style::conversion::Error error;
         auto result = mbgl::style::conversion::convert<mbgl::GeoJSON>(params["data"], error);
         if (result) {
+            if (const auto simplify = d_ptr->sourceSimplifier(id)) {
+                simplify(*result);
+            }
+            d_ptr->featureSets.erase(id.toStdString());
             sourceGeoJSON->setGeoJSON(*result);
         }
     }
 }
 
+/*!
+    \brief Add a style source without blocking on its data.
+    \param id The source identifier.
+    \param params The source parameters.
+    \return A future with \c true once the source was added.
+
+    Like addSource(), but the \c data of GeoJSON sources is converted on the
+    background pool, so large inline data or feature lists do not block the
+    calling thread. The source is added to the style on the map thread once
+    the conversion has finished.
+
+    Like with addSource(), the data can also be FlatGeobuf or Geobuf in a
+    \c QByteArray. A \c QString is a URL the source loads itself, it is
+    committed right away.
+
+    The future reports \c false if the source could not be added, for
+    example because a source with \a id already exists. It is canceled if
+    the source is changed again before the conversion has finished.
+
+    \code
+        map->addSourceAsync("vehicles", params).then(this, [this](bool added) {
+            if (added) {
+                map->addLayer("vehicles", vehicleLayer);
+            }
+        });
+    \endcode
+
+    \sa updateSourceAsync()
+*/
+QFuture<bool> Map::addSourceAsync(const QString &id, const QVariantMap &params) {
+    return d_ptr->updateSourceAsync(this, id, params, true);
+}
+
+/*!
+    \brief Update a style source without blocking on its data.
+    \param id The source identifier.
+    \param params The source parameters.
+    \return A future with \c true once the source was updated.
+
+    Like updateSource(), but the \c data of GeoJSON sources is converted on
+    the background pool and committed to the style on the map thread.
+
+    A newer update of the same source, synchronous or not, supersedes an
+    update still in flight, whose future is then canceled. Updates are
+    therefore never applied out of order.
+
+    \sa addSourceAsync()
+*/
+QFuture<bool> Map::updateSourceAsync(const QString &id, const QVariantMap &params) {
+    return d_ptr->updateSourceAsync(this, id, params, false);
+}
+
+/*!
+    \brief Set the features of a GeoJSON source from contiguous buffers.
+    \param id The source identifier.
+    \param type The geometry type of all features.
+    \param coordinates Longitude and latitude pairs of all points.
+    \param featureOffsets Offsets of the first item of each feature.
+    \param partOffsets Offsets of the first ring of each polygon.
+    \param ringOffsets Offsets of the first point of each line or ring.
+    \param properties Property values of each feature.
+
+    Replaces the data of the GeoJSON source \a id, adding the source if it
+    does not exist. The features are built in a single pass without going
+    through Feature or QVariant, which is considerably faster for large
+    numbers of features.
+
+    Offsets follow the same layout on every level: item \c i spans from
+    \c offsets[i] up to \c offsets[i + 1], so each offset vector holds one
+    more offset than items. What a feature offset indexes depends on \a type:
+
+    \list
+    \li Feature::PointType: points, a feature with more than one point is a
+        multi point. \a partOffsets and \a ringOffsets are not used.
+    \li Feature::LineStringType: lines in \a ringOffsets, a feature with more
+        than one line is a multi line string. \a partOffsets is not used.
+    \li Feature::PolygonType: polygons in \a partOffsets, whose first ring is
+        the outer ring. A feature with more than one polygon is a multi
+        polygon.
+    \endlist
+
+    Each of the \a properties columns must hold one value per feature. To
+    use a column as feature identifier, set \c promoteId on the source.
+
+    \code
+        // Two points and a line.
+        const QVector<double> points{11.5, 48.1, 13.4, 52.5};
+        map->setSourceGeometry("stops", Feature::PointType, points, {0, 1, 2}, {}, {},
+                               {PropertyColumn("name", QStringList{"Munich", "Berlin"})});
+
+        const QVector<double> line{11.5, 48.1, 13.4, 52.5};
+        map->setSourceGeometry("route", Feature::LineStringType, line, {0, 1}, {}, {0, 2});
+    \endcode
+*/
+void Map::setSourceGeometry(const QString &id,
+                            Feature::Type type,
+                            const QVector<double> &coordinates,
+                            const QVector<qsizetype> &featureOffsets,
+                            const QVector<qsizetype> &partOffsets,
+                            const QVector<qsizetype> &ringOffsets,
+                            const QVector<PropertyColumn> &properties) {
+    std::string error;
+    std::optional<mbgl::FeatureCollection> collection = GeoJSON::asFeatureCollection(
+        type, coordinates, featureOffsets, partOffsets, ringOffsets, properties, error);
+    d_ptr->setSourceGeometry(id, std::move(collection), error);
+}
+
+/*!
+    \brief Set the features of a GeoJSON source from single precision buffers.
+    \param id The source identifier.
+    \param type The geometry type of all features.
+    \param coordinates Longitude and latitude pairs of all points.
+    \param featureOffsets Offsets of the first item of each feature.
+    \param partOffsets Offsets of the first ring of each polygon.
+    \param ringOffsets Offsets of the first point of each line or ring.
+    \param properties Property values of each feature.
+
+    Same as setSourceGeometry(), with half the memory for the caller's
+    buffers. Single precision resolves about two meters near the
+    antimeridian, which is enough for most point data.
+
+    It has its own name, so braced coordinate lists are not ambiguous.
+*/
+void Map::setSourceGeometryFloat(const QString &id,
+                                 Feature::Type type,
+                                 const QVector<float> &coordinates,
+                                 const QVector<qsizetype> &featureOffsets,
+                                 const QVector<qsizetype> &partOffsets,
+                                 const QVector<qsizetype> &ringOffsets,
+                                 const QVector<PropertyColumn> &properties) {
+    std::string error;
+    std::optional<mbgl::FeatureCollection> collection = GeoJSON::asFeatureCollection(
+        type, coordinates, featureOffsets, partOffsets, ringOffsets, properties, error);
+    d_ptr->setSourceGeometry(id, std::move(collection), error);
+}
+
+/*!
+    \brief Set the features of a GeoJSON source from quantized buffers.
+    \param id The source identifier.
+    \param type The geometry type of all features.
+    \param coordinates Quantized longitude and latitude pairs of all points.
+    \param quantization The origin and resolution of \a coordinates.
+    \param featureOffsets Offsets of the first item of each feature.
+    \param partOffsets Offsets of the first ring of each polygon.
+    \param ringOffsets Offsets of the first point of each line or ring.
+    \param properties Property values of each feature.
+
+    Same as setSourceGeometry(), with coordinates stored as fixed-point
+    integers relative to an origin, see CoordinateQuantization. Unlike
+    setSourceGeometryFloat(), the accuracy is the same everywhere and can be
+    chosen to match the data.
+
+    \code
+        // Points of a tile with its north-west corner at (48.2, 11.4).
+        const CoordinateQuantization tile{{48.2, 11.4}, 1e-6};
+        const QVector<qint32> points{100000, -100000, 150000, -120000};
+        map->setSourceGeometryQuantized("stops", Feature::PointType, points, tile, {0, 1, 2});
+    \endcode
+*/
+void Map::setSourceGeometryQuantized(const QString &id,
+                                     Feature::Type type,
+                                     const QVector<qint32> &coordinates,
+                                     const CoordinateQuantization &quantization,
+                                     const QVector<qsizetype> &featureOffsets,
+                                     const QVector<qsizetype> &partOffsets,
+                                     const QVector<qsizetype> &ringOffsets,
+                                     const QVector<PropertyColumn> &properties) {
+    std::string error;
+    std::optional<mbgl::FeatureCollection> collection = GeoJSON::asFeatureCollection(
+        type, coordinates, quantization, featureOffsets, partOffsets, ringOffsets, properties, error);
+    d_ptr->setSourceGeometry(id, std::move(collection), error);
+}
+
+/*!
+    \brief Apply feature changes to a GeoJSON source.
+    \param id The source identifier.
+    \param added Features to add.
+    \param updated Features to replace.
+    \param removedIds Identifiers of the features to remove.
+
+    Changes the features of the GeoJSON source \a id by their Feature::id,
+    adding the source if it does not exist. Only the changed features are
+    converted to the renderer representation, which saves the conversion of
+    all others compared to updateSource().
+
+    This is a convenience for keeping features by identifier, not an
+    incremental update of the renderer. Every call hands all features of the
+    source to the renderer, which tiles them again as with updateSource().
+
+    The source must have been added by this method, the features set by
+    other means can't be read back. Sources with data set by addSource(),
+    updateSource() or the other data setters are left unchanged with a
+    warning, remove them first to manage their features here.
+
+    Removals are applied first, then additions and updates. Adding a feature
+    with an existing identifier replaces it. Features without identifier
+    and changes of unknown identifiers are skipped with a warning.
+
+    \code
+        map->updateSourceFeatures("vehicles", {}, {vehicle}, {QVariant(finishedId)});
+    \endcode
+*/
+void Map::updateSourceFeatures(const QString &id,
+                               const QList<Feature> &added,
+                               const QList<Feature> &updated,
+                               const QVariantList &removedIds) {
+    const std::string sourceId = id.toStdString();
+    mbgl::style::Source *source = d_ptr->mapObj->getStyle().getSource(sourceId);
+    mbgl::style::GeoJSONSource *sourceGeoJSON = nullptr;
+    if (source == nullptr) {
+        auto newSource = std::make_unique<mbgl::style::GeoJSONSource>(sourceId);
+        sourceGeoJSON = newSource.get();
+        d_ptr->mapObj->getStyle().addSource(std::move(newSource));
+        d_ptr->featureSets.erase(sourceId);
+    } else {
+        sourceGeoJSON = source->as<mbgl::style::GeoJSONSource>();
+        if (sourceGeoJSON == nullptr) {
+            qWarning() << "Unable to update features of source with id" << id << ": not a GeoJSON source.";
+            return;
+        }
+        if (d_ptr->featureSets.find(sourceId) == d_ptr->featureSets.end()) {
+            qWarning() << "Unable to update features of source with id" << id
+                       << ": its data was not set by updateSourceFeatures.";
+            return;
+        }
+    }
+
+    GeoJSON::FeatureSet &features = d_ptr->featureSets[sourceId];
+    for (const QVariant &removedId : removedIds) {
+        if (!features.remove(removedId)) {
+            qWarning() << "Unable to remove feature" << removedId << "from source with id" << id;
+        }
+    }
+    for (const Feature &feature : added) {
+        if (!features.add(feature)) {
+            qWarning() << "Unable to add feature without identifier to source with id" << id;
+        }
+    }
+    for (const Feature &feature : updated) {
+        if (!features.update(feature)) {
+            qWarning() << "Unable to update feature" << feature.id << "of source with id" << id;
+        }
+    }
+
+    sourceGeoJSON->setGeoJSON(features.features());
+}
+
+/*!
+    \brief Load the data of a GeoJSON source from a file.
+    \param id The source identifier.
+    \param path The path of the GeoJSON file, can be a Qt resource.
+
+    Reads, parses and tiles the file on a worker thread without blocking the
+    caller and replaces the data of the GeoJSON source \a id once it is
+    ready, adding the source if it does not exist by then. Files are memory
+    mapped when possible. The data is tiled with the options the source has
+    when the load starts.
+
+    Besides GeoJSON text, the file can hold
+    <a href="https://flatgeobuf.org">FlatGeobuf</a> or
+    <a href="https://github.com/mapbox/geobuf">Geobuf</a> data, which is
+    decoded directly into features.
+
+    sourceDataLoadProgress() is emitted while the file is read, followed by
+    either sourceDataLoaded() or sourceDataLoadFailed(). Loading again
+    into the same source cancels the load in flight.
+
+    \code
+        connect(map, &Map::sourceDataLoaded, this, [map](const QString &id) {
+            if (id == "parcels") {
+                map->addLayer("parcels-fill", parcelsLayer);
+            }
+        });
+        map->loadSourceData("parcels", "/data/parcels.geojson");
+    \endcode
+
+    \sa cancelSourceDataLoad()
+*/
+void Map::loadSourceData(const QString &id, const QString &path) {
+    d_ptr->geojsonLoader->load(id, path);
+}
+
+/*!
+    \brief Load the features of a GeoJSON source within bounds from a file.
+    \param id The source identifier.
+    \param path The path of the FlatGeobuf file.
+    \param sw The southwest coordinate of the bounds.
+    \param ne The northeast coordinate of the bounds.
+
+    Like the variant without bounds, but only loads the features of a
+    FlatGeobuf file whose bounding box intersects the bounds. If the file has
+    a spatial index only those features are read at all. Other formats are
+    loaded in full.
+*/
+void Map::loadSourceData(const QString &id, const QString &path, const Coordinate &sw, const Coordinate &ne) {
+    d_ptr->geojsonLoader->load(id, path, mapbox::geometry::box<double>{{sw.second, sw.first}, {ne.second, ne.first}});
+}
+
+/*!
+    \brief Load the data of a GeoJSON source from a device.
+    \param id The source identifier.
+    \param device The open device to read the GeoJSON from.
+
+    Like the file variant, but streams the GeoJSON from \a device. The device
+    is read on a worker thread until it reports no more data, so it must not
+    be used otherwise and must stay alive until loading has finished or was
+    cancelled. Devices that need the event loop to receive data, like sockets,
+    are not supported. A device that is not open for reading fails the load
+    with sourceDataLoadFailed().
+*/
+void Map::loadSourceData(const QString &id, QIODevice *device) {
+    d_ptr->geojsonLoader->load(id, device);
+}
+
+/*!
+    \brief Cancel loading the data of a GeoJSON source.
+    \param id The source identifier.
+
+    The source keeps its current data and no further signals are emitted for
+    the cancelled load. This method has no effect if no load is in flight.
+*/
+void Map::cancelSourceDataLoad(const QString &id) {
+    d_ptr->geojsonLoader->cancel(id);
+}
+
+/*!
+    \brief Simplify the lines and polygons of a GeoJSON source.
+    \param id The source identifier.
+    \param tolerance The tolerance in degrees, \c 0 turns simplification off.
+    \param algorithm The simplification algorithm.
+
+    Data set for the source \a id from now on is simplified before it is
+    handed to the renderer, which saves memory and tiling time for dense
+    lines such as GPS tracks. The source does not need to exist yet.
+
+    With Map::DouglasPeucker, points closer than \a tolerance to the
+    simplified line are removed. With Map::VisvalingamWhyatt, points are
+    removed while the triangle they form with their neighbours has an area
+    below the square of \a tolerance.
+
+    Lines keep their end points and polygon rings stay closed. Holes that
+    would collapse are removed, outer rings are kept as they are then.
+
+    Features are simplified in parallel on the background pool. Data set by
+    addSource(), updateSource(), setSourceGeometry() and loadSourceData() is
+    simplified, as well as data of the asynchronous variants, which is done
+    off the map thread. Changes made by updateSourceFeatures() are not.
+
+    \code
+        // About one meter at the equator.
+        map->setSourceSimplification("tracks", 0.00001);
+    \endcode
+*/
+void Map::setSourceSimplification(const QString &id, double tolerance, SimplificationAlgorithm algorithm) {
+    Simplification::Options options;
+    options.algorithm = algorithm == VisvalingamWhyatt ? Simplification::Algorithm::VisvalingamWhyatt
+                                                       : Simplification::Algorithm::DouglasPeucker;
+    options.tolerance = tolerance;
+    d_ptr->setSourceSimplification(id, options);
+}
+
 /*!
     \brief Remove a style source.
     \param id The source identifier.
@@ -1342,6 +1748,9 @@ void Map::updateSource(const QString &id, const QVariantMap &params) {
 void Map::removeSource(const QString &id) {
     auto idStdString = id.toStdString();
 
+    d_ptr->featureSets.erase(idStdString);
+    d_ptr->geojsonLoader->cancel(id);
+    d_ptr->supersedeSourceUpdates(id);
     if (d_ptr->mapObj->getStyle().getSource(idStdString) != nullptr) {
         d_ptr->mapObj->getStyle().removeSource(idStdString);
     }
@@ -1591,6 +2000,46 @@ void Map::createRendererWithQtVulkanDevice(void *windowPtr,
 }
 #endif
 
+#ifdef MLN_QT_WITH_HEADLESS
+/*!
+    \brief Create a renderer drawing into an offscreen framebuffer.
+    \return \c true if an OpenGL context could be created.
+
+    Creates the renderer together with its own OpenGL context, offscreen
+    surface and framebuffer, so the map can be rendered without a window,
+    for example in batch jobs on servers. render() draws into the
+    framebuffer and grabFrame() reads it back. The framebuffer follows the
+    size of the map set by resize().
+
+    Requires a QGuiApplication with a platform plugin that provides OpenGL
+    offscreen surfaces. On Linux servers without a GPU, Mesa's llvmpipe
+    driver renders in software, for example with the \c xcb plugin under
+    Xvfb or with an EGL based plugin on Mesa's surfaceless platform.
+
+    Must be called on the GUI thread, which then has to be the render
+    thread. Only available with the OpenGL backend, when built with
+    \c MLN_QT_WITH_HEADLESS.
+
+    \code
+        QGuiApplication app(argc, argv);
+
+        Map map(nullptr, Settings(), QSize(512, 512));
+        map.setStyleUrl("https://demotiles.maplibre.org/style.json");
+        map.createHeadlessRenderer();
+
+        QObject::connect(&map, &Map::mapChanged, [&map](Map::MapChange change) {
+            if (change == Map::MapChangeDidFinishRenderingMapFullyRendered) {
+                map.grabFrame().save("map.png");
+            }
+        });
+        QObject::connect(&map, &Map::needsRendering, &map, &Map::render);
+    \endcode
+*/
+bool Map::createHeadlessRenderer() {
+    return d_ptr->createHeadlessRenderer();
+}
+#endif
+
 /*!
     \brief Destroy the renderer.
 
@@ -1603,6 +2052,91 @@ void Map::destroyRenderer() {
     d_ptr->destroyRenderer();
 }
 
+/*!
+    \brief Returns the render thread task scheduler counters.
+    \return The counters as of the last rendered frame.
+
+    Only available when rendering on a thread without an event loop, where
+    MapLibre tasks are run after each frame. Otherwise all counters are zero.
+
+    Thread-safe, never waits for a frame in progress.
+
+    \sa Settings::setRenderTaskBudget()
+*/
+SchedulerStatistics Map::schedulerStatistics() const {
+    return d_ptr->schedulerStatistics();
+}
+
+/*!
+    \brief Returns the background worker pool counters.
+    \return The current counters of the pool used by this map.
+
+    Only available when the pool is configured through
+    Settings::setBackgroundThreadCount() and related settings. When several
+    maps share a pool, the counters cover all of them. Otherwise all counters
+    are zero.
+
+    Thread-safe.
+*/
+ThreadPoolStatistics Map::backgroundPoolStatistics() const {
+    return d_ptr->backgroundPoolStatistics();
+}
+
+/*!
+    \brief Returns the frame pacing counters.
+    \return The counters since the map was created.
+
+    Thread-safe.
+
+    \sa Settings::setMaxFrameRate()
+*/
+FramePacerStatistics Map::framePacerStatistics() const {
+    return d_ptr->framePacerStatistics();
+}
+
+/*!
+    \brief Returns the task queue counters.
+    \return The counters of the queues feeding this map.
+
+    Only collected when Settings::setStatisticsInterval() is set, the same
+    counters are then also delivered periodically by statisticsUpdated().
+    Otherwise all counters are zero.
+
+    Thread-safe, never waits for a frame in progress.
+*/
+MapStatistics Map::statistics() const {
+    return d_ptr->statistics();
+}
+
+/*!
+    \brief Choose whether a map change is delivered.
+    \param change The map change.
+    \param enabled \c true to emit mapChanged() for it.
+
+    All map changes are delivered by default. Disabling the ones nobody
+    listens to, typically MapChangeWillStartRenderingFrame,
+    MapChangeDidFinishRenderingFrame and MapChangeRegionIsChanging which
+    are emitted on every frame, saves a signal emission per event. Use
+    cameraChanged() to follow the camera instead.
+
+    Thread-safe.
+
+    \note Frames are requested through needsRendering(), which is not
+    affected by this filter.
+*/
+void Map::setMapChangeEnabled(MapChange change, bool enabled) {
+    d_ptr->setMapChangeEnabled(change, enabled);
+}
+
+/*!
+    \brief Check whether a map change is delivered.
+    \param change The map change.
+    \return \c true if mapChanged() is emitted for it.
+*/
+bool Map::isMapChangeEnabled(MapChange change) const {
+    return d_ptr->isMapChangeEnabled(change);
+}
+
 /*!
     \brief Start the static renderer.
 
@@ -1735,8 +2269,94 @@ mbgl::vulkan::Texture2D *Map::getVulkanTexture() const {
 unsigned int Map::getFramebufferTextureId() const {
     return d_ptr->getFramebufferTextureId();
 }
+
+/*!
+    \brief Render a frame and read it back.
+    \return The rendered frame, or a null image if there is no renderer.
+
+    Renders the current state of the map like render() and returns the
+    pixels of the frame. Reading back waits for the GPU to finish the
+    frame, so this is meant for capturing single frames rather than for
+    every frame.
+
+    Must be called on the render thread with the OpenGL context of the
+    renderer current, which createHeadlessRenderer() takes care of.
+*/
+QImage Map::grabFrame() {
+    return d_ptr->grabFrame();
+}
+#endif
+
+#if defined(MLN_RENDER_BACKEND_OPENGL) || defined(MLN_RENDER_BACKEND_VULKAN)
+/*!
+    \brief Read back the next frame without blocking.
+    \return A future for the frame.
+
+    Unlike grabFrame() this does not render and does not wait for the GPU.
+    The next frame rendered is copied to a staging buffer on the GPU and
+    the future finishes during one of the following frames, once the copy
+    is done. Rendering is requested until then, so the frames keep coming.
+    This keeps the render thread busy drawing while earlier frames are
+    transferred, which makes it suitable for recording every frame.
+
+    Can be called from any thread, the future finishes on the render
+    thread. It is canceled if the renderer is destroyed first.
+
+    With Vulkan only frames rendered to the offscreen texture of the
+    renderer can be read back, not external drawables.
+*/
+QFuture<QImage> Map::grabFrameAsync() {
+    return d_ptr->grabFrameAsync();
+}
 #endif
 
+/*!
+    \fn void Map::cameraChanged()
+
+    This signal is emitted after a frame was rendered if the camera moved
+    since the previous frame, at most once per frame however often the
+    camera changed in between.
+
+    \sa setMapChangeEnabled()
+*/
+
+/*!
+    \fn void Map::statisticsUpdated(const QMapLibre::MapStatistics &statistics)
+
+    This signal is emitted every Settings::statisticsInterval() with the
+    current task queue \a statistics.
+
+    \sa statistics()
+*/
+
+/*!
+    \fn void Map::sourceDataLoadProgress(const QString &id, qint64 bytesRead, qint64 bytesTotal)
+
+    This signal is emitted while the data of the GeoJSON source \a id is
+    loaded with \a bytesRead out of \a bytesTotal, which is -1 if the size is
+    not known.
+
+    \sa loadSourceData()
+*/
+
+/*!
+    \fn void Map::sourceDataLoaded(const QString &id)
+
+    This signal is emitted once the loaded data was set on the GeoJSON source
+    \a id.
+
+    \sa loadSourceData()
+*/
+
+/*!
+    \fn void Map::sourceDataLoadFailed(const QString &id, const QString &error)
+
+    This signal is emitted if the data of the GeoJSON source \a id could not
+    be read or parsed, described by \a error.
+
+    \sa loadSourceData()
+*/
+
 /*!
     \fn void Map::needsRendering()
     \brief Signal emitted when the rendering is needed.
@@ -1795,13 +2415,20 @@ MapPrivate::MapPrivate(Map *map, const Settings &settings, const QSize &size, qr
     : QObject(map),
       m_mode(settings.contextMode()),
       m_pixelRatio(pixelRatio_),
-      m_localFontFamily(settings.localFontFamily()) {
+      m_localFontFamily(settings.localFontFamily()),
+      m_renderTaskBudget(settings.renderTaskBudget()),
+      m_statisticsInterval(settings.statisticsInterval()),
+      m_backgroundPool(ThreadPool::fromSettings(settings)),
+      m_backgroundScheduler(m_backgroundPool ? std::shared_ptr<mbgl::Scheduler>(m_backgroundPool)
+                                             : mbgl::Scheduler::GetBackground()),
+      m_threadPool(m_backgroundScheduler, m_threadPoolTag) {
     // Setup MapObserver
     m_mapObserver = std::make_unique<MapObserver>(this);
 
     qRegisterMetaType<Map::MapChange>("Map::MapChange");
 
     connect(m_mapObserver.get(), &MapObserver::mapChanged, map, &Map::mapChanged);
+    connect(m_mapObserver.get(), &MapObserver::cameraChanged, map, &Map::cameraChanged);
     connect(m_mapObserver.get(), &MapObserver::mapLoadingFailed, map, &Map::mapLoadingFailed);
     connect(m_mapObserver.get(), &MapObserver::copyrightsChanged, map, &Map::copyrightsChanged);
 
@@ -1835,22 +2462,72 @@ MapPrivate::MapPrivate(Map *map, const Settings &settings, const QSize &size, qr
         fs->setResourceTransform(std::move(transform));
     }
 
-    // Needs to be Queued to give time to discard redundant draw calls via the `renderQueued` flag.
-    connect(this, &MapPrivate::needsRendering, map, &Map::needsRendering, Qt::QueuedConnection);
+    geojsonLoader = std::make_unique<GeoJSONLoader>(
+        [this](const QString &id, std::shared_ptr<mbgl::style::GeoJSONData> data) {
+            return setGeoJSONData(id, std::move(data));
+        },
+        [this](const QString &id) { return sourceIndexer(id); });
+    connect(geojsonLoader.get(), &GeoJSONLoader::progress, map, &Map::sourceDataLoadProgress);
+    connect(geojsonLoader.get(), &GeoJSONLoader::loaded, map, &Map::sourceDataLoaded);
+    connect(geojsonLoader.get(), &GeoJSONLoader::failed, map, &Map::sourceDataLoadFailed);
+
+    m_mapThreadContext->object = this;
+
+    m_framePacer = std::make_unique<FramePacer>(settings.maxFrameRate());
+    connect(m_framePacer.get(), &FramePacer::frameRequested, this, &MapPrivate::needsRendering);
+    connect(this, &MapPrivate::needsRendering, map, &Map::needsRendering);
+
+    if (m_statisticsInterval.count() > 0) {
+        m_runLoopStatistics = std::make_shared<TaskStatistics>();
+        if (m_backgroundPool) {
+            m_backgroundPool->enableTaskStatistics();
+            m_backgroundPool->setTaskOwnerName(m_threadPoolTag, QStringLiteral("GeoJSON source data"));
+        }
+
+        // The run loop does not expose its tasks, sample its latency instead.
+        connect(&m_runLoopProbe, &QTimer::timeout, this, [statistics = m_runLoopStatistics] {
+            mbgl::util::RunLoop::Get()->schedule([statistics, scheduled = TaskStatistics::Clock::now()] {
+                statistics->recordLatency(TaskStatistics::Clock::now() - scheduled);
+            });
+        });
+        m_runLoopProbe.start(runLoopProbeInterval);
+
+        connect(&m_statisticsTimer, &QTimer::timeout, map, [this, map] { emit map->statisticsUpdated(statistics()); });
+        m_statisticsTimer.start(m_statisticsInterval);
+    }
 }
 
-MapPrivate::~MapPrivate() = default;
+MapPrivate::~MapPrivate() {
+    {
+        const std::scoped_lock lock(m_mapThreadContext->mutex);
+        m_mapThreadContext->object = nullptr;
+    }
 
-void MapPrivate::update(std::shared_ptr<mbgl::UpdateParameters> parameters) {
-    const std::scoped_lock lock(m_mapRendererMutex);
+#ifdef MLN_QT_WITH_HEADLESS
+    // The renderer releases its resources in the headless context.
+    if (m_headlessContext != nullptr) {
+        destroyRenderer();
+    }
+#endif
+#if defined(MLN_RENDER_BACKEND_OPENGL) || defined(MLN_RENDER_BACKEND_VULKAN)
+    cancelFrameRequests();
+#endif
 
-    m_updateParameters = std::move(parameters);
+    if (m_backgroundPool && m_runLoopStatistics) {
+        m_backgroundPool->disableTaskStatistics();
+        m_backgroundPool->releaseTaskOwnerName(m_threadPoolTag);
+    }
 
-    if (m_mapRenderer == nullptr) {
-        return;
+    // Conversions still running lock the pool to schedule their helpers, it
+    // must not be released from one of its own workers.
+    if (m_backgroundPool) {
+        m_backgroundPool->waitForEmpty(m_threadPoolTag);
     }
+}
 
-    m_mapRenderer->updateParameters(std::move(m_updateParameters));
+void MapPrivate::update(std::shared_ptr<mbgl::UpdateParameters> parameters) {
+    // Never blocks, even while a frame is being rendered.
+    m_updateParameters->write(std::move(parameters));
 
     requestRendering();
 }
@@ -1877,6 +2554,15 @@ void MapPrivate::createRenderer(void *nativeTargetPtr) {
     connect(m_mapRenderer.get(), &MapRenderer::needsRendering, this, &MapPrivate::requestRendering);
 
     m_mapRenderer->setObserver(m_rendererObserver.get());
+    if (m_renderTaskBudget.count() > 0) {
+        m_mapRenderer->setTaskBudget(m_renderTaskBudget);
+    }
+    if (m_runLoopStatistics) {
+        m_mapRenderer->enableTaskStatistics();
+
+        const std::scoped_lock statisticsLock(m_renderThreadStatisticsMutex);
+        m_renderThreadStatistics = m_mapRenderer->taskStatistics();
+    }
 
     // Propagate current map size to the renderer
     if (mapObj) {
@@ -1885,10 +2571,8 @@ void MapPrivate::createRenderer(void *nativeTargetPtr) {
         m_mapRenderer->updateRenderer(currentSize, currentPixelRatio);
     }
 
-    if (m_updateParameters != nullptr) {
-        m_mapRenderer->updateParameters(m_updateParameters);
-        requestRendering();
-    }
+    m_mapRenderer->setUpdateParameters(m_updateParameters);
+    requestRendering();
 }
 
 #ifdef MLN_RENDER_BACKEND_VULKAN
@@ -1908,6 +2592,15 @@ void MapPrivate::createRendererWithQtVulkanDevice(void *windowPtr,
     connect(m_mapRenderer.get(), &MapRenderer::needsRendering, this, &MapPrivate::requestRendering);
 
     m_mapRenderer->setObserver(m_rendererObserver.get());
+    if (m_renderTaskBudget.count() > 0) {
+        m_mapRenderer->setTaskBudget(m_renderTaskBudget);
+    }
+    if (m_runLoopStatistics) {
+        m_mapRenderer->enableTaskStatistics();
+
+        const std::scoped_lock statisticsLock(m_renderThreadStatisticsMutex);
+        m_renderThreadStatistics = m_mapRenderer->taskStatistics();
+    }
 
     if (mapObj) {
         auto currentSize = mapObj->getMapOptions().size();
@@ -1915,16 +2608,48 @@ void MapPrivate::createRendererWithQtVulkanDevice(void *windowPtr,
         m_mapRenderer->updateRenderer(currentSize, currentPixelRatio);
     }
 
-    if (m_updateParameters != nullptr) {
-        m_mapRenderer->updateParameters(m_updateParameters);
-        requestRendering();
+    m_mapRenderer->setUpdateParameters(m_updateParameters);
+    requestRendering();
+}
+#endif
+
+#ifdef MLN_QT_WITH_HEADLESS
+bool MapPrivate::createHeadlessRenderer() {
+    const std::scoped_lock lock(m_mapRendererMutex);
+
+    if (m_mapRenderer != nullptr) {
+        return m_headlessContext != nullptr;
+    }
+
+    auto context = std::make_unique<HeadlessContext>();
+    if (!context->isValid()) {
+        return false;
     }
+
+    m_headlessContext = std::move(context);
+    m_headlessSize = {};
+    createRenderer(nullptr);
+    return true;
 }
 #endif
 
 void MapPrivate::destroyRenderer() {
     const std::scoped_lock lock(m_mapRendererMutex);
 
+#if defined(MLN_RENDER_BACKEND_OPENGL) || defined(MLN_RENDER_BACKEND_VULKAN)
+    // No frame is rendered for them anymore.
+    cancelFrameRequests();
+#endif
+
+#ifdef MLN_QT_WITH_HEADLESS
+    if (m_headlessContext != nullptr) {
+        m_headlessContext->makeCurrent();
+        m_mapRenderer.reset();
+        m_headlessContext.reset();
+        return;
+    }
+#endif
+
     m_mapRenderer.reset();
 }
 
@@ -1935,6 +2660,9 @@ void MapPrivate::render() {
     qDebug() << "MapPrivate::render() - Called";
 #endif
 
+    // Updates arriving from here on need another frame.
+    m_framePacer->beginFrame();
+
     if (m_mapRenderer == nullptr) {
 #ifdef MLN_RENDERER_DEBUGGING
         qDebug() << "MapPrivate::render() - MapRenderer is null, not rendering";
@@ -1942,18 +2670,159 @@ void MapPrivate::render() {
         return;
     }
 
+#ifdef MLN_QT_WITH_HEADLESS
+    if (m_headlessContext != nullptr && !prepareHeadlessFrame()) {
+        return;
+    }
+#endif
+
 #ifdef MLN_RENDERER_DEBUGGING
-    qDebug() << "MapPrivate::render() - Clearing render queue and rendering";
+    qDebug() << "MapPrivate::render() - Rendering";
 #endif
 
-    m_renderQueued.clear();
     m_mapRenderer->render();
+    publishRendererStatistics();
+#ifdef MLN_RENDER_BACKEND_OPENGL
+    m_framePacer->endFrame(m_mapRenderer->takeColorTargetWaits());
+#else
+    m_framePacer->endFrame();
+#endif
+#if defined(MLN_RENDER_BACKEND_OPENGL) || defined(MLN_RENDER_BACKEND_VULKAN)
+    readFrames();
+#endif
 
 #ifdef MLN_RENDERER_DEBUGGING
     qDebug() << "MapPrivate::render() - Completed";
 #endif
 }
 
+#ifdef MLN_RENDER_BACKEND_OPENGL
+QImage MapPrivate::grabFrame() {
+    const std::scoped_lock lock(m_mapRendererMutex);
+
+    render();
+    return m_mapRenderer != nullptr ? m_mapRenderer->readFramebuffer() : QImage();
+}
+#endif
+
+#if defined(MLN_RENDER_BACKEND_OPENGL) || defined(MLN_RENDER_BACKEND_VULKAN)
+QFuture<QImage> MapPrivate::grabFrameAsync() {
+    QPromise<QImage> promise;
+    promise.start();
+    QFuture<QImage> future = promise.future();
+
+    {
+        const std::scoped_lock lock(m_frameRequestsMutex);
+        m_frameRequests.push_back(std::move(promise));
+    }
+
+    requestRendering();
+    return future;
+}
+
+void MapPrivate::readFrames() {
+    std::vector<QPromise<QImage>> requests;
+    {
+        const std::scoped_lock lock(m_frameRequestsMutex);
+        requests.swap(m_frameRequests);
+    }
+
+    bool pending = m_mapRenderer->collectFrames();
+    if (!requests.empty()) {
+        m_mapRenderer->readFramebufferAsync(std::move(requests));
+        pending = true;
+    }
+
+    // Keep rendering until the reads in flight are delivered.
+    if (pending) {
+        requestRendering();
+    }
+}
+
+void MapPrivate::cancelFrameRequests() {
+    std::vector<QPromise<QImage>> requests;
+    {
+        const std::scoped_lock lock(m_frameRequestsMutex);
+        requests.swap(m_frameRequests);
+    }
+
+    for (QPromise<QImage> &promise : requests) {
+        promise.future().cancel();
+        promise.finish();
+    }
+}
+#endif
+
+#ifdef MLN_QT_WITH_HEADLESS
+bool MapPrivate::prepareHeadlessFrame() {
+    if (!m_headlessContext->makeCurrent()) {
+        qWarning() << "Unable to make the headless OpenGL context current.";
+        return false;
+    }
+
+    // Resizing the map only records the new size, the framebuffer follows
+    // here.
+    const mbgl::MapOptions &options = mapObj->getMapOptions();
+    if (options.size() != m_headlessSize || options.pixelRatio() != m_headlessPixelRatio) {
+        m_headlessSize = options.size();
+        m_headlessPixelRatio = options.pixelRatio();
+        m_mapRenderer->updateRenderer(m_headlessSize, m_headlessPixelRatio, m_headlessContext->framebuffer());
+    }
+
+    return true;
+}
+#endif
+
+void MapPrivate::publishRendererStatistics() {
+    const SchedulerStatistics &statistics = m_mapRenderer->schedulerStatistics();
+    m_rendererStatistics.pendingTasks.store(statistics.pendingTasks, std::memory_order_relaxed);
+    m_rendererStatistics.processedTasks.store(statistics.processedTasks, std::memory_order_relaxed);
+    m_rendererStatistics.deferredTasks.store(statistics.deferredTasks, std::memory_order_relaxed);
+    m_rendererStatistics.exhaustedBudgets.store(statistics.exhaustedBudgets, std::memory_order_relaxed);
+}
+
+SchedulerStatistics MapPrivate::schedulerStatistics() const {
+    SchedulerStatistics statistics;
+    statistics.pendingTasks = m_rendererStatistics.pendingTasks.load(std::memory_order_relaxed);
+    statistics.processedTasks = m_rendererStatistics.processedTasks.load(std::memory_order_relaxed);
+    statistics.deferredTasks = m_rendererStatistics.deferredTasks.load(std::memory_order_relaxed);
+    statistics.exhaustedBudgets = m_rendererStatistics.exhaustedBudgets.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+ThreadPoolStatistics MapPrivate::backgroundPoolStatistics() const {
+    return m_backgroundPool ? m_backgroundPool->statistics() : ThreadPoolStatistics{};
+}
+
+FramePacerStatistics MapPrivate::framePacerStatistics() const {
+    return m_framePacer->statistics();
+}
+
+MapStatistics MapPrivate::statistics() const {
+    MapStatistics statistics;
+    if (m_runLoopStatistics == nullptr) {
+        return statistics;
+    }
+
+    std::shared_ptr<TaskStatistics> renderThread;
+    {
+        const std::scoped_lock lock(m_renderThreadStatisticsMutex);
+        renderThread = m_renderThreadStatistics;
+    }
+    if (renderThread != nullptr) {
+        statistics.renderThread = renderThread->snapshot(
+            m_rendererStatistics.pendingTasks.load(std::memory_order_relaxed));
+    }
+
+    // The run loop does not expose its queue, its depth is unknown.
+    statistics.runLoop = m_runLoopStatistics->snapshot(0);
+    if (m_backgroundPool) {
+        statistics.backgroundPool = m_backgroundPool->taskStatistics();
+    }
+
+    return statistics;
+}
+
 void MapPrivate::updateRenderer(const QSize &size, qreal pixelRatio, quint32 fbo) {
     const std::scoped_lock lock(m_mapRendererMutex);
 
@@ -1969,9 +2838,205 @@ void MapPrivate::updateRenderer(const QSize &size, qreal pixelRatio, quint32 fbo
 }
 
 void MapPrivate::requestRendering() {
-    if (!m_renderQueued.test_and_set()) {
-        emit needsRendering();
+    m_framePacer->requestFrame();
+}
+
+bool MapPrivate::setGeoJSON(const QString &id, mbgl::GeoJSON geojson) {
+    const std::string sourceId = id.toStdString();
+    mbgl::style::Source *source = mapObj->getStyle().getSource(sourceId);
+    if (source == nullptr) {
+        auto sourceGeoJSON = std::make_unique<mbgl::style::GeoJSONSource>(sourceId);
+        sourceGeoJSON->setGeoJSON(geojson);
+        mapObj->getStyle().addSource(std::move(sourceGeoJSON));
+        return true;
     }
+
+    auto *sourceGeoJSON = source->as<mbgl::style::GeoJSONSource>();
+    if (sourceGeoJSON == nullptr) {
+        return false;
+    }
+
+    featureSets.erase(sourceId);
+    sourceGeoJSON->setGeoJSON(geojson);
+    return true;
+}
+
+bool MapPrivate::setGeoJSONData(const QString &id, std::shared_ptr<mbgl::style::GeoJSONData> data) {
+    const std::string sourceId = id.toStdString();
+    mbgl::style::Source *source = mapObj->getStyle().getSource(sourceId);
+    if (source == nullptr) {
+        auto sourceGeoJSON = std::make_unique<mbgl::style::GeoJSONSource>(sourceId);
+        sourceGeoJSON->setGeoJSONData(std::move(data));
+        mapObj->getStyle().addSource(std::move(sourceGeoJSON));
+        return true;
+    }
+
+    auto *sourceGeoJSON = source->as<mbgl::style::GeoJSONSource>();
+    if (sourceGeoJSON == nullptr) {
+        return false;
+    }
+
+    featureSets.erase(sourceId);
+    sourceGeoJSON->setGeoJSONData(std::move(data));
+    return true;
+}
+
+GeoJSONLoader::Index MapPrivate::sourceIndexer(const QString &id) const {
+    // Sources added once the data is ready get the default options.
+    mbgl::Immutable<mbgl::style::GeoJSONOptions> options = mbgl::style::GeoJSONOptions::defaultOptions();
+    if (mbgl::style::Source *source = mapObj->getStyle().getSource(id.toStdString())) {
+        if (auto *sourceGeoJSON = source->as<mbgl::style::GeoJSONSource>()) {
+            options = mbgl::makeMutable<mbgl::style::GeoJSONOptions>(sourceGeoJSON->getOptions());
+        }
+    }
+
+    return [options = std::move(options), simplify = sourceSimplifier(id)](mbgl::GeoJSON geojson) {
+        if (simplify) {
+            simplify(geojson);
+        }
+        return mbgl::style::GeoJSONData::create(geojson, options);
+    };
+}
+
+void MapPrivate::setSourceGeometry(const QString &id,
+                                   std::optional<mbgl::FeatureCollection> collection,
+                                   const std::string &error) {
+    if (!collection) {
+        qWarning() << "Unable to set geometry of source with id" << id << ":" << error.c_str();
+        return;
+    }
+
+    mbgl::GeoJSON geojson{std::move(*collection)};
+    if (const auto simplify = sourceSimplifier(id)) {
+        simplify(geojson);
+    }
+
+    if (!setGeoJSON(id, std::move(geojson))) {
+        qWarning() << "Unable to set geometry of source with id" << id << ": not a GeoJSON source.";
+    }
+}
+
+QFuture<bool> MapPrivate::updateSourceAsync(Map *map, const QString &id, const QVariantMap &params, bool add) {
+    auto promise = std::make_shared<QPromise<bool>>();
+    QFuture<bool> future = promise->future();
+    promise->start();
+
+    const quint64 generation = ++m_sourceGenerations[id];
+
+    auto commit = [this, map, id, params, add, generation, promise](std::optional<mbgl::GeoJSON> data,
+                                                                  const QString &error) {
+        if (m_sourceGenerations.value(id) != generation || promise->isCanceled()) {
+            promise->future().cancel();
+            promise->finish();
+            return;
+        }
+
+        const bool exists = mapObj->getStyle().getSource(id.toStdString()) != nullptr;
+        bool result = false;
+        if (!error.isEmpty()) {
+            qWarning() << "Unable to convert data of source with id" << id << ":" << error;
+        } else if (add && exists) {
+            qWarning() << "Unable to add source with id" << id << ": source already exists.";
+        } else {
+            // The converted data is set below, add or update everything else.
+            QVariantMap sourceParams = params;
+            if (data) {
+                sourceParams[QStringLiteral("data")] =
+                    QByteArrayLiteral(R"({"type":"FeatureCollection","features":[]})");
+            }
+
+            if (!exists) {
+                map->addSource(id, sourceParams);
+            } else {
+                if (data) {
+                    sourceParams.remove(QStringLiteral("data"));
+                }
+                map->updateSource(id, sourceParams);
+            }
+
+            result = mapObj->getStyle().getSource(id.toStdString()) != nullptr;
+            if (result && data) {
+                result = setGeoJSON(id, std::move(*data));
+                if (!result) {
+                    qWarning() << "Unable to update source with id" << id << ": not a GeoJSON source.";
+                }
+            }
+        }
+
+        // Adding or updating the source above superseded this update as well.
+        m_sourceGenerations[id] = generation;
+        promise->addResult(result);
+        promise->finish();
+    };
+
+    // URLs are handed to the source as they are, it loads them itself.
+    if (!params.contains(QStringLiteral("data")) ||
+        params.value(QStringLiteral("data")).typeId() == QMetaType::QString) {
+        commit(std::nullopt, QString());
+        return future;
+    }
+
+    m_threadPool.schedule([context = m_mapThreadContext,
+                           data = params.value(QStringLiteral("data")),
+                           simplify = sourceSimplifier(id),
+                           commit = std::move(commit)] {
+        mbgl::style::conversion::Error error;
+        std::optional<mbgl::GeoJSON> geojson = mbgl::style::conversion::convert<mbgl::GeoJSON>(data, error);
+        if (!geojson && error.message.empty()) {
+            error.message = "invalid data";
+        }
+        if (geojson && simplify) {
+            simplify(*geojson);
+        }
+
+        const std::scoped_lock lock(context->mutex);
+        if (context->object == nullptr) {
+            return;
+        }
+        QMetaObject::invokeMethod(
+            context->object,
+            [commit, geojson = std::make_shared<std::optional<mbgl::GeoJSON>>(std::move(geojson)),
+             error = QString::fromStdString(error.message)] { commit(std::move(*geojson), error); },
+            Qt::QueuedConnection);
+    });
+
+    return future;
+}
+
+void MapPrivate::supersedeSourceUpdates(const QString &id) {
+    const auto it = m_sourceGenerations.find(id);
+    if (it != m_sourceGenerations.end()) {
+        ++it.value();
+    }
+}
+
+void MapPrivate::setSourceSimplification(const QString &id, const Simplification::Options &options) {
+    if (options.tolerance > 0) {
+        m_sourceSimplifications.insert(id, options);
+    } else {
+        m_sourceSimplifications.remove(id);
+    }
+}
+
+std::function<void(mbgl::GeoJSON &)> MapPrivate::sourceSimplifier(const QString &id) const {
+    const auto it = m_sourceSimplifications.constFind(id);
+    if (it == m_sourceSimplifications.constEnd()) {
+        return {};
+    }
+
+    // Helpers never touch the map. The simplifier runs on the pool itself,
+    // holding on to the pool would let one of its workers release the last
+    // reference once the map is gone.
+    return [options = *it, pool = std::weak_ptr<mbgl::Scheduler>(m_backgroundScheduler), tag = m_threadPoolTag](
+               mbgl::GeoJSON &geojson) {
+        Simplification::simplify(geojson, options, [&pool, tag](std::function<void()> task) {
+            if (const std::shared_ptr<mbgl::Scheduler> scheduler = pool.lock()) {
+                scheduler->schedule(tag, std::move(task));
+            } else {
+                task();
+            }
+        });
+    };
 }
 
 bool MapPrivate::setProperty(const PropertySetter &setter,
@@ -1999,7 +3064,7 @@ bool MapPrivate::setProperty(const PropertySetter &setter,
             result = (layer->*setter)(propertyString, value);
         }
     } else {
-        result = (layer->*setter)(propertyString, value);
+        result = (layer->*setter)(propertyString, mbgl::style::conversion::normalized(value));
     }
 
     if (result) {
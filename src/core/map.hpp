@@ -10,6 +10,7 @@
 #include <QMapLibre/Settings>
 #include <QMapLibre/Types>
 
+#include <QtCore/QFuture>
 #include <QtCore/QMargins>
 #include <QtCore/QObject>
 #include <QtCore/QPointF>
@@ -20,6 +21,10 @@
 
 #include <memory>
 
+QT_BEGIN_NAMESPACE
+class QIODevice;
+QT_END_NAMESPACE
+
 #ifdef MLN_RENDER_BACKEND_VULKAN
 namespace mbgl::vulkan {
 class Texture2D;
@@ -61,7 +66,8 @@ public:
         MapChangeDidFinishRenderingMap,
         MapChangeDidFinishRenderingMapFullyRendered,
         MapChangeDidFinishLoadingStyle,
-        MapChangeSourceDidChange
+        MapChangeSourceDidChange,
+        MapChangeDidBecomeIdle
     };
 
     enum MapLoadingFailure {
@@ -79,6 +85,12 @@ public:
         NorthLeftwards,
     };
 
+    // Algorithms for simplifying source geometry.
+    enum SimplificationAlgorithm {
+        DouglasPeucker,
+        VisvalingamWhyatt
+    };
+
     explicit Map(QObject *parent = nullptr,
                  const Settings &settings = Settings(),
                  const QSize &size = QSize(),
@@ -161,6 +173,41 @@ public:
     void addSource(const QString &id, const QVariantMap &params);
     bool sourceExists(const QString &id);
     void updateSource(const QString &id, const QVariantMap &params);
+    QFuture<bool> addSourceAsync(const QString &id, const QVariantMap &params);
+    QFuture<bool> updateSourceAsync(const QString &id, const QVariantMap &params);
+    void setSourceGeometry(const QString &id,
+                           Feature::Type type,
+                           const QVector<double> &coordinates,
+                           const QVector<qsizetype> &featureOffsets,
+                           const QVector<qsizetype> &partOffsets = QVector<qsizetype>(),
+                           const QVector<qsizetype> &ringOffsets = QVector<qsizetype>(),
+                           const QVector<PropertyColumn> &properties = QVector<PropertyColumn>());
+    void setSourceGeometryFloat(const QString &id,
+                                Feature::Type type,
+                                const QVector<float> &coordinates,
+                                const QVector<qsizetype> &featureOffsets,
+                                const QVector<qsizetype> &partOffsets = QVector<qsizetype>(),
+                                const QVector<qsizetype> &ringOffsets = QVector<qsizetype>(),
+                                const QVector<PropertyColumn> &properties = QVector<PropertyColumn>());
+    void setSourceGeometryQuantized(const QString &id,
+                                    Feature::Type type,
+                                    const QVector<qint32> &coordinates,
+                                    const CoordinateQuantization &quantization,
+                                    const QVector<qsizetype> &featureOffsets,
+                                    const QVector<qsizetype> &partOffsets = QVector<qsizetype>(),
+                                    const QVector<qsizetype> &ringOffsets = QVector<qsizetype>(),
+                                    const QVector<PropertyColumn> &properties = QVector<PropertyColumn>());
+    void updateSourceFeatures(const QString &id,
+                              const QList<Feature> &added,
+                              const QList<Feature> &updated = QList<Feature>(),
+                              const QVariantList &removedIds = QVariantList());
+    void loadSourceData(const QString &id, const QString &path);
+    void loadSourceData(const QString &id, const QString &path, const Coordinate &sw, const Coordinate &ne);
+    void loadSourceData(const QString &id, QIODevice *device);
+    void cancelSourceDataLoad(const QString &id);
+    void setSourceSimplification(const QString &id,
+                                 double tolerance,
+                                 SimplificationAlgorithm algorithm = DouglasPeucker);
     void removeSource(const QString &id);
 
     void addImage(const QString &id, const QImage &sprite);
@@ -186,10 +233,22 @@ public:
                                           void *physicalDevice,
                                           void *device,
                                           uint32_t graphicsQueueIndex);
+#endif
+#ifdef MLN_QT_WITH_HEADLESS
+    // Renders into an offscreen framebuffer without a window.
+    bool createHeadlessRenderer();
 #endif
     void updateRenderer(const QSize &size, qreal pixelRatio, quint32 fbo = 0);
     void destroyRenderer();
 
+    [[nodiscard]] SchedulerStatistics schedulerStatistics() const;
+    [[nodiscard]] ThreadPoolStatistics backgroundPoolStatistics() const;
+    [[nodiscard]] FramePacerStatistics framePacerStatistics() const;
+    [[nodiscard]] MapStatistics statistics() const;
+
+    void setMapChangeEnabled(MapChange change, bool enabled);
+    [[nodiscard]] bool isMapChangeEnabled(MapChange change) const;
+
     void setCurrentDrawable(void *texturePtr);
     void setExternalDrawable(void *texturePtr, const QSize &textureSize);
 
@@ -204,6 +263,13 @@ public:
 #ifdef MLN_RENDER_BACKEND_OPENGL
     // OpenGL-specific: get the OpenGL framebuffer texture ID for direct texture sharing.
     [[nodiscard]] unsigned int getFramebufferTextureId() const;
+
+    // OpenGL-specific: render a frame and read it back.
+    [[nodiscard]] QImage grabFrame();
+#endif
+
+#if defined(MLN_RENDER_BACKEND_OPENGL) || defined(MLN_RENDER_BACKEND_VULKAN)
+    [[nodiscard]] QFuture<QImage> grabFrameAsync();
 #endif
 
 public slots:
@@ -220,11 +286,18 @@ public slots:
 signals:
     void needsRendering();
     void mapChanged(Map::MapChange);
+    void cameraChanged();
     void mapLoadingFailed(Map::MapLoadingFailure, const QString &reason);
     void copyrightsChanged(const QString &copyrightsHtml);
 
     void staticRenderFinished(const QString &error);
 
+    void statisticsUpdated(const QMapLibre::MapStatistics &statistics);
+
+    void sourceDataLoadProgress(const QString &id, qint64 bytesRead, qint64 bytesTotal);
+    void sourceDataLoaded(const QString &id);
+    void sourceDataLoadFailed(const QString &id, const QString &error);
+
 private:
     Q_DISABLE_COPY(Map)
 
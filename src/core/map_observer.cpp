@@ -20,36 +20,60 @@ MapObserver::MapObserver(MapPrivate *ptr)
 
 MapObserver::~MapObserver() = default;
 
+void MapObserver::setMapChangeEnabled(Map::MapChange change, bool enabled) {
+    const quint32 bit = 1U << change;
+    if (enabled) {
+        m_enabledChanges.fetch_or(bit, std::memory_order_relaxed);
+    } else {
+        m_enabledChanges.fetch_and(~bit, std::memory_order_relaxed);
+    }
+}
+
+bool MapObserver::isMapChangeEnabled(Map::MapChange change) const {
+    return (m_enabledChanges.load(std::memory_order_relaxed) & (1U << change)) != 0;
+}
+
+void MapObserver::notify(Map::MapChange change) {
+    if (isMapChangeEnabled(change)) {
+        emit mapChanged(change);
+    }
+}
+
 void MapObserver::onCameraWillChange(mbgl::MapObserver::CameraChangeMode mode) {
+    m_cameraChanged = true;
+
     if (mode == mbgl::MapObserver::CameraChangeMode::Immediate) {
-        emit mapChanged(Map::MapChangeRegionWillChange);
+        notify(Map::MapChangeRegionWillChange);
     } else {
-        emit mapChanged(Map::MapChangeRegionWillChangeAnimated);
+        notify(Map::MapChangeRegionWillChangeAnimated);
     }
 }
 
 void MapObserver::onCameraIsChanging() {
-    emit mapChanged(Map::MapChangeRegionIsChanging);
+    m_cameraChanged = true;
+    notify(Map::MapChangeRegionIsChanging);
 }
 
 void MapObserver::onCameraDidChange(mbgl::MapObserver::CameraChangeMode mode) {
+    m_cameraChanged = true;
+
     if (mode == mbgl::MapObserver::CameraChangeMode::Immediate) {
-        emit mapChanged(Map::MapChangeRegionDidChange);
+        notify(Map::MapChangeRegionDidChange);
     } else {
-        emit mapChanged(Map::MapChangeRegionDidChangeAnimated);
+        notify(Map::MapChangeRegionDidChangeAnimated);
     }
 }
 
 void MapObserver::onWillStartLoadingMap() {
-    emit mapChanged(Map::MapChangeWillStartLoadingMap);
+    notify(Map::MapChangeWillStartLoadingMap);
 }
 
 void MapObserver::onDidFinishLoadingMap() {
-    emit mapChanged(Map::MapChangeDidFinishLoadingMap);
+    notify(Map::MapChangeDidFinishLoadingMap);
 }
 
 void MapObserver::onDidFailLoadingMap(mbgl::MapLoadError error, const std::string &what) {
-    emit mapChanged(Map::MapChangeDidFailLoadingMap);
+    notify(Map::MapChangeDidFailLoadingMap);
 
     Map::MapLoadingFailure type = Map::MapLoadingFailure::UnknownFailure;
     const QString description(what.c_str());
@@ -72,31 +96,41 @@ void MapObserver::onDidFailLoadingMap(mbgl::MapLoadError error, const std::strin
 }
 
 void MapObserver::onWillStartRenderingFrame() {
-    emit mapChanged(Map::MapChangeWillStartRenderingFrame);
+    notify(Map::MapChangeWillStartRenderingFrame);
 }
 
 void MapObserver::onDidFinishRenderingFrame(const mbgl::MapObserver::RenderFrameStatus &status) {
     if (status.mode == mbgl::MapObserver::RenderMode::Partial) {
-        emit mapChanged(Map::MapChangeDidFinishRenderingFrame);
+        notify(Map::MapChangeDidFinishRenderingFrame);
     } else {
-        emit mapChanged(Map::MapChangeDidFinishRenderingFrameFullyRendered);
+        notify(Map::MapChangeDidFinishRenderingFrameFullyRendered);
+    }
+
+    // At most once per frame, however often the camera moved in between.
+    if (m_cameraChanged) {
+        m_cameraChanged = false;
+        emit cameraChanged();
     }
 }
 
 void MapObserver::onWillStartRenderingMap() {
-    emit mapChanged(Map::MapChangeWillStartRenderingMap);
+    notify(Map::MapChangeWillStartRenderingMap);
 }
 
 void MapObserver::onDidFinishRenderingMap(mbgl::MapObserver::RenderMode mode) {
     if (mode == mbgl::MapObserver::RenderMode::Partial) {
-        emit mapChanged(Map::MapChangeDidFinishRenderingMap);
+        notify(Map::MapChangeDidFinishRenderingMap);
     } else {
-        emit mapChanged(Map::MapChangeDidFinishRenderingMapFullyRendered);
+        notify(Map::MapChangeDidFinishRenderingMapFullyRendered);
     }
 }
 
 void MapObserver::onDidFinishLoadingStyle() {
-    emit mapChanged(Map::MapChangeDidFinishLoadingStyle);
+    notify(Map::MapChangeDidFinishLoadingStyle);
+}
+
+void MapObserver::onDidBecomeIdle() {
+    notify(Map::MapChangeDidBecomeIdle);
 }
 
 void MapObserver::onSourceChanged(mbgl::style::Source & /* source */) {
@@ -109,7 +143,7 @@ void MapObserver::onSourceChanged(mbgl::style::Source & /* source */) {
         }
     }
     emit copyrightsChanged(QString::fromStdString(attribution));
-    emit mapChanged(Map::MapChangeSourceDidChange);
+    notify(Map::MapChangeSourceDidChange);
 }
 
 /*! \endcond */
@@ -12,6 +12,7 @@
 
 #include <QtCore/QObject>
 
+#include <atomic>
 #include <exception>
 #include <memory>
 
@@ -26,6 +27,10 @@ public:
     explicit MapObserver(MapPrivate *ptr);
     ~MapObserver() override;
 
+    // Thread-safe.
+    void setMapChangeEnabled(Map::MapChange change, bool enabled);
+    [[nodiscard]] bool isMapChangeEnabled(Map::MapChange change) const;
+
     // mbgl::MapObserver implementation.
     void onCameraWillChange(mbgl::MapObserver::CameraChangeMode mode) final;
     void onCameraIsChanging() final;
@@ -38,17 +43,24 @@ public:
     void onWillStartRenderingMap() final;
     void onDidFinishRenderingMap(mbgl::MapObserver::RenderMode mode) final;
     void onDidFinishLoadingStyle() final;
+    void onDidBecomeIdle() final;
     void onSourceChanged(mbgl::style::Source &source) final;
 
 signals:
     void mapChanged(Map::MapChange);
+    void cameraChanged();
     void mapLoadingFailed(Map::MapLoadingFailure, const QString &reason);
     void copyrightsChanged(const QString &copyrightsHtml);
 
 private:
     Q_DISABLE_COPY(MapObserver)
 
+    void notify(Map::MapChange change);
+
     MapPrivate *d_ptrRef;
+
+    std::atomic<quint32> m_enabledChanges{~0U};
+    bool m_cameraChanged{};
 };
 
 } // namespace QMapLibre
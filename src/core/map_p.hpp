@@ -5,10 +5,20 @@
 
 #pragma once
 
+#include "frame_pacer_p.hpp"
+#include "geojson_loader_p.hpp"
+#include "geojson_p.hpp"
 #include "map.hpp"
 #include "map_observer_p.hpp"
 #include "map_renderer_p.hpp"
 #include "rendering/renderer_observer_p.hpp"
+#include "simplification_p.hpp"
+#include "task_statistics_p.hpp"
+#include "thread_pool_p.hpp"
+
+#ifdef MLN_QT_WITH_HEADLESS
+#include "rendering/headless_context_p.hpp"
+#endif
 
 #include <mbgl/actor/actor.hpp>
 #include <mbgl/actor/scheduler.hpp>
@@ -17,11 +27,22 @@
 #include <mbgl/storage/resource_transform.hpp>
 #include <mbgl/util/geo.hpp>
 
+#include <QtCore/QFuture>
+#include <QtCore/QHash>
 #include <QtCore/QObject>
+#include <QtCore/QPromise>
 #include <QtCore/QSize>
+#include <QtCore/QTimer>
 
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace QMapLibre {
 
@@ -45,10 +66,31 @@ public:
                                           void *physicalDevice,
                                           void *device,
                                           uint32_t graphicsQueueIndex);
+#endif
+#ifdef MLN_QT_WITH_HEADLESS
+    bool createHeadlessRenderer();
 #endif
     void updateRenderer(const QSize &size, qreal pixelRatio, quint32 fbo = 0);
     void destroyRenderer();
     void render();
+#ifdef MLN_RENDER_BACKEND_OPENGL
+    QImage grabFrame();
+#endif
+#if defined(MLN_RENDER_BACKEND_OPENGL) || defined(MLN_RENDER_BACKEND_VULKAN)
+    QFuture<QImage> grabFrameAsync();
+#endif
+
+    [[nodiscard]] SchedulerStatistics schedulerStatistics() const;
+    [[nodiscard]] ThreadPoolStatistics backgroundPoolStatistics() const;
+    [[nodiscard]] FramePacerStatistics framePacerStatistics() const;
+    [[nodiscard]] MapStatistics statistics() const;
+
+    void setMapChangeEnabled(Map::MapChange change, bool enabled) {
+        m_mapObserver->setMapChangeEnabled(change, enabled);
+    }
+    [[nodiscard]] bool isMapChangeEnabled(Map::MapChange change) const {
+        return m_mapObserver->isMapChangeEnabled(change);
+    }
 
     using PropertySetter = std::optional<mbgl::style::conversion::Error> (mbgl::style::Layer::*)(
         const std::string &, const mbgl::style::conversion::Convertible &);
@@ -60,6 +102,34 @@ public:
     mbgl::EdgeInsets margins;
     std::unique_ptr<mbgl::Map> mapObj;
 
+    // GeoJSON sources managed by Map::updateSourceFeatures().
+    std::unordered_map<std::string, GeoJSON::FeatureSet> featureSets;
+
+    // Replaces the data of a GeoJSON source, adding it if it does not exist.
+    bool setGeoJSON(const QString &id, mbgl::GeoJSON geojson);
+    bool setGeoJSONData(const QString &id, std::shared_ptr<mbgl::style::GeoJSONData> data);
+    // Simplifies and tiles data for the source on any thread, with the
+    // options the source has when called.
+    [[nodiscard]] GeoJSONLoader::Index sourceIndexer(const QString &id) const;
+    // Simplifies and sets features built by Map::setSourceGeometry(), warns
+    // with error if there are none.
+    void setSourceGeometry(const QString &id,
+                           std::optional<mbgl::FeatureCollection> collection,
+                           const std::string &error);
+    std::unique_ptr<GeoJSONLoader> geojsonLoader;
+
+    // Converts the source data on the background pool and commits the source
+    // on the map thread, see Map::updateSourceAsync().
+    QFuture<bool> updateSourceAsync(Map *map, const QString &id, const QVariantMap &params, bool add);
+    // Makes asynchronous updates of the source in flight obsolete.
+    void supersedeSourceUpdates(const QString &id);
+
+    // See Map::setSourceSimplification(). The simplifier is empty if the
+    // source is not simplified and can be called on any thread, also after
+    // the map is gone.
+    void setSourceSimplification(const QString &id, const Simplification::Options &options);
+    [[nodiscard]] std::function<void(mbgl::GeoJSON &)> sourceSimplifier(const QString &id) const;
+
     // Backend-specific helpers to expose the most recent color texture
     // Safe to call from the GUI thread.
     void *currentDrawableTexture() const;
@@ -89,20 +159,76 @@ private:
 
     mutable std::recursive_mutex m_mapRendererMutex;
     std::unique_ptr<RendererObserver> m_rendererObserver;
-    std::shared_ptr<mbgl::UpdateParameters> m_updateParameters;
+    // Written on the map thread, read on the render thread.
+    std::shared_ptr<UpdateParametersBuffer> m_updateParameters{std::make_shared<UpdateParametersBuffer>()};
 
     std::unique_ptr<MapObserver> m_mapObserver;
+#ifdef MLN_QT_WITH_HEADLESS
+    // Makes the headless context current and sizes its framebuffer.
+    bool prepareHeadlessFrame();
+
+    // Owns the context the renderer draws with when there is no window.
+    std::unique_ptr<HeadlessContext> m_headlessContext;
+    // Map size the headless framebuffer was last set up for.
+    mbgl::Size m_headlessSize;
+    float m_headlessPixelRatio{};
+#endif
     std::unique_ptr<MapRenderer> m_mapRenderer;
+#if defined(MLN_RENDER_BACKEND_OPENGL) || defined(MLN_RENDER_BACKEND_VULKAN)
+    // Starts the reads requested since the last frame and delivers finished ones.
+    void readFrames();
+    // Cancels the reads requested since the last frame.
+    void cancelFrameRequests();
+
+    std::mutex m_frameRequestsMutex;
+    std::vector<QPromise<QImage>> m_frameRequests;
+#endif
     std::unique_ptr<mbgl::Actor<mbgl::ResourceTransform::TransformCallback>> m_resourceTransform;
 
     Settings::GLContextMode m_mode;
     qreal m_pixelRatio;
 
     QString m_localFontFamily;
-
-    std::atomic_flag m_renderQueued = ATOMIC_FLAG_INIT;
-
-    mbgl::TaggedScheduler m_threadPool{mbgl::Scheduler::GetBackground(), mbgl::util::SimpleIdentity{}};
+    std::chrono::milliseconds m_renderTaskBudget{};
+    std::chrono::milliseconds m_statisticsInterval{};
+
+    std::unique_ptr<FramePacer> m_framePacer;
+
+    // The render thread's counters, published after each frame so that
+    // readers never wait for the renderer mutex a frame holds.
+    struct RendererStatistics {
+        std::atomic<quint64> pendingTasks{0};
+        std::atomic<quint64> processedTasks{0};
+        std::atomic<quint64> deferredTasks{0};
+        std::atomic<quint64> exhaustedBudgets{0};
+    };
+    void publishRendererStatistics();
+
+    RendererStatistics m_rendererStatistics;
+    // Kept when the renderer is destroyed, guarded by its own mutex.
+    mutable std::mutex m_renderThreadStatisticsMutex;
+    std::shared_ptr<TaskStatistics> m_renderThreadStatistics;
+
+    // Only set up when statistics are collected.
+    std::shared_ptr<TaskStatistics> m_runLoopStatistics;
+    QTimer m_runLoopProbe;
+    QTimer m_statisticsTimer;
+
+    // Lets background tasks post to the map thread for as long as it exists.
+    struct MapThreadContext {
+        std::mutex mutex;
+        QObject *object{};
+    };
+    std::shared_ptr<MapThreadContext> m_mapThreadContext{std::make_shared<MapThreadContext>()};
+    QHash<QString, quint64> m_sourceGenerations;
+    QHash<QString, Simplification::Options> m_sourceSimplifications;
+
+    // Null when the default MapLibre pool is used.
+    std::shared_ptr<ThreadPool> m_backgroundPool;
+    // The pool in use, either the one above or the default one.
+    std::shared_ptr<mbgl::Scheduler> m_backgroundScheduler;
+    const mbgl::util::SimpleIdentity m_threadPoolTag;
+    mbgl::TaggedScheduler m_threadPool;
 };
 
 } // namespace QMapLibre
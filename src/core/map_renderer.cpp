@@ -119,14 +119,24 @@ MapRenderer::MapRenderer(qreal pixelRatio,
 }
 #endif
 
-MapRenderer::~MapRenderer() = default;
+MapRenderer::~MapRenderer() {
+    if (m_taskStatistics != nullptr) {
+        m_taskStatistics->disable();
+    }
+}
 // MapRenderer may be destroyed from the GUI thread after the render thread is
 // already shut down, so the thread identity might differ from creation
 // time. Skip the thread guard here to avoid false assertion failures.
 
-void MapRenderer::updateParameters(std::shared_ptr<mbgl::UpdateParameters> parameters) {
-    const std::scoped_lock lock(m_updateMutex);
-    m_updateParameters = std::move(parameters);
+void MapRenderer::enableTaskStatistics() {
+    MBGL_VERIFY_THREAD(tid);
+
+    if (!m_forceScheduler || m_taskStatistics != nullptr) {
+        return;
+    }
+
+    m_taskStatistics = getScheduler()->taskStatistics();
+    m_taskStatistics->enable();
 }
 
 void MapRenderer::updateRenderer(const mbgl::Size &size, qreal pixelRatio, quint32 fbo) {
@@ -142,31 +152,75 @@ void MapRenderer::updateRenderer(const mbgl::Size &size, qreal pixelRatio, quint
 void MapRenderer::render() {
     MBGL_VERIFY_THREAD(tid);
 
-    std::shared_ptr<mbgl::UpdateParameters> params;
-    {
-        // Lock on the parameters
-        const std::scoped_lock lock(m_updateMutex);
-
-        // UpdateParameters should always be available when rendering.
-        if (m_updateParameters == nullptr) {
-            return;
-        }
+    // UpdateParameters should always be available when rendering.
+    if (m_updateParameters == nullptr) {
+        return;
+    }
 
-        // Hold on to the update parameters during render
-        params = m_updateParameters;
+    // Pick up the latest parameters, the current ones are kept otherwise.
+    m_updateParameters->update();
+    const std::shared_ptr<mbgl::UpdateParameters> &params = m_updateParameters->front();
+    if (params == nullptr) {
+        return;
     }
 
     // The OpenGL implementation automatically enables the OpenGL context for us.
     // For Vulkan, we need to ensure the backend is properly initialized
     const mbgl::gfx::BackendScope scope(m_backend, mbgl::gfx::BackendScope::ScopeType::Implicit);
 
+#if defined(MLN_RENDER_BACKEND_OPENGL)
+    m_backend.beginFrame();
     m_renderer->render(params);
+    m_backend.endFrame();
+#else
+    m_renderer->render(params);
+#endif
 
     if (m_forceScheduler) {
-        getScheduler()->processEvents();
+        Scheduler *scheduler = getScheduler();
+        scheduler->processEvents(m_taskBudget);
+        m_schedulerStatistics = scheduler->statistics();
     }
 }
 
+#if defined(MLN_RENDER_BACKEND_OPENGL)
+QImage MapRenderer::readFramebuffer() {
+    MBGL_VERIFY_THREAD(tid);
+
+    const mbgl::gfx::BackendScope scope(m_backend, mbgl::gfx::BackendScope::ScopeType::Implicit);
+
+    // The pixels are handed over to the image without a copy.
+    mbgl::PremultipliedImage image = m_backend.readFramebuffer();
+    if (!image.valid()) {
+        return {};
+    }
+
+    uint8_t *data = image.data.release();
+    return {data,
+            static_cast<int>(image.size.width),
+            static_cast<int>(image.size.height),
+            QImage::Format_RGBA8888_Premultiplied,
+            [](void *pixels) { delete[] static_cast<uint8_t *>(pixels); },
+            data};
+}
+#endif
+
+#if defined(MLN_RENDER_BACKEND_OPENGL) || defined(MLN_RENDER_BACKEND_VULKAN)
+void MapRenderer::readFramebufferAsync(std::vector<QPromise<QImage>> promises) {
+    MBGL_VERIFY_THREAD(tid);
+
+    const mbgl::gfx::BackendScope scope(m_backend, mbgl::gfx::BackendScope::ScopeType::Implicit);
+    m_frameReader.read(std::move(promises));
+}
+
+bool MapRenderer::collectFrames() {
+    MBGL_VERIFY_THREAD(tid);
+
+    const mbgl::gfx::BackendScope scope(m_backend, mbgl::gfx::BackendScope::ScopeType::Implicit);
+    return m_frameReader.collect();
+}
+#endif
+
 void MapRenderer::setObserver(mbgl::RendererObserver *observer) {
     m_renderer->setObserver(observer);
 }
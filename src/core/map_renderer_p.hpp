@@ -6,6 +6,9 @@
 #pragma once
 
 #include "settings.hpp"
+#include "task_statistics_p.hpp"
+#include "triple_buffer_p.hpp"
+#include "types.hpp"
 
 #include "rendering/renderer_backend_p.hpp" // provides RendererBackend alias
 
@@ -14,9 +17,12 @@
 #include <mbgl/util/util.hpp>
 
 #include <QtCore/QObject>
+#include <QtCore/QPromise>
+#include <QtGui/QImage>
 
+#include <chrono>
 #include <memory>
-#include <mutex>
+#include <vector>
 
 namespace mbgl {
 class Renderer;
@@ -28,6 +34,8 @@ class Texture2D;
 
 namespace QMapLibre {
 
+using UpdateParametersBuffer = TripleBuffer<std::shared_ptr<mbgl::UpdateParameters>>;
+
 class MapRenderer : public QObject {
     Q_OBJECT
 
@@ -55,8 +63,24 @@ public:
     void updateRenderer(const mbgl::Size &size, qreal pixelRatio, quint32 fbo = 0);
     void setObserver(mbgl::RendererObserver *observer);
 
-    // Thread-safe, called by the Frontend
-    void updateParameters(std::shared_ptr<mbgl::UpdateParameters> parameters);
+    // Time spent on scheduled tasks after each frame, unlimited by default.
+    void setTaskBudget(std::chrono::nanoseconds budget) { m_taskBudget = budget; }
+    [[nodiscard]] const SchedulerStatistics &schedulerStatistics() const { return m_schedulerStatistics; }
+    // Measures the tasks run after each frame, until the renderer is destroyed.
+    void enableTaskStatistics();
+    [[nodiscard]] const std::shared_ptr<TaskStatistics> &taskStatistics() const { return m_taskStatistics; }
+
+    // Written by the Frontend, read on each render() without locking.
+    void setUpdateParameters(std::shared_ptr<UpdateParametersBuffer> parameters) {
+        m_updateParameters = std::move(parameters);
+    }
+
+#if defined(MLN_RENDER_BACKEND_OPENGL) || defined(MLN_RENDER_BACKEND_VULKAN)
+    // Starts reading back the frame rendered last, see Map::grabFrameAsync().
+    void readFramebufferAsync(std::vector<QPromise<QImage>> promises);
+    // Delivers the frames read back by now, returns true if reads are pending.
+    bool collectFrames();
+#endif
 
     // Backend-specific helpers
 #if defined(MLN_RENDER_BACKEND_METAL) || defined(MLN_RENDER_BACKEND_VULKAN)
@@ -77,6 +101,10 @@ public:
 
     // Helper method to get the OpenGL framebuffer texture ID for direct texture sharing
     [[nodiscard]] unsigned int getFramebufferTextureId() const { return m_backend.getFramebufferTextureId(); }
+    [[nodiscard]] quint64 takeColorTargetWaits() { return m_backend.takeColorTargetWaits(); }
+
+    // Reads back the last rendered frame, waiting for the GPU to finish it.
+    [[nodiscard]] QImage readFramebuffer();
 #endif
 
 signals:
@@ -87,13 +115,18 @@ private:
 
     Q_DISABLE_COPY(MapRenderer)
 
-    std::mutex m_updateMutex;
-    std::shared_ptr<mbgl::UpdateParameters> m_updateParameters;
+    std::shared_ptr<UpdateParametersBuffer> m_updateParameters;
 
     RendererBackend m_backend;
+#if defined(MLN_RENDER_BACKEND_OPENGL) || defined(MLN_RENDER_BACKEND_VULKAN)
+    FrameReader m_frameReader{m_backend};
+#endif
     std::unique_ptr<mbgl::Renderer> m_renderer;
 
     bool m_forceScheduler{};
+    std::chrono::nanoseconds m_taskBudget{std::chrono::nanoseconds::max()};
+    SchedulerStatistics m_schedulerStatistics;
+    std::shared_ptr<TaskStatistics> m_taskStatistics;
 };
 
 } // namespace QMapLibre
@@ -0,0 +1,101 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace QMapLibre {
+
+/*! \cond PRIVATE */
+
+// Unbounded multi-producer single-consumer queue based on the intrusive
+// node-based design by Dmitry Vyukov. push() never blocks and can be called
+// from any thread, pop() must only be called from the consuming thread.
+//
+// pop() can transiently report an empty queue while a producer is between
+// swapping the head and linking its node. The item becomes visible as soon as
+// that producer finishes, so consumers must not treat an empty pop() as proof
+// that nothing has been pushed.
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue()
+        : m_head(&m_stub),
+          m_tail(&m_stub) {}
+    ~MpscQueue() {
+        while (pop()) {
+        }
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+    MpscQueue(MpscQueue &&) = delete;
+    MpscQueue &operator=(MpscQueue &&) = delete;
+
+    void push(T value) { pushNode(new Node{std::move(value), {}}); }
+
+    std::optional<T> pop() {
+        Node *tail = m_tail;
+        Node *next = tail->next.load(std::memory_order_acquire);
+
+        if (tail == &m_stub) {
+            if (next == nullptr) {
+                return std::nullopt;
+            }
+
+            m_tail = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (next != nullptr) {
+            return take(tail, next);
+        }
+
+        if (tail != m_head.load(std::memory_order_acquire)) {
+            // A producer is linking a new node.
+            return std::nullopt;
+        }
+
+        // Re-insert the stub so the last real node can be released.
+        m_stub.next.store(nullptr, std::memory_order_relaxed);
+        pushNode(&m_stub);
+
+        next = tail->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            return take(tail, next);
+        }
+
+        return std::nullopt;
+    }
+
+private:
+    struct Node {
+        T value;
+        std::atomic<Node *> next;
+    };
+
+    void pushNode(Node *node) {
+        Node *previous = m_head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    std::optional<T> take(Node *node, Node *next) {
+        m_tail = next;
+        std::optional<T> value{std::move(node->value)};
+        delete node;
+        return value;
+    }
+
+    Node m_stub{};
+    std::atomic<Node *> m_head;
+    Node *m_tail;
+};
+
+/*! \endcond PRIVATE */
+
+} // namespace QMapLibre
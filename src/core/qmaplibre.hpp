@@ -5,5 +5,7 @@
 #include "export_core.hpp"
 #include "map.hpp"
 #include "settings.hpp"
+#include "threaded_map_renderer.hpp"
+#include "tile_renderer.hpp"
 #include "types.hpp"
 #include "utils.hpp"
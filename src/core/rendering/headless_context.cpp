@@ -0,0 +1,45 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "headless_context_p.hpp"
+
+#include <QtCore/QDebug>
+#include <QtGui/QGuiApplication>
+#include <QtGui/QOpenGLFunctions>
+
+namespace QMapLibre {
+
+/*! \cond PRIVATE */
+
+HeadlessContext::HeadlessContext() {
+    if (qobject_cast<QGuiApplication *>(QCoreApplication::instance()) == nullptr) {
+        qWarning() << "Headless rendering requires a QGuiApplication.";
+        return;
+    }
+
+    // The renderer attaches its own depth and stencil buffers to the
+    // framebuffer, the surface only has to make the context current.
+    m_surface.create();
+    if (!m_surface.isValid() || !m_context.create() || !makeCurrent()) {
+        qWarning() << "Unable to create an offscreen OpenGL context.";
+        return;
+    }
+
+    m_context.functions()->glGenFramebuffers(1, &m_framebuffer);
+}
+
+HeadlessContext::~HeadlessContext() {
+    if (m_framebuffer != 0 && makeCurrent()) {
+        m_context.functions()->glDeleteFramebuffers(1, &m_framebuffer);
+        m_context.doneCurrent();
+    }
+}
+
+bool HeadlessContext::makeCurrent() {
+    return m_context.makeCurrent(&m_surface);
+}
+
+/*! \endcond */
+
+} // namespace QMapLibre
@@ -0,0 +1,38 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/qopengl.h>
+
+namespace QMapLibre {
+
+/*! \cond PRIVATE */
+
+// OpenGL context with an offscreen surface and a framebuffer to render into,
+// for rendering without a window. Needs a QGuiApplication and has to be
+// created on the GUI thread.
+class HeadlessContext {
+public:
+    HeadlessContext();
+    ~HeadlessContext();
+
+    [[nodiscard]] bool isValid() const { return m_framebuffer != 0; }
+    [[nodiscard]] GLuint framebuffer() const { return m_framebuffer; }
+
+    bool makeCurrent();
+
+private:
+    Q_DISABLE_COPY(HeadlessContext)
+
+    QOffscreenSurface m_surface;
+    QOpenGLContext m_context;
+    GLuint m_framebuffer{};
+};
+
+/*! \endcond */
+
+} // namespace QMapLibre
@@ -0,0 +1,185 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "opengl_frame_reader_p.hpp"
+#include "opengl_renderer_backend_p.hpp"
+
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLExtraFunctions>
+
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace {
+
+constexpr qsizetype BytesPerPixel = 4;
+
+QOpenGLExtraFunctions *functions() {
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    return context != nullptr ? context->extraFunctions() : nullptr;
+}
+
+void deliver(std::vector<QPromise<QImage>> &promises, const QImage &image) {
+    for (auto &promise : promises) {
+        if (image.isNull()) {
+            promise.future().cancel();
+        } else {
+            promise.addResult(image);
+        }
+        promise.finish();
+    }
+    promises.clear();
+}
+
+} // namespace
+
+namespace QMapLibre {
+
+/*! \cond PRIVATE */
+
+OpenGLFrameReader::OpenGLFrameReader(OpenGLRendererBackend &backend)
+    : m_backend(backend) {}
+
+OpenGLFrameReader::~OpenGLFrameReader() {
+    QOpenGLExtraFunctions *gl = functions();
+    for (auto &slot : m_slots) {
+        if (gl != nullptr) {
+            if (slot.fence != nullptr) {
+                gl->glDeleteSync(slot.fence);
+            }
+            if (slot.buffer != 0) {
+                gl->glDeleteBuffers(1, &slot.buffer);
+            }
+        }
+        deliver(slot.promises, QImage());
+    }
+}
+
+void OpenGLFrameReader::read(std::vector<QPromise<QImage>> promises) {
+    QOpenGLExtraFunctions *gl = functions();
+    if (gl == nullptr) {
+        deliver(promises, QImage());
+        return;
+    }
+
+    if (!isSupported()) {
+        mbgl::PremultipliedImage image = m_backend.readFramebuffer();
+        QImage frame(static_cast<int>(image.size.width),
+                     static_cast<int>(image.size.height),
+                     QImage::Format_RGBA8888_Premultiplied);
+        if (image.valid()) {
+            std::memcpy(frame.bits(), image.data.get(), image.bytes());
+        }
+        deliver(promises, image.valid() ? frame : QImage());
+        return;
+    }
+
+    Slot &slot = m_slots[m_next];
+    m_next = (m_next + 1) % RingSize;
+
+    // All buffers are in flight, the oldest read has to finish first.
+    if (slot.fence != nullptr) {
+        gl->glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, std::numeric_limits<GLuint64>::max());
+        finish(slot);
+    }
+
+    slot.size = m_backend.getSize();
+    const qsizetype bytes = static_cast<qsizetype>(slot.size.area()) * BytesPerPixel;
+    if (bytes == 0) {
+        deliver(promises, QImage());
+        return;
+    }
+
+    if (slot.buffer == 0) {
+        gl->glGenBuffers(1, &slot.buffer);
+    }
+    gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    if (slot.capacity < bytes) {
+        gl->glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        slot.capacity = bytes;
+    }
+
+    // With a pack buffer bound the pixels go into the buffer, the call
+    // returns without waiting for the frame.
+    m_backend.restoreFramebufferBinding();
+    gl->glReadPixels(0,
+                     0,
+                     static_cast<GLsizei>(slot.size.width),
+                     static_cast<GLsizei>(slot.size.height),
+                     GL_RGBA,
+                     GL_UNSIGNED_BYTE,
+                     nullptr);
+    gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // Nothing swaps buffers offscreen, make sure the fence reaches the GPU.
+    gl->glFlush();
+    slot.promises = std::move(promises);
+}
+
+bool OpenGLFrameReader::collect() {
+    QOpenGLExtraFunctions *gl = functions();
+    if (gl == nullptr) {
+        return false;
+    }
+
+    bool pending = false;
+    // Oldest first, so frames are delivered in order.
+    for (std::size_t i = 0; i < RingSize; ++i) {
+        Slot &slot = m_slots[(m_next + i) % RingSize];
+        if (slot.fence == nullptr) {
+            continue;
+        }
+
+        const GLenum status = gl->glClientWaitSync(slot.fence, 0, 0);
+        if (pending || (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)) {
+            pending = true;
+            continue;
+        }
+
+        finish(slot);
+    }
+
+    return pending;
+}
+
+bool OpenGLFrameReader::isSupported() const {
+    const QOpenGLContext *context = QOpenGLContext::currentContext();
+    const QSurfaceFormat format = context->format();
+    const auto version = std::make_pair(format.majorVersion(), format.minorVersion());
+    return context->isOpenGLES() ? version >= std::make_pair(3, 0) : version >= std::make_pair(3, 2);
+}
+
+void OpenGLFrameReader::finish(Slot &slot) {
+    QOpenGLExtraFunctions *gl = functions();
+
+    gl->glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    const auto width = static_cast<int>(slot.size.width);
+    const auto height = static_cast<int>(slot.size.height);
+    const qsizetype rowBytes = width * BytesPerPixel;
+
+    gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const auto *pixels = static_cast<const uchar *>(
+        gl->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, rowBytes * height, GL_MAP_READ_BIT));
+
+    QImage frame;
+    if (pixels != nullptr) {
+        // OpenGL rows start at the bottom.
+        frame = QImage(width, height, QImage::Format_RGBA8888_Premultiplied);
+        for (int y = 0; y < height; ++y) {
+            std::memcpy(frame.scanLine(height - 1 - y), pixels + y * rowBytes, static_cast<std::size_t>(rowBytes));
+        }
+        gl->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    deliver(slot.promises, frame);
+}
+
+/*! \endcond */
+
+} // namespace QMapLibre
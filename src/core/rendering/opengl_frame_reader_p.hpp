@@ -0,0 +1,65 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include <mbgl/util/size.hpp>
+
+#include <QtCore/QPromise>
+#include <QtGui/QImage>
+#include <QtGui/qopengl.h>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace QMapLibre {
+
+/*! \cond PRIVATE */
+
+class OpenGLRendererBackend;
+
+// Reads frames back through a ring of pixel pack buffers. Each read copies
+// the framebuffer into a buffer on the GPU and sets a fence, the buffer is
+// mapped once a later collect() finds the fence signaled, so the render
+// thread never waits for the copy. Falls back to synchronous reads if the
+// context lacks OpenGL ES 3.0 or OpenGL 3.2 features.
+//
+// All calls need the context of the backend current.
+class OpenGLFrameReader {
+public:
+    explicit OpenGLFrameReader(OpenGLRendererBackend &backend);
+    ~OpenGLFrameReader();
+
+    // Starts reading the frame rendered last, the promises get its image.
+    void read(std::vector<QPromise<QImage>> promises);
+    // Delivers the frames copied by now, returns true if reads are pending.
+    bool collect();
+
+private:
+    Q_DISABLE_COPY(OpenGLFrameReader)
+
+    // Frames in flight before a read has to wait for the oldest one.
+    static constexpr std::size_t RingSize = 3;
+
+    struct Slot {
+        GLuint buffer{};
+        qsizetype capacity{};
+        GLsync fence{};
+        mbgl::Size size;
+        std::vector<QPromise<QImage>> promises;
+    };
+
+    [[nodiscard]] bool isSupported() const;
+    void finish(Slot &slot);
+
+    OpenGLRendererBackend &m_backend;
+    std::array<Slot, RingSize> m_slots;
+    // Slot of the next read, also the oldest pending one.
+    std::size_t m_next{};
+};
+
+/*! \endcond */
+
+} // namespace QMapLibre
@@ -11,8 +11,23 @@
 
 #include <QtCore/QDebug>
 #include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLExtraFunctions>
 #include <QtGui/QOpenGLFunctions>
 
+#include <limits>
+#include <utility>
+
+namespace {
+
+// Fence sync objects need OpenGL ES 3.0 or OpenGL 3.2.
+bool hasFenceSync(const QOpenGLContext *context) {
+    const QSurfaceFormat format = context->format();
+    const auto version = std::make_pair(format.majorVersion(), format.minorVersion());
+    return context->isOpenGLES() ? version >= std::make_pair(3, 0) : version >= std::make_pair(3, 2);
+}
+
+} // namespace
+
 namespace QMapLibre {
 
 /*! \cond PRIVATE */
@@ -56,6 +71,8 @@ OpenGLRendererBackend::~OpenGLRendererBackend() {
         // We only own textures if we created them ourselves
         // For now, we'll skip deleting m_colorTexture to be safe
 
+        releaseColorTargets();
+
         // Clean up the depth-stencil renderbuffer if we created one
         if (m_depthStencilRB != 0) {
             QOpenGLFunctions *gl = glContext->functions();
@@ -107,6 +124,12 @@ void OpenGLRendererBackend::updateRenderer(const mbgl::Size &newSize, uint32_t f
         return;
     }
 
+    // Called before every frame by some integrations, keep the color targets
+    // unless something changed
+    if (!m_usingExternalDrawable && fbo == m_fbo && newSize == m_colorTargetSize && m_colorTargets[0].texture != 0) {
+        return;
+    }
+
     // Only update m_fbo for non-default framebuffers
     m_fbo = fbo;
 
@@ -151,29 +174,33 @@ void OpenGLRendererBackend::updateRenderer(const mbgl::Size &newSize, uint32_t f
             return;
         }
 
-        // Delete old texture if it exists and we own it
-        if (m_colorTexture != 0) {
-            gl->glDeleteTextures(1, &m_colorTexture);
-        }
+        // Delete the old textures, we own them
+        releaseColorTargets();
 
-        // Create new texture for the framebuffer's color attachment
-        gl->glGenTextures(1, &m_colorTexture);
-        gl->glBindTexture(GL_TEXTURE_2D, m_colorTexture);
+        // Create new textures for the framebuffer's color attachment
+        for (ColorTarget &target : m_colorTargets) {
+            gl->glGenTextures(1, &target.texture);
+            gl->glBindTexture(GL_TEXTURE_2D, target.texture);
 
-        // Set up texture parameters for framebuffer use with alpha
-        // Prefer GL_RGBA8 for desktop or OpenGL ES 3.0+, but fall back to
-        // GL_RGBA when GL_RGBA8 is not available (e.g. GLES2 on Android).
+            // Set up texture parameters for framebuffer use with alpha
+            // Prefer GL_RGBA8 for desktop or OpenGL ES 3.0+, but fall back to
+            // GL_RGBA when GL_RGBA8 is not available (e.g. GLES2 on Android).
 #ifdef GL_RGBA8
-        gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 #else
-        gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 #endif
-        // Use linear filtering for smooth rendering
-        // This is especially important for overzooming/underzooming and SDF text
-        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            // Use linear filtering for smooth rendering
+            // This is especially important for overzooming/underzooming and SDF text
+            gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+
+        m_currentTarget = 0;
+        m_colorTexture = m_colorTargets[0].texture;
+        m_colorTargetSize = newSize;
 
         // Create and setup framebuffer if we don't have one
         if (fbo != 0) {
@@ -280,6 +307,11 @@ void OpenGLRendererBackend::setExternalDrawable(unsigned int textureId, const mb
     // Update the size
     size = textureSize;
 
+    // Rendering goes to the external texture from now on
+    if (!m_usingExternalDrawable) {
+        releaseColorTargets();
+        m_colorTexture = 0;
+    }
     m_usingExternalDrawable = true;
 
     QOpenGLFunctions *gl = glContext->functions();
@@ -347,6 +379,78 @@ void OpenGLRendererBackend::setExternalDrawable(unsigned int textureId, const mb
     setViewport(0, 0, size);
 }
 
+void OpenGLRendererBackend::beginFrame() {
+    // External drawables and the default framebuffer have a single target
+    QOpenGLContext *glContext = QOpenGLContext::currentContext();
+    if (glContext == nullptr || m_usingExternalDrawable || m_fbo == 0 || m_colorTargets[0].texture == 0) {
+        return;
+    }
+
+    QOpenGLExtraFunctions *gl = glContext->extraFunctions();
+    const bool fenceSync = hasFenceSync(glContext);
+
+    // The consumer was handed the current target after the last frame. The
+    // commands issued since include its composition on this context, so the
+    // target is free once they are done.
+    ColorTarget &front = m_colorTargets[m_currentTarget];
+    if (fenceSync) {
+        if (front.fence != nullptr) {
+            gl->glDeleteSync(front.fence);
+        }
+        front.fence = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    m_currentTarget = (m_currentTarget + 1) % ColorTargetCount;
+    ColorTarget &target = m_colorTargets[m_currentTarget];
+    if (target.fence != nullptr) {
+        if (gl->glClientWaitSync(target.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            ++m_colorTargetWaits;
+            gl->glClientWaitSync(target.fence, GL_SYNC_FLUSH_COMMANDS_BIT, std::numeric_limits<GLuint64>::max());
+        }
+        gl->glDeleteSync(target.fence);
+        target.fence = nullptr;
+    }
+
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+}
+
+void OpenGLRendererBackend::endFrame() {
+    if (!m_usingExternalDrawable && m_colorTargets[m_currentTarget].texture != 0) {
+        m_colorTexture = m_colorTargets[m_currentTarget].texture;
+    }
+}
+
+void OpenGLRendererBackend::releaseColorTargets() {
+    QOpenGLContext *glContext = QOpenGLContext::currentContext();
+    if (glContext == nullptr) {
+        return;
+    }
+
+    QOpenGLExtraFunctions *gl = glContext->extraFunctions();
+    for (ColorTarget &target : m_colorTargets) {
+        if (target.fence != nullptr) {
+            gl->glDeleteSync(target.fence);
+            target.fence = nullptr;
+        }
+        if (target.texture != 0) {
+            if (m_colorTexture == target.texture) {
+                m_colorTexture = 0;
+            }
+            gl->glDeleteTextures(1, &target.texture);
+            target.texture = 0;
+        }
+    }
+
+    m_currentTarget = 0;
+    m_colorTargetSize = {};
+}
+
+mbgl::PremultipliedImage OpenGLRendererBackend::readFramebuffer() {
+    restoreFramebufferBinding();
+    return mbgl::gl::RendererBackend::readFramebuffer(size);
+}
+
 /*! \endcond PRIVATE */
 
 } // namespace QMapLibre
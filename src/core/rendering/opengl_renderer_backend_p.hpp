@@ -6,8 +6,16 @@
 
 #include <mbgl/gfx/renderable.hpp>
 #include <mbgl/gl/renderer_backend.hpp>
+#include <mbgl/util/image.hpp>
 #include <mbgl/util/size.hpp>
 
+#include <QtGui/qopengl.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
 namespace QMapLibre {
 
 class QtOpenGLRenderableResource;
@@ -41,11 +49,40 @@ public:
     // Set OpenGL render target for zero-copy rendering
     void setExternalDrawable(unsigned int textureId, const mbgl::Size &textureSize);
 
+    // Read back the color attachment of the render target, top row first
+    [[nodiscard]] mbgl::PremultipliedImage readFramebuffer();
+
+    // Frames rendered into our own framebuffer rotate through this many color
+    // textures, so the next frame never overwrites the one being composited
+    static constexpr std::size_t ColorTargetCount = 3;
+
+    // Attach the next color target, called before rendering a frame
+    void beginFrame();
+    // Publish the color target just rendered through getFramebufferTextureId()
+    void endFrame();
+
+    // Frames that had to wait for the consumer to release their color target
+    // since the last call
+    [[nodiscard]] std::uint64_t takeColorTargetWaits() { return std::exchange(m_colorTargetWaits, 0); }
+
 private:
+    struct ColorTarget {
+        uint32_t texture{};
+        // Signaled once the consumer is done with the texture
+        GLsync fence{};
+    };
+
+    void releaseColorTargets();
+
     bool m_usingExternalDrawable{};
     uint32_t m_fbo{};
     uint32_t m_colorTexture{};   // OpenGL texture ID for the framebuffer's color attachment
     uint32_t m_depthStencilRB{}; // OpenGL renderbuffer ID for depth-stencil attachment
+
+    std::array<ColorTarget, ColorTargetCount> m_colorTargets{};
+    std::size_t m_currentTarget{};
+    mbgl::Size m_colorTargetSize;
+    std::uint64_t m_colorTargetWaits{};
 };
 
 } // namespace QMapLibre
@@ -7,8 +7,10 @@
 #include <mbgl/gfx/renderable.hpp>
 
 #if defined(MLN_RENDER_BACKEND_OPENGL)
+#include "opengl_frame_reader_p.hpp"
 #include "opengl_renderer_backend_p.hpp"
 #elif defined(MLN_RENDER_BACKEND_VULKAN)
+#include "vulkan_frame_reader_p.hpp"
 #include "vulkan_renderer_backend_p.hpp"
 #elif defined(MLN_RENDER_BACKEND_METAL)
 #include "metal_renderer_backend_p.hpp"
@@ -18,8 +20,10 @@ namespace QMapLibre {
 
 #if defined(MLN_RENDER_BACKEND_OPENGL)
 using RendererBackend = OpenGLRendererBackend;
+using FrameReader = OpenGLFrameReader;
 #elif defined(MLN_RENDER_BACKEND_VULKAN)
 using RendererBackend = VulkanRendererBackend;
+using FrameReader = VulkanFrameReader;
 #elif defined(MLN_RENDER_BACKEND_METAL)
 using RendererBackend = MetalRendererBackend;
 #endif
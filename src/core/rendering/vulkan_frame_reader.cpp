@@ -0,0 +1,286 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "vulkan_frame_reader_p.hpp"
+#include "vulkan_renderer_backend_p.hpp"
+
+#include <mbgl/vulkan/texture2d.hpp>
+
+#include <QtCore/QDebug>
+
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <utility>
+
+namespace {
+
+constexpr vk::DeviceSize BytesPerPixel = 4;
+
+void deliver(std::vector<QPromise<QImage>> &promises, const QImage &image) {
+    for (auto &promise : promises) {
+        if (image.isNull()) {
+            promise.future().cancel();
+        } else {
+            promise.addResult(image);
+        }
+        promise.finish();
+    }
+    promises.clear();
+}
+
+std::optional<QImage::Format> imageFormat(vk::Format format) {
+    switch (format) {
+        case vk::Format::eR8G8B8A8Unorm:
+            return QImage::Format_RGBA8888_Premultiplied;
+        case vk::Format::eB8G8R8A8Unorm:
+            // Byte order B, G, R, A is ARGB32 on little endian hosts.
+            if constexpr (Q_BYTE_ORDER == Q_LITTLE_ENDIAN) {
+                return QImage::Format_ARGB32_Premultiplied;
+            }
+            return std::nullopt;
+        default:
+            return std::nullopt;
+    }
+}
+
+vk::ImageMemoryBarrier colorBarrier(vk::Image image,
+                                    vk::ImageLayout oldLayout,
+                                    vk::ImageLayout newLayout,
+                                    vk::AccessFlags srcAccess,
+                                    vk::AccessFlags dstAccess) {
+    return vk::ImageMemoryBarrier()
+        .setImage(image)
+        .setOldLayout(oldLayout)
+        .setNewLayout(newLayout)
+        .setSrcAccessMask(srcAccess)
+        .setDstAccessMask(dstAccess)
+        .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1));
+}
+
+} // namespace
+
+namespace QMapLibre {
+
+/*! \cond PRIVATE */
+
+VulkanFrameReader::VulkanFrameReader(VulkanRendererBackend &backend)
+    : m_backend(backend) {}
+
+VulkanFrameReader::~VulkanFrameReader() {
+    const auto &device = m_backend.getDevice();
+    for (auto &slot : m_slots) {
+        // The copy may still use the buffer.
+        if (slot.pending) {
+            static_cast<void>(device->waitForFences(
+                slot.fence.get(), VK_TRUE, std::numeric_limits<uint64_t>::max(), m_backend.getDispatcher()));
+        }
+        deliver(slot.promises, QImage());
+    }
+}
+
+void VulkanFrameReader::read(std::vector<QPromise<QImage>> promises) {
+    mbgl::vulkan::Texture2D *texture = m_backend.getOffscreenTexture();
+    const std::optional<QImage::Format> format = texture != nullptr ? imageFormat(texture->getVulkanFormat())
+                                                                    : std::nullopt;
+    if (!format) {
+        deliver(promises, QImage());
+        return;
+    }
+
+    const auto &device = m_backend.getDevice();
+    const auto &dispatcher = m_backend.getDispatcher();
+
+    Slot &slot = m_slots[m_next];
+    m_next = (m_next + 1) % RingSize;
+
+    // All buffers are in flight, the oldest read has to finish first.
+    if (slot.pending) {
+        static_cast<void>(
+            device->waitForFences(slot.fence.get(), VK_TRUE, std::numeric_limits<uint64_t>::max(), dispatcher));
+        finish(slot);
+    }
+
+    slot.size = texture->getSize();
+    slot.format = *format;
+    const vk::DeviceSize bytes = vk::DeviceSize{slot.size.area()} * BytesPerPixel;
+    if (bytes == 0 || !reserve(slot, bytes)) {
+        deliver(promises, QImage());
+        return;
+    }
+
+    const vk::Image image = texture->getVulkanImage();
+    const vk::CommandBuffer commandBuffer = slot.commandBuffer.get();
+    commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit), dispatcher);
+
+    // The offscreen render pass leaves the texture ready for sampling.
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                                  vk::PipelineStageFlagBits::eTransfer,
+                                  {},
+                                  nullptr,
+                                  nullptr,
+                                  colorBarrier(image,
+                                               vk::ImageLayout::eShaderReadOnlyOptimal,
+                                               vk::ImageLayout::eTransferSrcOptimal,
+                                               vk::AccessFlagBits::eColorAttachmentWrite,
+                                               vk::AccessFlagBits::eTransferRead),
+                                  dispatcher);
+
+    const auto region = vk::BufferImageCopy()
+                            .setImageSubresource(vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1))
+                            .setImageExtent(vk::Extent3D(slot.size.width, slot.size.height, 1));
+    commandBuffer.copyImageToBuffer(
+        image, vk::ImageLayout::eTransferSrcOptimal, slot.buffer.get(), region, dispatcher);
+
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                  vk::PipelineStageFlagBits::eFragmentShader,
+                                  {},
+                                  nullptr,
+                                  nullptr,
+                                  colorBarrier(image,
+                                               vk::ImageLayout::eTransferSrcOptimal,
+                                               vk::ImageLayout::eShaderReadOnlyOptimal,
+                                               vk::AccessFlagBits::eTransferRead,
+                                               vk::AccessFlagBits::eShaderRead),
+                                  dispatcher);
+
+    const auto hostBarrier = vk::BufferMemoryBarrier()
+                                 .setBuffer(slot.buffer.get())
+                                 .setSize(VK_WHOLE_SIZE)
+                                 .setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+                                 .setDstAccessMask(vk::AccessFlagBits::eHostRead)
+                                 .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                                 .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                  vk::PipelineStageFlagBits::eHost,
+                                  {},
+                                  nullptr,
+                                  hostBarrier,
+                                  nullptr,
+                                  dispatcher);
+
+    commandBuffer.end(dispatcher);
+
+    // Submitted after the frame on the same queue, so the copy sees it.
+    device->resetFences(slot.fence.get(), dispatcher);
+    m_backend.getGraphicsQueue().submit(
+        vk::SubmitInfo().setCommandBuffers(commandBuffer), slot.fence.get(), dispatcher);
+
+    slot.pending = true;
+    slot.promises = std::move(promises);
+}
+
+bool VulkanFrameReader::collect() {
+    const auto &device = m_backend.getDevice();
+
+    bool pending = false;
+    // Oldest first, so frames are delivered in order.
+    for (std::size_t i = 0; i < RingSize; ++i) {
+        Slot &slot = m_slots[(m_next + i) % RingSize];
+        if (!slot.pending) {
+            continue;
+        }
+
+        if (pending || device->getFenceStatus(slot.fence.get(), m_backend.getDispatcher()) != vk::Result::eSuccess) {
+            pending = true;
+            continue;
+        }
+
+        finish(slot);
+    }
+
+    return pending;
+}
+
+bool VulkanFrameReader::reserve(Slot &slot, vk::DeviceSize bytes) {
+    const auto &device = m_backend.getDevice();
+    const auto &dispatcher = m_backend.getDispatcher();
+
+    if (!m_commandPool) {
+        m_commandPool = device->createCommandPoolUnique(
+            vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+                                      static_cast<uint32_t>(m_backend.getGraphicsQueueIndex())),
+            nullptr,
+            dispatcher);
+    }
+
+    if (!slot.commandBuffer) {
+        auto commandBuffers = device->allocateCommandBuffersUnique(
+            vk::CommandBufferAllocateInfo(m_commandPool.get(), vk::CommandBufferLevel::ePrimary, 1), dispatcher);
+        slot.commandBuffer = std::move(commandBuffers.front());
+        slot.fence = device->createFenceUnique(vk::FenceCreateInfo(), nullptr, dispatcher);
+    }
+
+    if (slot.capacity >= bytes) {
+        return true;
+    }
+
+    slot.memory.reset();
+    slot.buffer = device->createBufferUnique(
+        vk::BufferCreateInfo({}, bytes, vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eExclusive),
+        nullptr,
+        dispatcher);
+
+    const vk::MemoryRequirements requirements = device->getBufferMemoryRequirements(slot.buffer.get(), dispatcher);
+    const vk::PhysicalDeviceMemoryProperties properties = m_backend.getPhysicalDevice().getMemoryProperties(
+        dispatcher);
+    // Host cached memory makes reading the pixels on the CPU fast.
+    const auto findMemoryType = [&](vk::MemoryPropertyFlags flags) -> std::optional<uint32_t> {
+        for (uint32_t i = 0; i < properties.memoryTypeCount; ++i) {
+            if ((requirements.memoryTypeBits & (1U << i)) != 0 &&
+                (properties.memoryTypes[i].propertyFlags & flags) == flags) {
+                return i;
+            }
+        }
+        return std::nullopt;
+    };
+    const vk::MemoryPropertyFlags visible = vk::MemoryPropertyFlagBits::eHostVisible |
+                                            vk::MemoryPropertyFlagBits::eHostCoherent;
+    std::optional<uint32_t> memoryType = findMemoryType(visible | vk::MemoryPropertyFlagBits::eHostCached);
+    if (!memoryType) {
+        memoryType = findMemoryType(visible);
+    }
+    if (!memoryType) {
+        qWarning() << "VulkanFrameReader: no host visible memory for reading frames";
+        slot.buffer.reset();
+        slot.capacity = 0;
+        return false;
+    }
+
+    slot.memory = device->allocateMemoryUnique(
+        vk::MemoryAllocateInfo(requirements.size, *memoryType), nullptr, dispatcher);
+    device->bindBufferMemory(slot.buffer.get(), slot.memory.get(), 0, dispatcher);
+    slot.capacity = bytes;
+    return true;
+}
+
+void VulkanFrameReader::finish(Slot &slot) {
+    const auto &device = m_backend.getDevice();
+    slot.pending = false;
+
+    const auto width = static_cast<int>(slot.size.width);
+    const auto height = static_cast<int>(slot.size.height);
+    const vk::DeviceSize bytes = vk::DeviceSize{slot.size.area()} * BytesPerPixel;
+
+    QImage frame;
+    const void *pixels = device->mapMemory(slot.memory.get(), 0, bytes, {}, m_backend.getDispatcher());
+    if (pixels != nullptr) {
+        // Vulkan rows start at the top, tightly packed like the image.
+        frame = QImage(width, height, slot.format);
+        for (int y = 0; y < height; ++y) {
+            std::memcpy(frame.scanLine(y),
+                        static_cast<const uchar *>(pixels) + y * width * BytesPerPixel,
+                        static_cast<std::size_t>(width * BytesPerPixel));
+        }
+        device->unmapMemory(slot.memory.get(), m_backend.getDispatcher());
+    }
+
+    deliver(slot.promises, frame);
+}
+
+/*! \endcond */
+
+} // namespace QMapLibre
@@ -0,0 +1,70 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include <mbgl/util/size.hpp>
+
+#include <QtCore/QPromise>
+#include <QtGui/QImage>
+
+#include <vulkan/vulkan.hpp>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace QMapLibre {
+
+/*! \cond PRIVATE */
+
+class VulkanRendererBackend;
+
+// Reads frames back through a ring of host visible staging buffers. Each
+// read records a copy of the offscreen color texture on the graphics queue
+// with a fence, the buffer is read once a later collect() finds the fence
+// signaled, so the render thread never waits for the copy.
+//
+// Frames rendered into external images are not read.
+class VulkanFrameReader {
+public:
+    explicit VulkanFrameReader(VulkanRendererBackend &backend);
+    ~VulkanFrameReader();
+
+    // Starts reading the frame rendered last, the promises get its image.
+    void read(std::vector<QPromise<QImage>> promises);
+    // Delivers the frames copied by now, returns true if reads are pending.
+    bool collect();
+
+private:
+    Q_DISABLE_COPY(VulkanFrameReader)
+
+    // Frames in flight before a read has to wait for the oldest one.
+    static constexpr std::size_t RingSize = 3;
+
+    struct Slot {
+        vk::UniqueBuffer buffer;
+        vk::UniqueDeviceMemory memory;
+        vk::DeviceSize capacity{};
+        vk::UniqueCommandBuffer commandBuffer;
+        vk::UniqueFence fence;
+        bool pending{};
+        mbgl::Size size;
+        QImage::Format format{QImage::Format_RGBA8888_Premultiplied};
+        std::vector<QPromise<QImage>> promises;
+    };
+
+    bool reserve(Slot &slot, vk::DeviceSize bytes);
+    void finish(Slot &slot);
+
+    VulkanRendererBackend &m_backend;
+    vk::UniqueCommandPool m_commandPool;
+    std::array<Slot, RingSize> m_slots;
+    // Slot of the next read, also the oldest pending one.
+    std::size_t m_next{};
+};
+
+/*! \endcond */
+
+} // namespace QMapLibre
@@ -7,7 +7,7 @@
 #include <mbgl/util/monotonic_timer.hpp>
 #include <mbgl/util/util.hpp>
 
-#include <cassert>
+#include <optional>
 
 namespace QMapLibre {
 
@@ -19,52 +19,172 @@ Scheduler::~Scheduler() {
     MBGL_VERIFY_THREAD(tid);
 }
 
-void Scheduler::schedule(const mbgl::util::SimpleIdentity /* identity */, std::function<void()> &&function) {
-    const std::scoped_lock lock(m_taskQueueMutex);
-    m_taskQueue.push(std::move(function));
+void Scheduler::schedule(const mbgl::util::SimpleIdentity identity, std::function<void()> &&function) {
+    if (m_taskStatistics->isEnabled()) {
+        function = m_taskStatistics->wrap(std::move(function), identity);
+    }
+
+    // The shared lock keeps the queue alive while pushing, it does not
+    // serialize producers.
+    std::shared_lock lock(m_queuesMutex);
+    auto it = m_queues.find(identity);
+    if (it == m_queues.end()) {
+        lock.unlock();
+        {
+            const std::unique_lock exclusiveLock(m_queuesMutex);
+            auto &queue = m_queues[identity];
+            if (!queue) {
+                queue = std::make_unique<TaskQueue>();
+            }
+        }
+        lock.lock();
+        it = m_queues.find(identity);
+    }
 
-    // Need to force the main thread to wake
-    // up this thread and process the events.
-    emit needsProcessing();
+    TaskQueue &queue = *it->second;
+    queue.pendingTasks.fetch_add(1, std::memory_order_acq_rel);
+    const bool wasIdle = m_pendingTasks.fetch_add(1, std::memory_order_acq_rel) == 0;
+    queue.tasks.push(std::move(function));
+    lock.unlock();
+
+    // Need to force the main thread to wake up this thread and process the
+    // events. Only the first task after an idle period does it, the rest is
+    // picked up by the same processEvents() round.
+    if (wasIdle) {
+        emit needsProcessing();
+    }
 }
 
 void Scheduler::schedule(std::function<void()> &&function) {
     schedule(mbgl::util::SimpleIdentity::Empty, std::move(function));
 }
 
-void Scheduler::processEvents() {
-    std::queue<std::function<void()>> taskQueue;
+void Scheduler::processEvents(std::chrono::nanoseconds budget) {
+    // Tasks scheduled while processing are left for the next round,
+    // otherwise a task that reschedules itself would never let us return.
+    m_batches.clear();
     {
-        const std::unique_lock<std::mutex> lock(m_taskQueueMutex);
-        std::swap(taskQueue, m_taskQueue);
-        pendingItems += taskQueue.size();
+        const std::shared_lock lock(m_queuesMutex);
+        for (const auto &[tag, queue] : m_queues) {
+            const std::size_t queuedTasks = queue->pendingTasks.load(std::memory_order_acquire);
+            if (queuedTasks > 0) {
+                m_batches.push_back({queue.get(), queuedTasks});
+            }
+        }
     }
 
-    while (!taskQueue.empty()) {
-        auto &function = taskQueue.front();
-        if (function) {
-            function();
+    const bool hasDeadline = budget != std::chrono::nanoseconds::max();
+    const auto startTime = hasDeadline ? mbgl::util::MonotonicTimer::now() : std::chrono::duration<double>{};
+    const auto isBudgetSpent = [&] {
+        return hasDeadline && mbgl::util::MonotonicTimer::now() - startTime >= budget;
+    };
+
+    // Queues are only released from this thread, so the batches stay valid
+    // without holding the lock while running tasks, which may schedule more.
+    std::size_t processedTasks = 0;
+    bool hasBudget = true;
+    bool hasDrainedQueue = false;
+    bool hasProgress = true;
+    while (hasProgress && hasBudget) {
+        hasProgress = false;
+        for (TaskBatch &batch : m_batches) {
+            if (batch.remainingTasks == 0) {
+                continue;
+            }
+
+            if (processedTasks > 0 && isBudgetSpent()) {
+                hasBudget = false;
+                break;
+            }
+
+            std::optional<std::function<void()>> function = batch.queue->tasks.pop();
+            if (!function) {
+                // A producer has been counted but has not linked its task yet.
+                batch.remainingTasks = 0;
+                continue;
+            }
+
+            if (*function) {
+                (*function)();
+            }
+
+            --batch.remainingTasks;
+            ++processedTasks;
+            hasProgress = true;
+
+            if (batch.queue->pendingTasks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                hasDrainedQueue = true;
+            }
+        }
+    }
+
+    m_processedTasks.fetch_add(processedTasks, std::memory_order_relaxed);
+    if (!hasBudget) {
+        std::size_t deferredTasks = 0;
+        for (const TaskBatch &batch : m_batches) {
+            deferredTasks += batch.remainingTasks;
         }
-        taskQueue.pop();
-        pendingItems--;
+
+        m_deferredTasks.fetch_add(deferredTasks, std::memory_order_relaxed);
+        m_exhaustedBudgets.fetch_add(1, std::memory_order_relaxed);
     }
 
-    cvEmpty.notify_all();
+    const std::size_t remainingTasks =
+        m_pendingTasks.fetch_sub(processedTasks, std::memory_order_acq_rel) - processedTasks;
+
+    if (hasDrainedQueue || remainingTasks == 0) {
+        {
+            const std::scoped_lock lock(m_waitMutex);
+        }
+        cvEmpty.notify_all();
+    }
+
+    if (remainingTasks > 0) {
+        // Deferred tasks and producers that did not wake us up while we
+        // were busy need another round.
+        emit needsProcessing();
+    } else if (hasDrainedQueue) {
+        releaseIdleQueues();
+    }
 }
 
-void Scheduler::waitForEmpty(const mbgl::util::SimpleIdentity /* tag */) {
+SchedulerStatistics Scheduler::statistics() const {
+    SchedulerStatistics statistics;
+    statistics.pendingTasks = m_pendingTasks.load(std::memory_order_relaxed);
+    statistics.processedTasks = m_processedTasks.load(std::memory_order_relaxed);
+    statistics.deferredTasks = m_deferredTasks.load(std::memory_order_relaxed);
+    statistics.exhaustedBudgets = m_exhaustedBudgets.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+void Scheduler::waitForEmpty(const mbgl::util::SimpleIdentity tag) {
     MBGL_VERIFY_THREAD(tid);
 
-    std::unique_lock<std::mutex> lock(m_taskQueueMutex);
-    const auto isDone = [&] {
-        return m_taskQueue.empty() && pendingItems == 0;
-    };
+    // Only wait for the tasks of the given owner, other tags may keep the
+    // scheduler busy for much longer.
+    std::unique_lock<std::mutex> lock(m_waitMutex);
+    cvEmpty.wait(lock, [this, tag] { return isEmpty(tag); });
+}
 
-    while (!isDone()) {
-        cvEmpty.wait(lock);
+bool Scheduler::isEmpty(const mbgl::util::SimpleIdentity tag) {
+    if (tag.isEmpty()) {
+        return m_pendingTasks.load(std::memory_order_acquire) == 0;
     }
 
-    assert(m_taskQueue.size() + pendingItems == 0);
+    const std::shared_lock lock(m_queuesMutex);
+    auto it = m_queues.find(tag);
+    return it == m_queues.end() || it->second->pendingTasks.load(std::memory_order_acquire) == 0;
+}
+
+void Scheduler::releaseIdleQueues() {
+    // Owners come and go (e.g. one tag per map), drop their queues once idle.
+    // Producers push while holding the shared lock, so nothing can be in
+    // flight for a queue that is idle while we hold the exclusive one.
+    const std::unique_lock lock(m_queuesMutex);
+    std::erase_if(m_queues, [](const auto &item) {
+        const auto &[tag, queue] = item;
+        return !tag.isEmpty() && queue->pendingTasks.load(std::memory_order_acquire) == 0;
+    });
 }
 
 /*! \endcond PRIVATE */
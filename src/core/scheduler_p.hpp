@@ -4,14 +4,26 @@
 
 #pragma once
 
+#include "mpsc_queue_p.hpp"
+#include "task_statistics_p.hpp"
+#include "types.hpp"
+
 #include <mbgl/actor/scheduler.hpp>
+#include <mbgl/util/identity.hpp>
 #include <mbgl/util/util.hpp>
 
 #include <QObject>
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
 
 namespace QMapLibre {
 
@@ -30,18 +42,56 @@ public:
 
     mapbox::base::WeakPtr<mbgl::Scheduler> makeWeakPtr() override { return weakFactory.makeWeakPtr(); }
 
-    void processEvents();
+    // Runs the tasks that were queued when called, alternating between tags
+    // so a busy owner does not starve the others. Once the budget is spent
+    // the remaining tasks are deferred and needsProcessing() is emitted
+    // again. At least one task always runs.
+    void processEvents(std::chrono::nanoseconds budget = std::chrono::nanoseconds::max());
+
+    // Thread-safe.
+    [[nodiscard]] SchedulerStatistics statistics() const;
+    // Shared so it can be read after the render thread, and with it the
+    // scheduler, is gone.
+    [[nodiscard]] std::shared_ptr<TaskStatistics> taskStatistics() const { return m_taskStatistics; }
 
 signals:
+    // Emitted when the scheduler goes from idle to having work, not for
+    // every scheduled task.
     void needsProcessing();
 
 private:
+    struct TaskQueue {
+        MpscQueue<std::function<void()>> tasks;
+        // Tasks of this tag queued or currently running.
+        std::atomic<std::size_t> pendingTasks{0};
+    };
+
+    struct TaskBatch {
+        TaskQueue *queue;
+        std::size_t remainingTasks;
+    };
+
+    [[nodiscard]] bool isEmpty(const mbgl::util::SimpleIdentity tag);
+    void releaseIdleQueues();
+
     MBGL_STORE_THREAD(tid);
 
-    std::mutex m_taskQueueMutex;
+    // Only used to block in waitForEmpty(), producers never take it.
+    std::mutex m_waitMutex;
     std::condition_variable cvEmpty;
-    std::atomic<std::size_t> pendingItems;
-    std::queue<std::function<void()>> m_taskQueue;
+    // Tasks queued or currently running for all tags. Incremented before a
+    // task is published, so it never under-reports the queues.
+    std::atomic<std::size_t> m_pendingTasks{0};
+    // Producers only take a shared lock to find their queue, the exclusive
+    // lock is needed when a tag is seen for the first time or released.
+    std::shared_mutex m_queuesMutex;
+    std::unordered_map<mbgl::util::SimpleIdentity, std::unique_ptr<TaskQueue>> m_queues;
+    std::vector<TaskBatch> m_batches;
+
+    std::atomic<std::uint64_t> m_processedTasks{0};
+    std::atomic<std::uint64_t> m_deferredTasks{0};
+    std::atomic<std::uint64_t> m_exhaustedBudgets{0};
+    std::shared_ptr<TaskStatistics> m_taskStatistics{std::make_shared<TaskStatistics>()};
     mapbox::base::WeakPtrFactory<Scheduler> weakFactory{this};
     // Do not add members here, see `WeakPtrFactory`
 };
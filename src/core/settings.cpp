@@ -620,6 +620,176 @@ void Settings::setDefaultZoom(double zoom) {
     d_ptr->m_defaultZoom = zoom;
 }
 
+/*!
+    \brief Get the render thread task budget.
+    \return The budget in milliseconds, \c 0 if unlimited.
+*/
+int Settings::renderTaskBudget() const {
+    return d_ptr->m_renderTaskBudget;
+}
+
+/*!
+    \brief Set the render thread task budget.
+    \param milliseconds The budget in milliseconds, \c 0 for unlimited.
+
+    When rendering on a thread without an event loop, MapLibre tasks queued
+    for that thread are run after each frame. With a budget set, tasks that
+    do not fit are deferred to the next frame instead of delaying it, which
+    avoids frame spikes when many tiles finish loading at once. At least one
+    task is run per frame. Unlimited by default.
+
+    \sa Map::schedulerStatistics()
+*/
+void Settings::setRenderTaskBudget(int milliseconds) {
+    d_ptr->m_renderTaskBudget = qMax(0, milliseconds);
+}
+
+/*!
+    \brief Get the maximum frame rate.
+    \return The frame rate in frames per second, \c 0 if unlimited.
+*/
+int Settings::maxFrameRate() const {
+    return d_ptr->m_maxFrameRate;
+}
+
+/*!
+    \brief Set the maximum frame rate.
+    \param framesPerSecond The frame rate in frames per second, \c 0 for unlimited.
+
+    Map::needsRendering() is emitted at most once per frame interval, map
+    updates in between are merged into the next frame. No frames are
+    requested while the map is idle. Useful to save CPU and GPU time on
+    embedded devices, for example by capping at 30 frames per second.
+    Unlimited by default, in which case the host's own vsync paces the
+    frames.
+
+    \sa Map::framePacerStatistics()
+*/
+void Settings::setMaxFrameRate(int framesPerSecond) {
+    d_ptr->m_maxFrameRate = qMax(0, framesPerSecond);
+}
+
+/*!
+    \brief Get the task queue statistics interval.
+    \return The interval in milliseconds, \c 0 if disabled.
+*/
+int Settings::statisticsInterval() const {
+    return d_ptr->m_statisticsInterval;
+}
+
+/*!
+    \brief Set the task queue statistics interval.
+    \param milliseconds The interval in milliseconds, \c 0 to disable.
+
+    When set, latencies and run times of the tasks feeding the map are
+    measured and Map::statisticsUpdated() is emitted at this interval. The
+    counters can also be polled with Map::statistics(). Disabled by default,
+    in which case no measurements are taken.
+*/
+void Settings::setStatisticsInterval(int milliseconds) {
+    d_ptr->m_statisticsInterval = qMax(0, milliseconds);
+}
+
+/*!
+    \brief Get the number of background worker threads.
+    \return The number of threads, \c 0 if the default pool is used.
+*/
+int Settings::backgroundThreadCount() const {
+    return d_ptr->m_backgroundThreadCount;
+}
+
+/*!
+    \brief Set the number of background worker threads.
+    \param count The number of threads, \c 0 for the default.
+
+    The style of a map runs its background work on a pool of worker
+    threads: loading and parsing GeoJSON source data, cutting GeoJSON sources
+    into tiles and parsing sprites. The data conversions of
+    Map::addSourceAsync(), Map::updateSourceAsync() and
+    Map::setSourceSimplification() run there as well.
+
+    By default all maps in the process share the pool provided by MapLibre.
+    Setting a thread count, priority or affinity gives the map a pool
+    configured accordingly, which is shared with other maps using the same
+    configuration unless setIsolatedBackgroundPool() is enabled. When only
+    the priority or affinity is set, QThread::idealThreadCount() workers are
+    started.
+
+    The renderer parses and lays out tiles, including the preparation of
+    symbol placement, on the MapLibre pool in any case. These settings do
+    not apply to that work.
+
+    \sa Map::backgroundPoolStatistics()
+*/
+void Settings::setBackgroundThreadCount(int count) {
+    d_ptr->m_backgroundThreadCount = qMax(0, count);
+}
+
+/*!
+    \brief Get the priority of the background worker threads.
+    \return The thread priority.
+*/
+QThread::Priority Settings::backgroundThreadPriority() const {
+    return d_ptr->m_backgroundThreadPriority;
+}
+
+/*!
+    \brief Set the priority of the background worker threads.
+    \param priority The thread priority.
+
+    Defaults to QThread::InheritPriority. Applies to the style workers only,
+    not to the tile workers of the renderer.
+
+    \sa setBackgroundThreadCount()
+*/
+void Settings::setBackgroundThreadPriority(QThread::Priority priority) {
+    d_ptr->m_backgroundThreadPriority = priority;
+}
+
+/*!
+    \brief Get the CPUs the background worker threads may run on.
+    \return The CPU indices, empty if not restricted.
+*/
+QList<int> Settings::backgroundThreadAffinity() const {
+    return d_ptr->m_backgroundThreadAffinity;
+}
+
+/*!
+    \brief Restrict the background worker threads to a set of CPUs.
+    \param cpus The CPU indices, empty to not restrict.
+
+    All workers of the style pool may run on any of the given CPUs, the tile
+    workers of the renderer are not restricted. Supported on Linux, Android
+    and Windows, ignored with a warning elsewhere.
+
+    \sa setBackgroundThreadCount()
+*/
+void Settings::setBackgroundThreadAffinity(const QList<int> &cpus) {
+    d_ptr->m_backgroundThreadAffinity = cpus;
+}
+
+/*!
+    \brief Check whether the map gets its own background worker pool.
+    \return \c true if the pool is not shared with other maps.
+*/
+bool Settings::isolatedBackgroundPool() const {
+    return d_ptr->m_isolatedBackgroundPool;
+}
+
+/*!
+    \brief Give the map its own background worker pool.
+    \param isolated \c true to not share the pool with other maps.
+
+    Useful to keep a map with heavy GeoJSON sources from delaying the
+    GeoJSON sources and sprites of other maps. Tiles of the renderer are
+    still parsed on the pool shared by all maps.
+
+    \sa setBackgroundThreadCount()
+*/
+void Settings::setIsolatedBackgroundPool(bool isolated) {
+    d_ptr->m_isolatedBackgroundPool = isolated;
+}
+
 /*!
     \brief Check whether the tile server options have been set by the user.
     \return \c true if the tile server options have been set by the user.
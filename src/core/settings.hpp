@@ -9,7 +9,9 @@
 #include <QMapLibre/Export>
 #include <QMapLibre/Types>
 
+#include <QtCore/QList>
 #include <QtCore/QString>
+#include <QtCore/QThread>
 #include <QtGui/QImage>
 
 #include <functional>
@@ -113,6 +115,24 @@ public:
     [[nodiscard]] double defaultZoom() const;
     void setDefaultZoom(double zoom);
 
+    [[nodiscard]] int renderTaskBudget() const;
+    void setRenderTaskBudget(int milliseconds);
+
+    [[nodiscard]] int maxFrameRate() const;
+    void setMaxFrameRate(int framesPerSecond);
+
+    [[nodiscard]] int statisticsInterval() const;
+    void setStatisticsInterval(int milliseconds);
+
+    [[nodiscard]] int backgroundThreadCount() const;
+    void setBackgroundThreadCount(int count);
+    [[nodiscard]] QThread::Priority backgroundThreadPriority() const;
+    void setBackgroundThreadPriority(QThread::Priority priority);
+    [[nodiscard]] QList<int> backgroundThreadAffinity() const;
+    void setBackgroundThreadAffinity(const QList<int> &cpus);
+    [[nodiscard]] bool isolatedBackgroundPool() const;
+    void setIsolatedBackgroundPool(bool isolated);
+
     [[nodiscard]] bool customTileServerOptions() const;
     [[nodiscard]] const mbgl::TileServerOptions &tileServerOptions() const;
 
@@ -10,7 +10,9 @@
 
 #include <mbgl/util/tile_server_options.hpp>
 
+#include <QtCore/QList>
 #include <QtCore/QString>
+#include <QtCore/QThread>
 #include <QtCore/QVector>
 
 #include <functional>
@@ -46,6 +48,15 @@ public:
     Coordinate m_defaultCoordinate{};
     double m_defaultZoom{};
 
+    int m_renderTaskBudget{};
+    int m_maxFrameRate{};
+    int m_statisticsInterval{};
+
+    int m_backgroundThreadCount{};
+    QThread::Priority m_backgroundThreadPriority{QThread::InheritPriority};
+    QList<int> m_backgroundThreadAffinity;
+    bool m_isolatedBackgroundPool{};
+
     Styles m_styles;
 
     std::function<std::string(const std::string &)> m_resourceTransform;
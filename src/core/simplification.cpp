@@ -0,0 +1,337 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "simplification_p.hpp"
+
+#include <QtCore/QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using QMapLibre::Simplification::Algorithm;
+using QMapLibre::Simplification::Options;
+
+// Features per task, small enough to balance uneven features.
+constexpr std::size_t ChunkSize = 64;
+constexpr std::size_t MinimumLineSize = 2;
+constexpr std::size_t MinimumRingSize = 4;
+
+// Buffers reused for all lines simplified by one task. Coordinates are copied
+// into separate x and y arrays so the kernels below run over contiguous
+// doubles without branches, which compilers turn into SIMD code.
+struct Scratch {
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::vector<double> values;
+    std::vector<std::uint8_t> keep;
+    std::vector<std::pair<std::size_t, std::size_t>> ranges;
+    std::vector<std::size_t> previous;
+    std::vector<std::size_t> next;
+    std::vector<std::pair<double, std::size_t>> heap;
+};
+
+// Squared distances of the points [begin, end) to the segment from a to b.
+void segmentDistances(const Scratch &scratch,
+                      std::size_t begin,
+                      std::size_t end,
+                      std::size_t a,
+                      std::size_t b,
+                      double *distances) {
+    const double *xs = scratch.xs.data();
+    const double *ys = scratch.ys.data();
+    const double ax = xs[a];
+    const double ay = ys[a];
+    const double dx = xs[b] - ax;
+    const double dy = ys[b] - ay;
+    const double lengthSquared = dx * dx + dy * dy;
+    const double inverse = lengthSquared > 0 ? 1 / lengthSquared : 0;
+
+    for (std::size_t i = begin; i < end; ++i) {
+        const double px = xs[i] - ax;
+        const double py = ys[i] - ay;
+        const double t = std::min(1.0, std::max(0.0, (px * dx + py * dy) * inverse));
+        const double ex = px - t * dx;
+        const double ey = py - t * dy;
+        distances[i] = ex * ex + ey * ey;
+    }
+}
+
+double triangleArea(const Scratch &scratch, std::size_t a, std::size_t b, std::size_t c) {
+    const double *xs = scratch.xs.data();
+    const double *ys = scratch.ys.data();
+    return 0.5 * std::abs((xs[b] - xs[a]) * (ys[c] - ys[a]) - (xs[c] - xs[a]) * (ys[b] - ys[a]));
+}
+
+// Areas of the triangles each inner point forms with its neighbours.
+void triangleAreas(const Scratch &scratch, std::size_t size, double *areas) {
+    const double *xs = scratch.xs.data();
+    const double *ys = scratch.ys.data();
+    for (std::size_t i = 1; i + 1 < size; ++i) {
+        areas[i] = 0.5 * std::abs((xs[i] - xs[i - 1]) * (ys[i + 1] - ys[i - 1]) -
+                                  (xs[i + 1] - xs[i - 1]) * (ys[i] - ys[i - 1]));
+    }
+}
+
+void douglasPeucker(Scratch &scratch, std::size_t size, double tolerance) {
+    const double toleranceSquared = tolerance * tolerance;
+    double *distances = scratch.values.data();
+
+    scratch.ranges.clear();
+    scratch.ranges.emplace_back(0, size - 1);
+    while (!scratch.ranges.empty()) {
+        const auto [first, last] = scratch.ranges.back();
+        scratch.ranges.pop_back();
+        if (last - first < 2) {
+            continue;
+        }
+
+        segmentDistances(scratch, first + 1, last, first, last, distances);
+        const double *farthest = std::max_element(distances + first + 1, distances + last);
+        if (*farthest > toleranceSquared) {
+            const auto index = static_cast<std::size_t>(farthest - distances);
+            scratch.keep[index] = 1;
+            scratch.ranges.emplace_back(first, index);
+            scratch.ranges.emplace_back(index, last);
+        }
+    }
+}
+
+// Removes the point with the smallest effective area until all remaining
+// areas reach the threshold. Areas of neighbours never drop below the area
+// of a removed point, so removal order matches the original algorithm.
+void visvalingamWhyatt(Scratch &scratch, std::size_t size, double tolerance) {
+    const double threshold = tolerance * tolerance;
+    double *areas = scratch.values.data();
+    areas[0] = areas[size - 1] = std::numeric_limits<double>::infinity();
+    triangleAreas(scratch, size, areas);
+
+    scratch.previous.resize(size);
+    scratch.next.resize(size);
+    scratch.heap.clear();
+    for (std::size_t i = 0; i < size; ++i) {
+        scratch.previous[i] = i - 1;
+        scratch.next[i] = i + 1;
+        if (i > 0 && i + 1 < size) {
+            scratch.heap.emplace_back(areas[i], i);
+        }
+    }
+
+    const auto greater = std::greater<std::pair<double, std::size_t>>();
+    std::make_heap(scratch.heap.begin(), scratch.heap.end(), greater);
+
+    const auto push = [&](std::size_t i, double minimum) {
+        areas[i] = std::max(minimum, triangleArea(scratch, scratch.previous[i], i, scratch.next[i]));
+        scratch.heap.emplace_back(areas[i], i);
+        std::push_heap(scratch.heap.begin(), scratch.heap.end(), greater);
+    };
+
+    while (!scratch.heap.empty()) {
+        std::pop_heap(scratch.heap.begin(), scratch.heap.end(), greater);
+        const auto [area, i] = scratch.heap.back();
+        scratch.heap.pop_back();
+
+        // Stale entry of a point that was removed or got a new area.
+        if (scratch.keep[i] == 0 || area != areas[i]) {
+            continue;
+        }
+        if (area >= threshold) {
+            break;
+        }
+
+        scratch.keep[i] = 0;
+        const std::size_t previous = scratch.previous[i];
+        const std::size_t next = scratch.next[i];
+        scratch.next[previous] = next;
+        scratch.previous[next] = previous;
+        if (previous > 0) {
+            push(previous, area);
+        }
+        if (next + 1 < size) {
+            push(next, area);
+        }
+    }
+}
+
+// Returns false and leaves the line as it is if fewer than minimumSize points
+// would remain.
+template <typename Line>
+bool simplifyLine(Line &line, std::size_t minimumSize, const Options &options, Scratch &scratch) {
+    const std::size_t size = line.size();
+    if (size <= minimumSize) {
+        return size == minimumSize;
+    }
+
+    scratch.xs.resize(size);
+    scratch.ys.resize(size);
+    scratch.values.resize(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        scratch.xs[i] = line[i].x;
+        scratch.ys[i] = line[i].y;
+    }
+
+    if (options.algorithm == Algorithm::VisvalingamWhyatt) {
+        scratch.keep.assign(size, 1);
+        visvalingamWhyatt(scratch, size, options.tolerance);
+    } else {
+        scratch.keep.assign(size, 0);
+        scratch.keep.front() = scratch.keep.back() = 1;
+        douglasPeucker(scratch, size, options.tolerance);
+    }
+
+    if (static_cast<std::size_t>(std::count(scratch.keep.begin(), scratch.keep.end(), 1)) < minimumSize) {
+        return false;
+    }
+
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        if (scratch.keep[i] != 0) {
+            line[kept++] = line[i];
+        }
+    }
+    line.resize(kept);
+    return true;
+}
+
+struct Simplifier {
+    const Options &options;
+    Scratch &scratch;
+
+    void operator()(mapbox::geometry::empty & /* empty */) const {}
+    void operator()(mbgl::Point<double> & /* point */) const {}
+    void operator()(mbgl::MultiPoint<double> & /* multiPoint */) const {}
+
+    void operator()(mbgl::LineString<double> &lineString) const {
+        simplifyLine(lineString, MinimumLineSize, options, scratch);
+    }
+
+    void operator()(mbgl::MultiLineString<double> &multiLineString) const {
+        for (auto &lineString : multiLineString) {
+            (*this)(lineString);
+        }
+    }
+
+    // The outer ring is kept as it is if it would collapse, so the polygon
+    // does not disappear.
+    void operator()(mbgl::Polygon<double> &polygon) const {
+        for (std::size_t i = 0; i < polygon.size();) {
+            if (simplifyLine(polygon[i], MinimumRingSize, options, scratch) || i == 0) {
+                ++i;
+            } else {
+                polygon.erase(polygon.begin() + static_cast<std::ptrdiff_t>(i));
+            }
+        }
+    }
+
+    void operator()(mbgl::MultiPolygon<double> &multiPolygon) const {
+        for (auto &polygon : multiPolygon) {
+            (*this)(polygon);
+        }
+    }
+
+    void operator()(mapbox::geometry::geometry_collection<double> &collection) const {
+        for (auto &geometry : collection) {
+            mapbox::util::apply_visitor(*this, geometry);
+        }
+    }
+};
+
+void simplifyGeometry(mbgl::Geometry<double> &geometry, const Options &options, Scratch &scratch) {
+    mapbox::util::apply_visitor(Simplifier{options, scratch}, geometry);
+}
+
+// Chunks are taken from a shared counter by the calling thread and by
+// helpers on the pool. Helpers that start after all chunks are taken return
+// right away, so the caller only waits for chunks in progress.
+struct Job {
+    explicit Job(std::size_t chunkCount_, std::function<void(std::size_t)> run_)
+        : chunkCount(chunkCount_),
+          run(std::move(run_)) {}
+
+    void work() {
+        for (std::size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+            run(chunk);
+
+            const std::scoped_lock lock(mutex);
+            if (++finishedChunks == chunkCount) {
+                finished.notify_all();
+            }
+        }
+    }
+
+    void wait() {
+        std::unique_lock lock(mutex);
+        finished.wait(lock, [this] { return finishedChunks == chunkCount; });
+    }
+
+    const std::size_t chunkCount;
+    // Only called while the caller waits.
+    const std::function<void(std::size_t)> run;
+    std::atomic<std::size_t> nextChunk{0};
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::size_t finishedChunks{};
+};
+
+void simplifyFeatures(mbgl::FeatureCollection &features,
+                      const Options &options,
+                      const QMapLibre::Simplification::ScheduleFunction &schedule) {
+    const std::size_t chunkCount = (features.size() + ChunkSize - 1) / ChunkSize;
+    if (chunkCount == 0) {
+        return;
+    }
+
+    auto job = std::make_shared<Job>(chunkCount, [&features, &options](std::size_t chunk) {
+        Scratch scratch;
+        const std::size_t end = std::min(features.size(), (chunk + 1) * ChunkSize);
+        for (std::size_t i = chunk * ChunkSize; i < end; ++i) {
+            simplifyGeometry(features[i].geometry, options, scratch);
+        }
+    });
+
+    if (schedule) {
+        const auto helperCount = std::min<std::size_t>(chunkCount, std::max(QThread::idealThreadCount(), 1)) - 1;
+        for (std::size_t i = 0; i < helperCount; ++i) {
+            schedule([job] { job->work(); });
+        }
+    }
+
+    job->work();
+    job->wait();
+}
+
+} // namespace
+
+namespace QMapLibre::Simplification {
+
+void simplify(mbgl::GeoJSON &geojson, const Options &options, const ScheduleFunction &schedule) {
+    if (options.tolerance <= 0) {
+        return;
+    }
+
+    if (geojson.is<mbgl::FeatureCollection>()) {
+        simplifyFeatures(geojson.get<mbgl::FeatureCollection>(), options, schedule);
+        return;
+    }
+
+    Scratch scratch;
+    if (geojson.is<mbgl::GeoJSONFeature>()) {
+        simplifyGeometry(geojson.get<mbgl::GeoJSONFeature>().geometry, options, scratch);
+    } else {
+        simplifyGeometry(geojson.get<mbgl::Geometry<double>>(), options, scratch);
+    }
+}
+
+} // namespace QMapLibre::Simplification
@@ -0,0 +1,43 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include <mbgl/util/geojson.hpp>
+#include <mbgl/util/geometry.hpp>
+
+#include <functional>
+
+namespace QMapLibre::Simplification {
+
+/*! \cond PRIVATE */
+
+enum class Algorithm {
+    DouglasPeucker,
+    VisvalingamWhyatt
+};
+
+struct Options {
+    Algorithm algorithm{Algorithm::DouglasPeucker};
+    // Distance in coordinate units. Visvalingam-Whyatt removes points whose
+    // effective area is below the square of it.
+    double tolerance{};
+};
+
+// Runs a task on a worker thread.
+using ScheduleFunction = std::function<void(std::function<void()>)>;
+
+// Simplifies all lines and polygon rings in place, points are left as they
+// are. Lines keep their end points, rings stay closed and keep at least four
+// points, holes that would collapse are removed.
+//
+// The features of a collection are simplified in chunks spread over worker
+// threads if schedule is set. The calling thread takes part and the call
+// returns once all features are done, so it can be called from a worker of
+// the same pool.
+void simplify(mbgl::GeoJSON &geojson, const Options &options, const ScheduleFunction &schedule = {});
+
+/*! \endcond */
+
+} // namespace QMapLibre::Simplification
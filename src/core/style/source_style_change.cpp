@@ -8,7 +8,6 @@
 #include <QMapLibre/Map>
 
 #include <QtCore/QDebug>
-#include <QtCore/QFile>
 
 namespace QMapLibre {
 
@@ -51,12 +50,9 @@ StyleAddSource::StyleAddSource(const SourceParameter *parameter)
         case 3: { // geojson
             const QString data = parameter->parsedProperty("data").toString();
             if (data.startsWith(':')) {
-                QFile geojson(data);
-                if (geojson.open(QIODevice::ReadOnly)) {
-                    m_params[QStringLiteral("data")] = geojson.readAll();
-                } else {
-                    qWarning() << "Failed to open GeoJSON file:" << data;
-                }
+                // Loaded in the background, the source starts out empty.
+                m_dataPath = data;
+                m_params[QStringLiteral("data")] = QByteArrayLiteral(R"({"type":"FeatureCollection","features":[]})");
             } else {
                 m_params[QStringLiteral("data")] = data.toUtf8();
             }
@@ -75,7 +71,15 @@ void StyleAddSource::apply(Map *map) {
         return;
     }
 
-    map->updateSource(m_id, m_params);
+    if (m_dataPath.isEmpty()) {
+        map->updateSource(m_id, m_params);
+        return;
+    }
+
+    if (!map->sourceExists(m_id)) {
+        map->addSource(m_id, m_params);
+    }
+    map->loadSourceData(m_id, m_dataPath);
 }
 
 // StyleRemoveSource
@@ -26,6 +26,7 @@ public:
 private:
     QString m_id;
     QVariantMap m_params;
+    QString m_dataPath;
 };
 
 class Q_MAPLIBRE_CORE_EXPORT StyleRemoveSource : public StyleChange {
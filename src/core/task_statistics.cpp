@@ -0,0 +1,112 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "task_statistics_p.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <utility>
+
+namespace QMapLibre {
+
+/*! \cond PRIVATE */
+
+void TaskStatistics::enable() {
+    m_users.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TaskStatistics::disable() {
+    m_users.fetch_sub(1, std::memory_order_relaxed);
+}
+
+std::function<void()> TaskStatistics::wrap(std::function<void()> &&function, const mbgl::util::SimpleIdentity owner) {
+    return [this, enqueued = Clock::now(), owner, function = std::move(function)] {
+        const auto start = Clock::now();
+        function();
+        record(start - enqueued, Clock::now() - start, owner);
+    };
+}
+
+void TaskStatistics::record(Clock::duration latency, Clock::duration runTime, const mbgl::util::SimpleIdentity owner) {
+    m_completedTasks.fetch_add(1, std::memory_order_relaxed);
+    m_latency[bucket(latency)].fetch_add(1, std::memory_order_relaxed);
+    m_runTime[bucket(runTime)].fetch_add(1, std::memory_order_relaxed);
+
+    if (runTime.count() <= m_stallThreshold.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    const std::lock_guard<std::mutex> lock(m_stallsMutex);
+
+    const auto shorter = [](const Stall &a, const Stall &b) { return a.runTime > b.runTime; };
+    m_stalls.insert(std::upper_bound(m_stalls.begin(), m_stalls.end(), Stall{runTime, owner}, shorter),
+                    Stall{runTime, owner});
+    if (m_stalls.size() > StallCount) {
+        m_stalls.pop_back();
+    }
+    if (m_stalls.size() == StallCount) {
+        m_stallThreshold.store(m_stalls.back().runTime.count(), std::memory_order_relaxed);
+    }
+
+    // Numbers stay the same for as long as an owner has tasks in the list.
+    std::erase_if(m_ownerNumbers, [this](const auto &number) { return !hasStall(number.first); });
+    std::erase_if(m_owners, [this](const auto &named) { return named.second.released && !hasStall(named.first); });
+    if (!owner.isEmpty() && !m_owners.contains(owner) && !m_ownerNumbers.contains(owner) && hasStall(owner)) {
+        m_ownerNumbers.emplace(owner, m_nextOwnerNumber++);
+    }
+}
+
+void TaskStatistics::setOwnerName(const mbgl::util::SimpleIdentity owner, const QString &name) {
+    const std::lock_guard<std::mutex> lock(m_stallsMutex);
+    m_owners.insert_or_assign(owner, Owner{name});
+}
+
+void TaskStatistics::releaseOwnerName(const mbgl::util::SimpleIdentity owner) {
+    const std::lock_guard<std::mutex> lock(m_stallsMutex);
+    const auto named = m_owners.find(owner);
+    if (named == m_owners.end()) {
+        return;
+    }
+
+    if (hasStall(owner)) {
+        named->second.released = true;
+    } else {
+        m_owners.erase(named);
+    }
+}
+
+// Both called with the stall list locked.
+bool TaskStatistics::hasStall(const mbgl::util::SimpleIdentity owner) const {
+    return std::any_of(
+        m_stalls.cbegin(), m_stalls.cend(), [owner](const Stall &stall) { return stall.owner == owner; });
+}
+
+QString TaskStatistics::ownerName(const mbgl::util::SimpleIdentity owner) const {
+    if (owner.isEmpty()) {
+        return {};
+    }
+
+    if (const auto named = m_owners.find(owner); named != m_owners.cend()) {
+        return named->second.name;
+    }
+
+    const auto number = m_ownerNumbers.find(owner);
+    return QStringLiteral("MapLibre worker %1").arg(number != m_ownerNumbers.cend() ? number->second : 0);
+}
+
+std::size_t TaskStatistics::bucket(Clock::duration duration) {
+    const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    if (microseconds <= 0) {
+        return 0;
+    }
+
+    // Bucket i holds durations from 2^(i-1) up to 2^i microseconds.
+    const auto index = static_cast<std::size_t>(std::bit_width(static_cast<std::uint64_t>(microseconds)));
+    return std::min(index, BucketCount - 1);
+}
+
+/*! \endcond PRIVATE */
+
+} // namespace QMapLibre
@@ -0,0 +1,82 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include "types.hpp"
+
+#include <mbgl/util/identity.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace QMapLibre {
+
+// Latency and run time histograms of the tasks of one queue, and the tasks
+// that ran the longest. Only tasks scheduled while enabled are measured,
+// so a disabled collector costs a single relaxed load per task.
+class TaskStatistics {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t BucketCount = TaskQueueStatistics::BucketCount;
+    static constexpr std::size_t StallCount = 8;
+
+    // Reference counted, queues can be shared by several maps.
+    void enable();
+    void disable();
+    [[nodiscard]] bool isEnabled() const { return m_users.load(std::memory_order_relaxed) > 0; }
+
+    // Returns a task that records its latency and run time when it runs.
+    // Tasks reach us type-erased, the owner they were scheduled for is the
+    // only thing that tells them apart.
+    [[nodiscard]] std::function<void()> wrap(std::function<void()> &&function, mbgl::util::SimpleIdentity owner);
+
+    void record(Clock::duration latency, Clock::duration runTime, mbgl::util::SimpleIdentity owner);
+    // Names the tasks of an owner in the longest tasks, owners without a name
+    // are numbered. A released name is kept while the owner is in the list.
+    void setOwnerName(mbgl::util::SimpleIdentity owner, const QString &name);
+    void releaseOwnerName(mbgl::util::SimpleIdentity owner);
+    // For queues that can only be sampled, like the run loop.
+    void recordLatency(Clock::duration latency);
+
+    [[nodiscard]] TaskQueueStatistics snapshot(quint64 queueDepth) const;
+
+private:
+    struct Stall {
+        Clock::duration runTime;
+        mbgl::util::SimpleIdentity owner;
+    };
+
+    struct Owner {
+        QString name;
+        bool released{};
+    };
+
+    static std::size_t bucket(Clock::duration duration);
+    [[nodiscard]] bool hasStall(mbgl::util::SimpleIdentity owner) const;
+    [[nodiscard]] QString ownerName(mbgl::util::SimpleIdentity owner) const;
+
+    std::atomic<int> m_users{0};
+    std::atomic<std::uint64_t> m_completedTasks{0};
+    std::array<std::atomic<std::uint64_t>, BucketCount> m_latency{};
+    std::array<std::atomic<std::uint64_t>, BucketCount> m_runTime{};
+
+    // Run time a task needs to enter the stall list once it is full.
+    std::atomic<Clock::rep> m_stallThreshold{0};
+    mutable std::mutex m_stallsMutex;
+    std::vector<Stall> m_stalls;
+    std::unordered_map<mbgl::util::SimpleIdentity, Owner> m_owners;
+    // Only for the unnamed owners in the stall list.
+    std::unordered_map<mbgl::util::SimpleIdentity, int> m_ownerNumbers;
+    int m_nextOwnerNumber{1};
+};
+
+} // namespace QMapLibre
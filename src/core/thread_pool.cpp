@@ -0,0 +1,246 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "thread_pool_p.hpp"
+
+#include "settings.hpp"
+
+#include <mbgl/platform/thread.hpp>
+
+#include <QtCore/QDebug>
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#if defined(Q_OS_LINUX)
+#include <sched.h>
+#elif defined(Q_OS_WIN)
+#include <qt_windows.h>
+#endif
+
+namespace {
+
+thread_local const QMapLibre::ThreadPool *owningPool = nullptr;
+
+} // namespace
+
+namespace QMapLibre {
+
+/*! \cond PRIVATE */
+
+ThreadPool::ThreadPool(Configuration configuration)
+    : m_configuration(std::move(configuration)),
+      m_startTime(std::chrono::steady_clock::now()) {
+    const int threadCount = std::max(1, m_configuration.threadCount);
+
+    m_threads.reserve(static_cast<std::size_t>(threadCount));
+    for (int i = 0; i < threadCount; ++i) {
+        std::unique_ptr<QThread> thread(QThread::create([this] { run(); }));
+        thread->setObjectName(QStringLiteral("MapLibre Worker %1").arg(i));
+        thread->start(m_configuration.priority);
+        m_threads.push_back(std::move(thread));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    assert(!isOwningThread());
+
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_terminate = true;
+    }
+    m_cvAvailable.notify_all();
+
+    // Workers drain the remaining tasks before they exit.
+    for (auto &thread : m_threads) {
+        thread->wait();
+    }
+}
+
+std::shared_ptr<ThreadPool> ThreadPool::fromSettings(const Settings &settings) {
+    Configuration configuration{settings.backgroundThreadCount(),
+                                settings.backgroundThreadPriority(),
+                                settings.backgroundThreadAffinity()};
+    const bool isolated = settings.isolatedBackgroundPool();
+
+    if (configuration == Configuration{} && !isolated) {
+        return {};
+    }
+
+    if (configuration.threadCount <= 0) {
+        configuration.threadCount = std::max(1, QThread::idealThreadCount());
+    }
+
+    if (isolated) {
+        return std::make_shared<ThreadPool>(std::move(configuration));
+    }
+
+    static std::mutex registryMutex;
+    static std::vector<std::weak_ptr<ThreadPool>> registry;
+
+    const std::lock_guard<std::mutex> lock(registryMutex);
+    registry.erase(std::remove_if(registry.begin(),
+                                  registry.end(),
+                                  [](const std::weak_ptr<ThreadPool> &pool) { return pool.expired(); }),
+                   registry.end());
+
+    for (const auto &weakPool : registry) {
+        auto pool = weakPool.lock();
+        if (pool && pool->configuration() == configuration) {
+            return pool;
+        }
+    }
+
+    auto pool = std::make_shared<ThreadPool>(std::move(configuration));
+    registry.push_back(pool);
+    return pool;
+}
+
+void ThreadPool::schedule(const mbgl::util::SimpleIdentity tag, std::function<void()> &&function) {
+    assert(function);
+
+    if (m_taskStatistics.isEnabled()) {
+        function = m_taskStatistics.wrap(std::move(function), tag);
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(Task{tag, std::move(function)});
+        ++m_pendingTasks[tag];
+        ++m_pendingTotal;
+    }
+    m_cvAvailable.notify_one();
+}
+
+void ThreadPool::schedule(std::function<void()> &&function) {
+    schedule(mbgl::util::SimpleIdentity::Empty, std::move(function));
+}
+
+void ThreadPool::waitForEmpty(const mbgl::util::SimpleIdentity tag) {
+    // A worker waiting for its own pool would never see it drain.
+    if (isOwningThread()) {
+        qWarning() << "Waiting for a background pool from one of its own workers is not supported.";
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cvEmpty.wait(lock, [this, tag] {
+        return tag.isEmpty() ? m_pendingTotal == 0 : m_pendingTasks.find(tag) == m_pendingTasks.end();
+    });
+}
+
+ThreadPoolStatistics ThreadPool::statistics() const {
+    const auto elapsed = std::chrono::steady_clock::now() - m_startTime;
+
+    const std::lock_guard<std::mutex> lock(m_mutex);
+
+    ThreadPoolStatistics statistics;
+    statistics.threadCount = static_cast<int>(m_threads.size());
+    statistics.busyThreads = m_busyThreads;
+    statistics.queuedTasks = m_tasks.size();
+    statistics.completedTasks = m_completedTasks;
+    if (elapsed.count() > 0 && !m_threads.empty()) {
+        statistics.utilisation = std::chrono::duration<double>(m_busyTime).count() /
+                                 (std::chrono::duration<double>(elapsed).count() *
+                                  static_cast<double>(m_threads.size()));
+    }
+
+    return statistics;
+}
+
+TaskQueueStatistics ThreadPool::taskStatistics() const {
+    quint64 queueDepth = 0;
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        queueDepth = m_pendingTotal;
+    }
+
+    return m_taskStatistics.snapshot(queueDepth);
+}
+
+void ThreadPool::run() {
+    owningPool = this;
+    applyAffinity();
+    mbgl::platform::setCurrentThreadName(QThread::currentThread()->objectName().toStdString());
+    mbgl::platform::attachThread();
+
+    while (true) {
+        Task task{mbgl::util::SimpleIdentity::Empty, {}};
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cvAvailable.wait(lock, [this] { return m_terminate || !m_tasks.empty(); });
+            if (m_tasks.empty()) {
+                break;
+            }
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+            ++m_busyThreads;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        task.function();
+        task.function = nullptr;
+        const auto busyTime = std::chrono::steady_clock::now() - start;
+
+        {
+            const std::lock_guard<std::mutex> lock(m_mutex);
+            --m_busyThreads;
+            ++m_completedTasks;
+            m_busyTime += busyTime;
+
+            auto pending = m_pendingTasks.find(task.tag);
+            assert(pending != m_pendingTasks.end());
+            if (--pending->second == 0) {
+                m_pendingTasks.erase(pending);
+            }
+            --m_pendingTotal;
+        }
+        m_cvEmpty.notify_all();
+    }
+
+    mbgl::platform::detachThread();
+    owningPool = nullptr;
+}
+
+void ThreadPool::applyAffinity() const {
+    if (m_configuration.affinity.isEmpty()) {
+        return;
+    }
+
+#if defined(Q_OS_LINUX)
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (const int cpu : m_configuration.affinity) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpus);
+        }
+    }
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+        qWarning() << "Failed to set the CPU affinity of a background worker.";
+    }
+#elif defined(Q_OS_WIN)
+    DWORD_PTR mask = 0;
+    for (const int cpu : m_configuration.affinity) {
+        if (cpu >= 0 && cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+            mask |= DWORD_PTR{1} << cpu;
+        }
+    }
+    if (mask == 0 || SetThreadAffinityMask(GetCurrentThread(), mask) == 0) {
+        qWarning() << "Failed to set the CPU affinity of a background worker.";
+    }
+#else
+    static std::once_flag warned;
+    std::call_once(warned, [] { qWarning() << "CPU affinity is not supported on this platform."; });
+#endif
+}
+
+bool ThreadPool::isOwningThread() const {
+    return owningPool == this;
+}
+
+/*! \endcond PRIVATE */
+
+} // namespace QMapLibre
@@ -0,0 +1,104 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include "task_statistics_p.hpp"
+#include "types.hpp"
+
+#include <mbgl/actor/scheduler.hpp>
+#include <mbgl/util/identity.hpp>
+
+#include <QtCore/QList>
+#include <QtCore/QThread>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace QMapLibre {
+
+class Settings;
+
+// Background worker pool used in place of the process-wide MapLibre pool
+// when a map asks for a specific size, priority or CPU affinity.
+class ThreadPool : public mbgl::Scheduler {
+public:
+    struct Configuration {
+        int threadCount{};
+        QThread::Priority priority{QThread::InheritPriority};
+        QList<int> affinity;
+
+        bool operator==(const Configuration &other) const = default;
+    };
+
+    explicit ThreadPool(Configuration configuration);
+    ~ThreadPool() override;
+
+    // Returns nullptr if the settings do not ask for a custom pool. Pools
+    // with the same configuration are shared unless isolation is requested.
+    static std::shared_ptr<ThreadPool> fromSettings(const Settings &settings);
+
+    // mbgl::Scheduler implementation.
+    void schedule(const mbgl::util::SimpleIdentity tag, std::function<void()> &&function) final;
+    void schedule(std::function<void()> &&function) final;
+
+    void waitForEmpty(const mbgl::util::SimpleIdentity tag = mbgl::util::SimpleIdentity::Empty) override;
+
+    mapbox::base::WeakPtr<mbgl::Scheduler> makeWeakPtr() override { return weakFactory.makeWeakPtr(); }
+
+    [[nodiscard]] const Configuration &configuration() const { return m_configuration; }
+
+    // Thread-safe.
+    [[nodiscard]] ThreadPoolStatistics statistics() const;
+    [[nodiscard]] TaskQueueStatistics taskStatistics() const;
+    // Latencies and run times are measured while at least one user enabled them.
+    void enableTaskStatistics() { m_taskStatistics.enable(); }
+    void disableTaskStatistics() { m_taskStatistics.disable(); }
+    // Names the tasks scheduled with the tag in the longest tasks.
+    void setTaskOwnerName(const mbgl::util::SimpleIdentity tag, const QString &name) {
+        m_taskStatistics.setOwnerName(tag, name);
+    }
+    void releaseTaskOwnerName(const mbgl::util::SimpleIdentity tag) { m_taskStatistics.releaseOwnerName(tag); }
+
+private:
+    Q_DISABLE_COPY(ThreadPool)
+
+    struct Task {
+        mbgl::util::SimpleIdentity tag;
+        std::function<void()> function;
+    };
+
+    void run();
+    void applyAffinity() const;
+    [[nodiscard]] bool isOwningThread() const;
+
+    const Configuration m_configuration;
+    const std::chrono::steady_clock::time_point m_startTime;
+    std::vector<std::unique_ptr<QThread>> m_threads;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cvAvailable;
+    std::condition_variable m_cvEmpty;
+    std::deque<Task> m_tasks;
+    // Tasks queued or currently running, per tag.
+    std::unordered_map<mbgl::util::SimpleIdentity, std::size_t> m_pendingTasks;
+    std::size_t m_pendingTotal{};
+    bool m_terminate{};
+
+    int m_busyThreads{};
+    std::uint64_t m_completedTasks{};
+    std::chrono::steady_clock::duration m_busyTime{};
+    TaskStatistics m_taskStatistics;
+    mapbox::base::WeakPtrFactory<mbgl::Scheduler> weakFactory{this};
+    // Do not add members here, see `WeakPtrFactory`
+};
+
+} // namespace QMapLibre
@@ -0,0 +1,430 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "threaded_map_renderer.hpp"
+#include "threaded_map_renderer_p.hpp"
+
+#include <QtCore/QDebug>
+
+#ifdef MLN_RENDER_BACKEND_OPENGL
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLExtraFunctions>
+#endif
+
+#include <utility>
+
+#ifdef MLN_RENDER_BACKEND_OPENGL
+namespace {
+
+// Fence sync objects need OpenGL ES 3.0 or OpenGL 3.2.
+bool hasFenceSync(const QOpenGLContext *context) {
+    const QSurfaceFormat format = context->format();
+    const auto version = std::make_pair(format.majorVersion(), format.minorVersion());
+    return context->isOpenGLES() ? version >= std::make_pair(3, 0) : version >= std::make_pair(3, 2);
+}
+
+} // namespace
+#endif
+
+namespace QMapLibre {
+
+/*!
+    \class ThreadedMapRenderer
+    \brief Renders a Map continuously on its own thread.
+    \ingroup QMapLibre
+
+    \headerfile threaded_map_renderer.hpp <QMapLibre/ThreadedMapRenderer>
+
+    ThreadedMapRenderer owns a render thread with an offscreen OpenGL context
+    that shares resources with the context used for composition. The map is
+    rendered on that thread whenever it needs rendering, so its frame rate does
+    not depend on how busy the GUI thread is.
+
+    Finished frames are published as OpenGL textures. After frameReady() is
+    emitted, call acquireFrame() from the composition thread to get the latest
+    one. The texture stays valid and unmodified until the next call to
+    acquireFrame(). The render thread does not wait for the GPU to finish a
+    frame, the composition context waits for it instead when acquiring it.
+
+    The Map itself still lives on the GUI thread and must be controlled from
+    there. It must outlive the renderer, or stop() must be called before it is
+    destroyed.
+
+    Only the OpenGL backend is supported.
+*/
+
+/*!
+    \brief Constructor.
+    \param map The map to render.
+    \param shareContext The context used for composing the published textures.
+    \param parent The parent object.
+
+    If \a shareContext is \c nullptr, QOpenGLContext::globalShareContext()
+    is used, which requires the \c Qt::AA_ShareOpenGLContexts attribute.
+*/
+ThreadedMapRenderer::ThreadedMapRenderer(Map *map, QOpenGLContext *shareContext, QObject *parent)
+    : QObject(parent),
+      d_ptr(std::make_unique<ThreadedMapRendererPrivate>()) {
+    d_ptr->m_map = map;
+#ifdef MLN_RENDER_BACKEND_OPENGL
+    d_ptr->m_shareContext = shareContext;
+    d_ptr->m_thread.setObjectName(QStringLiteral("QMapLibre render thread"));
+#else
+    Q_UNUSED(shareContext);
+#endif
+}
+
+/*!
+    \brief Destructor.
+
+    Stops the render thread if it is running.
+*/
+ThreadedMapRenderer::~ThreadedMapRenderer() {
+    stop();
+}
+
+/*!
+    \brief Start rendering.
+
+    Creates the offscreen context and starts the render thread. Must be called
+    on the GUI thread.
+*/
+void ThreadedMapRenderer::start() {
+    if (isRunning()) {
+        return;
+    }
+
+    if (d_ptr->m_map == nullptr) {
+        qWarning() << "ThreadedMapRenderer: no map to render";
+        return;
+    }
+
+#ifdef MLN_RENDER_BACKEND_OPENGL
+    QOpenGLContext *shareContext = d_ptr->m_shareContext != nullptr ? d_ptr->m_shareContext.data()
+                                                                     : QOpenGLContext::globalShareContext();
+    if (shareContext == nullptr) {
+        qWarning() << "ThreadedMapRenderer: no context to share textures with";
+        return;
+    }
+
+    // Surfaces can only be created on the GUI thread.
+    d_ptr->m_surface = std::make_unique<QOffscreenSurface>();
+    d_ptr->m_surface->setFormat(shareContext->format());
+    d_ptr->m_surface->create();
+
+    auto worker = std::make_unique<ThreadedMapRendererWorker>(d_ptr->m_map, d_ptr->m_surface.get(), shareContext);
+    if (!worker->isValid()) {
+        qWarning() << "ThreadedMapRenderer: failed to create the render context";
+        d_ptr->m_surface.reset();
+        return;
+    }
+
+    d_ptr->m_worker = std::move(worker);
+    d_ptr->m_worker->setSize(d_ptr->m_size, d_ptr->m_pixelRatio);
+    d_ptr->m_worker->moveToThread(&d_ptr->m_thread);
+
+    connect(d_ptr->m_map, &Map::needsRendering, d_ptr->m_worker.get(), &ThreadedMapRendererWorker::requestFrame);
+    connect(d_ptr->m_worker.get(), &ThreadedMapRendererWorker::frameReady, this, &ThreadedMapRenderer::frameReady);
+
+    d_ptr->m_thread.start();
+
+    QMetaObject::invokeMethod(d_ptr->m_worker.get(), &ThreadedMapRendererWorker::requestFrame, Qt::QueuedConnection);
+#else
+    qWarning() << "ThreadedMapRenderer is only supported with the OpenGL backend";
+#endif
+}
+
+/*!
+    \brief Stop rendering.
+
+    Destroys the map renderer and the offscreen context and stops the render
+    thread. Textures returned by acquireFrame() are no longer valid afterwards.
+*/
+void ThreadedMapRenderer::stop() {
+    if (!isRunning()) {
+        return;
+    }
+
+#ifdef MLN_RENDER_BACKEND_OPENGL
+    QMetaObject::invokeMethod(
+        d_ptr->m_worker.get(), &ThreadedMapRendererWorker::shutdown, Qt::BlockingQueuedConnection);
+
+    d_ptr->m_thread.quit();
+    d_ptr->m_thread.wait();
+
+    d_ptr->m_worker.reset();
+    d_ptr->m_surface.reset();
+#endif
+}
+
+/*!
+    \brief Returns whether the render thread is running.
+    \return \c true if running.
+*/
+bool ThreadedMapRenderer::isRunning() const {
+#ifdef MLN_RENDER_BACKEND_OPENGL
+    return d_ptr->m_worker != nullptr;
+#else
+    return false;
+#endif
+}
+
+/*!
+    \brief Set the size of the rendered frames.
+    \param size The size in device independent pixels.
+    \param pixelRatio The pixel ratio of the screen.
+
+    The map itself has to be resized separately with Map::resize().
+*/
+void ThreadedMapRenderer::setSize(const QSize &size, qreal pixelRatio) {
+    d_ptr->m_size = size;
+    d_ptr->m_pixelRatio = pixelRatio;
+
+#ifdef MLN_RENDER_BACKEND_OPENGL
+    if (d_ptr->m_worker != nullptr) {
+        d_ptr->m_worker->setSize(size, pixelRatio);
+        QMetaObject::invokeMethod(
+            d_ptr->m_worker.get(), &ThreadedMapRendererWorker::requestFrame, Qt::QueuedConnection);
+    }
+#endif
+}
+
+/*!
+    \brief Acquire the latest rendered frame.
+    \param textureSize Receives the size of the texture in pixels, if not \c nullptr.
+    \return The OpenGL texture ID, or \c 0 if no frame was rendered yet.
+
+    The previously acquired texture is released. The returned texture will not
+    be rendered into until the next call. Thread-safe, usually called on the
+    thread composing the frames.
+
+    A context sharing resources with the render context has to be current,
+    commands issued on it afterwards wait for the GPU to finish the frame
+    without blocking the calling thread.
+*/
+quint32 ThreadedMapRenderer::acquireFrame(QSize *textureSize) {
+#ifdef MLN_RENDER_BACKEND_OPENGL
+    if (d_ptr->m_worker == nullptr) {
+        return 0;
+    }
+
+    return d_ptr->m_worker->acquireFrame(textureSize);
+#else
+    Q_UNUSED(textureSize);
+    return 0;
+#endif
+}
+
+/*!
+    \fn void ThreadedMapRenderer::frameReady()
+    \brief Signal emitted when a new frame has been rendered.
+
+    \sa acquireFrame()
+*/
+
+/*! \cond PRIVATE */
+
+#ifdef MLN_RENDER_BACKEND_OPENGL
+ThreadedMapRendererWorker::ThreadedMapRendererWorker(Map *map,
+                                                     QOffscreenSurface *surface,
+                                                     QOpenGLContext *shareContext)
+    : m_map(map),
+      m_surface(surface),
+      m_context(new QOpenGLContext(this)) {
+    // Parented, so it moves to the render thread together with us.
+    m_context->setFormat(surface->format());
+    m_context->setShareContext(shareContext);
+    m_context->create();
+    // The consumer waits on the fences with the shared context.
+    m_fenceSync = m_context->isValid() && hasFenceSync(m_context) && hasFenceSync(shareContext);
+}
+
+ThreadedMapRendererWorker::~ThreadedMapRendererWorker() = default;
+
+bool ThreadedMapRendererWorker::isValid() const {
+    return m_context != nullptr && m_context->isValid() && m_surface->isValid();
+}
+
+void ThreadedMapRendererWorker::setSize(const QSize &size, qreal pixelRatio) {
+    const std::scoped_lock lock(m_frameMutex);
+    m_size = size;
+    m_pixelRatio = pixelRatio;
+}
+
+quint32 ThreadedMapRendererWorker::acquireFrame(QSize *textureSize) {
+    const std::scoped_lock lock(m_frameMutex);
+
+    m_acquiredTexture = m_frontTexture;
+    if (m_acquiredTexture < 0) {
+        return 0;
+    }
+
+    if (textureSize != nullptr) {
+        *textureSize = m_textureSizes[m_acquiredTexture];
+    }
+
+    // Held under the lock, the render thread only deletes the fence of a
+    // texture that is neither the front nor the acquired one.
+    const GLsync fence = m_fences[m_acquiredTexture];
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (fence != nullptr && context != nullptr) {
+        context->extraFunctions()->glWaitSync(fence, 0, GL_TIMEOUT_IGNORED);
+    }
+
+    return m_textures[m_acquiredTexture];
+}
+
+void ThreadedMapRendererWorker::requestFrame() {
+    // Coalesce requests arriving while a frame is queued.
+    if (m_frameRequested) {
+        return;
+    }
+
+    m_frameRequested = true;
+    QMetaObject::invokeMethod(
+        this,
+        [this] {
+            m_frameRequested = false;
+            renderFrame();
+        },
+        Qt::QueuedConnection);
+}
+
+void ThreadedMapRendererWorker::renderFrame() {
+    if (m_map == nullptr || !m_context->makeCurrent(m_surface)) {
+        return;
+    }
+
+    QSize size;
+    qreal pixelRatio{};
+    std::size_t target = 0;
+    {
+        const std::scoped_lock lock(m_frameMutex);
+        size = m_size;
+        pixelRatio = m_pixelRatio;
+
+        while (std::cmp_equal(target, m_frontTexture) || std::cmp_equal(target, m_acquiredTexture)) {
+            ++target;
+        }
+    }
+
+    const QSize pixelSize = size * pixelRatio;
+    if (pixelSize.isEmpty()) {
+        return;
+    }
+
+    QOpenGLExtraFunctions *gl = m_context->extraFunctions();
+
+    if (!m_rendererCreated) {
+        gl->glGenFramebuffers(1, &m_fbo);
+        m_map->createRenderer(nullptr);
+        m_rendererCreated = true;
+    }
+
+    if (m_fboSize != pixelSize) {
+        // Creates the color and depth attachments of our framebuffer.
+        m_map->updateRenderer(size, pixelRatio, m_fbo);
+        m_fboSize = pixelSize;
+    }
+
+    // Only the render thread writes the texture IDs, sizes and fences. The
+    // consumer is done waiting on the fence of a texture it released.
+    if (m_fences[target] != nullptr) {
+        gl->glDeleteSync(m_fences[target]);
+        m_fences[target] = nullptr;
+    }
+
+    if (m_textures[target] == 0) {
+        gl->glGenTextures(1, &m_textures[target]);
+    }
+
+    gl->glBindTexture(GL_TEXTURE_2D, m_textures[target]);
+    if (m_textureSizes[target] != pixelSize) {
+#ifdef GL_RGBA8
+        gl->glTexImage2D(
+            GL_TEXTURE_2D, 0, GL_RGBA8, pixelSize.width(), pixelSize.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+#else
+        gl->glTexImage2D(
+            GL_TEXTURE_2D, 0, GL_RGBA, pixelSize.width(), pixelSize.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+#endif
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    m_map->render();
+
+    // Copy out of the renderer framebuffer, so it never has to be reattached
+    // while the consumer holds on to a texture.
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    gl->glBindTexture(GL_TEXTURE_2D, m_textures[target]);
+    gl->glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, pixelSize.width(), pixelSize.height());
+    gl->glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Another context samples the texture, it waits for the fence. The flush
+    // makes sure the fence reaches the GPU, otherwise the wait never ends.
+    GLsync fence{};
+    if (m_fenceSync) {
+        fence = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        gl->glFlush();
+    } else {
+        gl->glFinish();
+    }
+
+    {
+        const std::scoped_lock lock(m_frameMutex);
+        m_textureSizes[target] = pixelSize;
+        m_fences[target] = fence;
+        m_frontTexture = static_cast<int>(target);
+    }
+
+    emit frameReady();
+}
+
+void ThreadedMapRendererWorker::shutdown() {
+    if (m_context->makeCurrent(m_surface)) {
+        if (m_rendererCreated && m_map != nullptr) {
+            m_map->destroyRenderer();
+        }
+
+        QOpenGLExtraFunctions *gl = m_context->extraFunctions();
+        for (GLsync &fence : m_fences) {
+            if (fence != nullptr) {
+                gl->glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+
+        for (quint32 &texture : m_textures) {
+            if (texture != 0) {
+                gl->glDeleteTextures(1, &texture);
+                texture = 0;
+            }
+        }
+
+        if (m_fbo != 0) {
+            gl->glDeleteFramebuffers(1, &m_fbo);
+            m_fbo = 0;
+        }
+
+        m_context->doneCurrent();
+    }
+
+    m_rendererCreated = false;
+
+    // Contexts must be destroyed on the thread they are current on.
+    delete m_context;
+    m_context = nullptr;
+
+    const std::scoped_lock lock(m_frameMutex);
+    m_frontTexture = -1;
+    m_acquiredTexture = -1;
+}
+#endif
+
+/*! \endcond */
+
+} // namespace QMapLibre
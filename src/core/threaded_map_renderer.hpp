@@ -0,0 +1,50 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#ifndef QMAPLIBRE_THREADED_MAP_RENDERER_H
+#define QMAPLIBRE_THREADED_MAP_RENDERER_H
+
+#include <QMapLibre/Export>
+
+#include <QtCore/QObject>
+#include <QtCore/QSize>
+
+#include <memory>
+
+QT_BEGIN_NAMESPACE
+class QOpenGLContext;
+QT_END_NAMESPACE
+
+namespace QMapLibre {
+
+class Map;
+class ThreadedMapRendererPrivate;
+
+class Q_MAPLIBRE_CORE_EXPORT ThreadedMapRenderer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ThreadedMapRenderer(Map *map, QOpenGLContext *shareContext = nullptr, QObject *parent = nullptr);
+    ~ThreadedMapRenderer() override;
+
+    void start();
+    void stop();
+    [[nodiscard]] bool isRunning() const;
+
+    void setSize(const QSize &size, qreal pixelRatio);
+
+    [[nodiscard]] quint32 acquireFrame(QSize *textureSize = nullptr);
+
+signals:
+    void frameReady();
+
+private:
+    Q_DISABLE_COPY(ThreadedMapRenderer)
+
+    std::unique_ptr<ThreadedMapRendererPrivate> d_ptr;
+};
+
+} // namespace QMapLibre
+
+#endif // QMAPLIBRE_THREADED_MAP_RENDERER_H
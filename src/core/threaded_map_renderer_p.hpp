@@ -0,0 +1,103 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include "map.hpp"
+#include "threaded_map_renderer.hpp"
+
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtCore/QSize>
+#include <QtCore/QThread>
+
+#ifdef MLN_RENDER_BACKEND_OPENGL
+#include <QtGui/qopengl.h>
+#endif
+
+#include <array>
+#include <memory>
+#include <mutex>
+
+QT_BEGIN_NAMESPACE
+class QOffscreenSurface;
+class QOpenGLContext;
+QT_END_NAMESPACE
+
+namespace QMapLibre {
+
+#ifdef MLN_RENDER_BACKEND_OPENGL
+// Lives on the render thread and owns everything that needs its context.
+class ThreadedMapRendererWorker : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr std::size_t TextureCount = 3;
+
+    ThreadedMapRendererWorker(Map *map, QOffscreenSurface *surface, QOpenGLContext *shareContext);
+    ~ThreadedMapRendererWorker() override;
+
+    [[nodiscard]] bool isValid() const;
+
+    // Thread-safe.
+    void setSize(const QSize &size, qreal pixelRatio);
+    [[nodiscard]] quint32 acquireFrame(QSize *textureSize);
+
+public slots:
+    void requestFrame();
+    void shutdown();
+
+signals:
+    void frameReady();
+
+private:
+    Q_DISABLE_COPY(ThreadedMapRendererWorker)
+
+    void renderFrame();
+
+    QPointer<Map> m_map;
+    QOffscreenSurface *m_surface{};
+    QOpenGLContext *m_context{};
+    bool m_fenceSync{};
+
+    bool m_frameRequested{};
+    bool m_rendererCreated{};
+
+    // Owned by the renderer, the frame is copied out of it once complete.
+    quint32 m_fbo{};
+    QSize m_fboSize;
+
+    std::mutex m_frameMutex;
+    QSize m_size;
+    qreal m_pixelRatio{1.0};
+    // Published frames. The front one is the latest complete frame and the
+    // acquired one may still be sampled by the consumer, the third one is
+    // always free to render into.
+    std::array<quint32, TextureCount> m_textures{};
+    std::array<QSize, TextureCount> m_textureSizes{};
+    // Signaled once the frame in the texture of the same index is complete,
+    // the consumer waits on it before sampling. Empty without fence support.
+    std::array<GLsync, TextureCount> m_fences{};
+    int m_frontTexture{-1};
+    int m_acquiredTexture{-1};
+};
+#endif
+
+class ThreadedMapRendererPrivate {
+public:
+    QPointer<Map> m_map;
+
+#ifdef MLN_RENDER_BACKEND_OPENGL
+    QPointer<QOpenGLContext> m_shareContext;
+
+    QThread m_thread;
+    std::unique_ptr<QOffscreenSurface> m_surface;
+    std::unique_ptr<ThreadedMapRendererWorker> m_worker;
+#endif
+
+    QSize m_size;
+    qreal m_pixelRatio{1.0};
+};
+
+} // namespace QMapLibre
@@ -0,0 +1,527 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "tile_renderer.hpp"
+#include "tile_renderer_p.hpp"
+
+#include <QtCore/QBuffer>
+#include <QtCore/QDebug>
+#include <QtCore/QFuture>
+#include <QtCore/QtMath>
+#include <QtGui/QImageWriter>
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <utility>
+
+namespace {
+
+// Size of a tile in device independent pixels at its own zoom level.
+constexpr int NativeTileSize = 512;
+constexpr int MaxTileZoom = 30;
+
+QString validate(const QMapLibre::TileId &tile, int tileSize) {
+    if (tile.z < 0 || tile.z > MaxTileZoom || tile.x < 0 || tile.y < 0 || tile.x >= (1 << tile.z) ||
+        tile.y >= (1 << tile.z)) {
+        return QStringLiteral("invalid tile %1/%2/%3").arg(tile.z).arg(tile.x).arg(tile.y);
+    }
+
+    if ((NativeTileSize >> tile.z) > tileSize) {
+        return QStringLiteral("zoom level %1 is too low for the tile size").arg(tile.z);
+    }
+
+    return {};
+}
+
+} // namespace
+
+namespace QMapLibre {
+
+/*!
+    \struct TileId
+    \brief Coordinates of a tile in the XYZ scheme.
+    \ingroup QMapLibre
+
+    \headerfile tile_renderer.hpp <QMapLibre/TileRenderer>
+
+    \a x grows eastwards and \a y southwards from the top left tile of zoom
+    level \a z.
+*/
+
+/*!
+    \class TileRenderer
+    \brief Renders map tiles to encoded images.
+    \ingroup QMapLibre
+
+    \headerfile tile_renderer.hpp <QMapLibre/TileRenderer>
+
+    TileRenderer produces raster tiles from a style. Pass the tiles to
+    render() and collect the encoded images from tileReady() as they
+    arrive, possibly out of order. finished() is emitted once all tiles are
+    reported.
+
+    The tiles are rendered by headless static maps that are set up once and
+    reused for every tile. Each map moves on to its next tile as soon as the
+    previous one is read back, so the GPU copy, the readback and the
+    encoding on a thread pool overlap with rendering the following tiles.
+    With setRendererCount() several maps work on the queue at the same time,
+    which mostly helps when tiles wait for their resources to load.
+
+    The maps live on the thread of the TileRenderer, which needs a running
+    event loop. Requires a QGuiApplication and a build with the
+    \c MLN_QT_WITH_HEADLESS CMake option.
+
+    \code
+        QMapLibre::TileRenderer renderer;
+        renderer.setStyleUrl(QStringLiteral("https://demotiles.maplibre.org/style.json"));
+
+        QObject::connect(&renderer, &QMapLibre::TileRenderer::tileReady,
+                         [](const QMapLibre::TileId &tile, const QByteArray &data) {
+            // Store the PNG image of the tile.
+        });
+
+        renderer.render({{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {1, 0, 1}, {1, 1, 1}});
+    \endcode
+*/
+
+/*!
+    \enum TileRenderer::ImageFormat
+    \brief Encoding of the rendered tiles.
+
+    \value PNG Lossless PNG images.
+    \value WebP WebP images, needs the WebP plugin of the Qt Image Formats
+           module.
+*/
+
+/*!
+    \brief Constructor.
+    \param settings The settings of the maps rendering the tiles.
+    \param parent The parent object.
+
+    The maps are always created in Settings::Static mode.
+*/
+TileRenderer::TileRenderer(const Settings &settings, QObject *parent)
+    : QObject(parent),
+      d_ptr(std::make_unique<TileRendererPrivate>(this, settings)) {}
+
+/*!
+    \brief Destructor.
+
+    Tiles that were not reported yet are dropped.
+*/
+TileRenderer::~TileRenderer() = default;
+
+/*!
+    \brief Set the style from a URL.
+    \param url The style URL.
+*/
+void TileRenderer::setStyleUrl(const QString &url) {
+    d_ptr->m_styleUrl = url;
+    d_ptr->m_styleJson.clear();
+
+    for (const auto &instance : d_ptr->m_instances) {
+        instance->map->setStyleUrl(url);
+    }
+}
+
+/*!
+    \brief Set the style from JSON.
+    \param json The style JSON.
+*/
+void TileRenderer::setStyleJson(const QString &json) {
+    d_ptr->m_styleJson = json;
+    d_ptr->m_styleUrl.clear();
+
+    for (const auto &instance : d_ptr->m_instances) {
+        instance->map->setStyleJson(json);
+    }
+}
+
+/*!
+    \brief Returns the tile size.
+    \return The width and height of tiles in device independent pixels.
+*/
+int TileRenderer::tileSize() const {
+    return d_ptr->m_tileSize;
+}
+
+/*!
+    \brief Set the tile size.
+    \param size The width and height of tiles in device independent pixels.
+
+    Defaults to 512. Tiles smaller than that need a higher zoom level, a
+    256 pixel tile can't be rendered at zoom level 0 for example.
+
+    Applies to tiles not started yet, including those already waiting. The
+    maps are recreated once the tiles in progress are reported.
+*/
+void TileRenderer::setTileSize(int size) {
+    d_ptr->m_tileSize = std::max(size, 1);
+    d_ptr->m_instancesChanged = true;
+}
+
+/*!
+    \brief Returns the pixel ratio of the tiles.
+    \return The pixel ratio.
+*/
+qreal TileRenderer::pixelRatio() const {
+    return d_ptr->m_pixelRatio;
+}
+
+/*!
+    \brief Set the pixel ratio of the tiles.
+    \param pixelRatio The pixel ratio, \c 2 for high resolution tiles.
+
+    The images are tileSize() times \a pixelRatio pixels wide.
+
+    Applies to tiles not started yet, including those already waiting. The
+    maps are recreated once the tiles in progress are reported.
+*/
+void TileRenderer::setPixelRatio(qreal pixelRatio) {
+    d_ptr->m_pixelRatio = pixelRatio;
+    d_ptr->m_instancesChanged = true;
+}
+
+/*!
+    \brief Returns the image format.
+    \return The format the tiles are encoded in.
+*/
+TileRenderer::ImageFormat TileRenderer::imageFormat() const {
+    return d_ptr->m_format;
+}
+
+/*!
+    \brief Set the image format.
+    \param format The format the tiles are encoded in.
+    \param quality The quality from \c 0 to \c 100, or \c -1 for the
+           default of the encoder.
+
+    Defaults to PNG.
+*/
+void TileRenderer::setImageFormat(ImageFormat format, int quality) {
+    if (format == WebP && !QImageWriter::supportedImageFormats().contains("webp")) {
+        qWarning() << "TileRenderer: WebP is not supported, the Qt image formats plugin is missing";
+    }
+
+    d_ptr->m_format = format;
+    d_ptr->m_quality = quality;
+}
+
+/*!
+    \brief Returns the number of maps rendering tiles.
+    \return The renderer count.
+*/
+int TileRenderer::rendererCount() const {
+    return d_ptr->m_rendererCount;
+}
+
+/*!
+    \brief Set the number of maps rendering tiles.
+    \param count The renderer count.
+
+    Each map has its own renderer, GPU resources and tile cache. Defaults
+    to \c 1.
+
+    Applies to tiles not started yet, including those already waiting. The
+    maps are recreated once the tiles in progress are reported.
+*/
+void TileRenderer::setRendererCount(int count) {
+    d_ptr->m_rendererCount = std::max(count, 1);
+    d_ptr->m_instancesChanged = true;
+}
+
+/*!
+    \brief Render tiles.
+    \param tiles The tiles to render.
+
+    The tiles are appended to the ones still waiting, each is reported by
+    either tileReady() or tileFailed().
+*/
+void TileRenderer::render(const QList<TileId> &tiles) {
+    if (tiles.isEmpty()) {
+        return;
+    }
+
+#ifdef MLN_QT_WITH_HEADLESS
+    d_ptr->m_queue.insert(d_ptr->m_queue.end(), tiles.cbegin(), tiles.cend());
+    d_ptr->start();
+#else
+    qWarning() << "TileRenderer requires a build with MLN_QT_WITH_HEADLESS";
+    for (const TileId &tile : tiles) {
+        d_ptr->failLater(tile, QStringLiteral("headless rendering is not available"));
+    }
+#endif
+}
+
+/*!
+    \brief Cancel rendering.
+
+    Drops the tiles waiting to be rendered. Tiles in progress are finished
+    but not reported, finished() is not emitted.
+*/
+void TileRenderer::cancel() {
+    d_ptr->m_queue.clear();
+    d_ptr->m_pending = 0;
+    ++d_ptr->m_generation;
+}
+
+/*!
+    \brief Returns whether tiles are being rendered.
+    \return \c true if tiles were not reported yet.
+*/
+bool TileRenderer::isRendering() const {
+    return d_ptr->m_pending > 0 || !d_ptr->m_queue.empty();
+}
+
+/*!
+    \fn void TileRenderer::tileReady(const QMapLibre::TileId &tile, const QByteArray &data)
+    \brief Signal emitted when a tile is rendered.
+    \param tile The tile.
+    \param data The encoded image.
+*/
+
+/*!
+    \fn void TileRenderer::tileFailed(const QMapLibre::TileId &tile, const QString &error)
+    \brief Signal emitted when a tile can't be rendered.
+    \param tile The tile.
+    \param error The error message.
+*/
+
+/*!
+    \fn void TileRenderer::finished()
+    \brief Signal emitted when all tiles are reported.
+*/
+
+/*! \cond PRIVATE */
+
+TileRendererPrivate::TileRendererPrivate(TileRenderer *q, const Settings &settings)
+    : q_ptr(q),
+      m_settings(settings) {
+    m_settings.setMapMode(Settings::Static);
+    m_settings.setConstrainMode(Settings::NoConstrain);
+}
+
+TileRendererPrivate::~TileRendererPrivate() {
+    // Destroying the maps cancels their reads in flight, which must neither
+    // be reported nor reach the members destroyed before the maps.
+    ++m_generation;
+    m_queue.clear();
+    m_instances.clear();
+    m_encoderPool.waitForDone();
+}
+
+bool TileRendererPrivate::idle() const {
+    return m_pending == 0 && std::none_of(m_instances.cbegin(), m_instances.cend(), [](const auto &instance) {
+               return instance->tile.has_value();
+           });
+}
+
+bool TileRendererPrivate::createInstances() {
+#ifdef MLN_QT_WITH_HEADLESS
+    if (!m_instances.empty() && (!m_instancesChanged || !idle())) {
+        return true;
+    }
+
+    m_instances.clear();
+    m_instancesChanged = false;
+
+    for (int i = 0; i < m_rendererCount; ++i) {
+        auto instance = std::make_unique<Instance>();
+        instance->map = std::make_unique<Map>(nullptr, m_settings, QSize(m_tileSize, m_tileSize), m_pixelRatio);
+        instance->tileSize = m_tileSize;
+        if (!m_styleJson.isEmpty()) {
+            instance->map->setStyleJson(m_styleJson);
+        } else if (!m_styleUrl.isEmpty()) {
+            instance->map->setStyleUrl(m_styleUrl);
+        }
+
+        if (!instance->map->createHeadlessRenderer()) {
+            m_instances.clear();
+            return false;
+        }
+
+        Instance *target = instance.get();
+        QObject::connect(instance->map.get(), &Map::needsRendering, q_ptr, [this, target] { renderInstance(*target); });
+        QObject::connect(instance->map.get(), &Map::staticRenderFinished, q_ptr, [this, target](const QString &error) {
+            stillFinished(*target, error);
+        });
+
+        m_instances.push_back(std::move(instance));
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Hands the queued tiles to the idle maps.
+void TileRendererPrivate::start() {
+    if (!createInstances()) {
+        qWarning() << "TileRenderer: unable to create a headless renderer";
+        while (!m_queue.empty()) {
+            failLater(m_queue.front(), QStringLiteral("unable to create a headless renderer"));
+            m_queue.pop_front();
+        }
+        return;
+    }
+
+    for (const auto &instance : m_instances) {
+        if (!instance->tile) {
+            next(*instance);
+        }
+    }
+}
+
+// Maps with outdated settings are recreated once the last of their tiles is
+// reported. Never from within their own signals, hence queued.
+void TileRendererPrivate::restartLater() {
+    QMetaObject::invokeMethod(
+        q_ptr,
+        [this] {
+            if (m_instancesChanged && !m_queue.empty() && idle()) {
+                start();
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+void TileRendererPrivate::next(Instance &instance) {
+    instance.tile.reset();
+    instance.reading = false;
+
+    if (m_instancesChanged) {
+        restartLater();
+        return;
+    }
+
+    while (!m_queue.empty()) {
+        const TileId tile = m_queue.front();
+        m_queue.pop_front();
+
+        const QString error = validate(tile, instance.tileSize);
+        if (!error.isEmpty()) {
+            failLater(tile, error);
+            continue;
+        }
+
+        ++m_pending;
+        instance.tile = tile;
+        instance.generation = m_generation;
+
+        // Centered on the tile at the zoom level where it fills the map.
+        const double n = std::exp2(tile.z);
+        const double longitude = (tile.x + 0.5) / n * 360.0 - 180.0;
+        const double latitude = qRadiansToDegrees(
+            std::atan(std::sinh(std::numbers::pi * (1 - 2 * (tile.y + 0.5) / n))));
+        const double zoom = tile.z + std::log2(static_cast<double>(instance.tileSize) / NativeTileSize);
+
+        instance.map->setCoordinateZoom(Coordinate(latitude, longitude), zoom);
+        instance.map->startStaticRender();
+        return;
+    }
+}
+
+void TileRendererPrivate::renderInstance(Instance &instance) {
+    instance.map->render();
+
+    // This frame started reading the still back, the map can move on while
+    // the copy is in flight.
+    if (instance.reading) {
+        next(instance);
+    }
+}
+
+void TileRendererPrivate::stillFinished(Instance &instance, const QString &error) {
+    if (!instance.tile) {
+        return;
+    }
+
+    const TileId tile = *instance.tile;
+    const quint64 generation = instance.generation;
+
+    if (!error.isEmpty()) {
+        fail(tile, generation, error);
+        next(instance);
+        return;
+    }
+
+#ifdef MLN_QT_WITH_HEADLESS
+    instance.reading = true;
+    instance.map->grabFrameAsync()
+        .then(q_ptr, [this, tile, generation](const QImage &image) { encode(tile, generation, image); })
+        .onCanceled(q_ptr, [this, tile, generation] {
+            fail(tile, generation, QStringLiteral("the frame could not be read back"));
+        });
+#endif
+}
+
+void TileRendererPrivate::encode(const TileId &tile, quint64 generation, const QImage &image) {
+    if (generation != m_generation) {
+        return;
+    }
+
+    const char *format = m_format == TileRenderer::WebP ? "WEBP" : "PNG";
+    m_encoderPool.start([this, tile, generation, image, format, quality = m_quality] {
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        const bool encoded = image.save(&buffer, format, quality);
+
+        QMetaObject::invokeMethod(
+            q_ptr,
+            [this, tile, generation, encoded, data = std::move(data)] {
+                if (encoded) {
+                    succeed(tile, generation, data);
+                } else {
+                    fail(tile, generation, QStringLiteral("the image could not be encoded"));
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void TileRendererPrivate::succeed(const TileId &tile, quint64 generation, const QByteArray &data) {
+    if (generation != m_generation) {
+        return;
+    }
+
+    emit q_ptr->tileReady(tile, data);
+    if (--m_pending == 0) {
+        reported();
+    }
+}
+
+// Tiles are never reported from within render(), so all tiles are reported
+// the same way.
+void TileRendererPrivate::failLater(const TileId &tile, const QString &error) {
+    ++m_pending;
+    QMetaObject::invokeMethod(
+        q_ptr, [this, tile, generation = m_generation, error] { fail(tile, generation, error); }, Qt::QueuedConnection);
+}
+
+void TileRendererPrivate::fail(const TileId &tile, quint64 generation, const QString &error) {
+    if (generation != m_generation) {
+        return;
+    }
+
+    emit q_ptr->tileFailed(tile, error);
+    if (--m_pending == 0) {
+        reported();
+    }
+}
+
+// All tiles taken are reported, the rest waits for the maps to be recreated.
+void TileRendererPrivate::reported() {
+    if (m_queue.empty()) {
+        emit q_ptr->finished();
+    } else {
+        restartLater();
+    }
+}
+
+/*! \endcond */
+
+} // namespace QMapLibre
@@ -0,0 +1,76 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#ifndef QMAPLIBRE_TILE_RENDERER_H
+#define QMAPLIBRE_TILE_RENDERER_H
+
+#include <QMapLibre/Export>
+#include <QMapLibre/Settings>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+#include <memory>
+
+namespace QMapLibre {
+
+struct Q_MAPLIBRE_CORE_EXPORT TileId {
+    int z{};
+    int x{};
+    int y{};
+
+    friend bool operator==(const TileId &lhs, const TileId &rhs) = default;
+};
+
+class TileRendererPrivate;
+
+class Q_MAPLIBRE_CORE_EXPORT TileRenderer : public QObject {
+    Q_OBJECT
+
+public:
+    enum ImageFormat {
+        PNG = 0,
+        WebP
+    };
+
+    explicit TileRenderer(const Settings &settings = Settings(), QObject *parent = nullptr);
+    ~TileRenderer() override;
+
+    void setStyleUrl(const QString &url);
+    void setStyleJson(const QString &json);
+
+    [[nodiscard]] int tileSize() const;
+    void setTileSize(int size);
+
+    [[nodiscard]] qreal pixelRatio() const;
+    void setPixelRatio(qreal pixelRatio);
+
+    [[nodiscard]] ImageFormat imageFormat() const;
+    void setImageFormat(ImageFormat format, int quality = -1);
+
+    [[nodiscard]] int rendererCount() const;
+    void setRendererCount(int count);
+
+    void render(const QList<TileId> &tiles);
+    void cancel();
+    [[nodiscard]] bool isRendering() const;
+
+signals:
+    void tileReady(const QMapLibre::TileId &tile, const QByteArray &data);
+    void tileFailed(const QMapLibre::TileId &tile, const QString &error);
+    void finished();
+
+private:
+    Q_DISABLE_COPY(TileRenderer)
+
+    std::unique_ptr<TileRendererPrivate> d_ptr;
+};
+
+} // namespace QMapLibre
+
+Q_DECLARE_METATYPE(QMapLibre::TileId);
+
+#endif // QMAPLIBRE_TILE_RENDERER_H
@@ -0,0 +1,80 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include "map.hpp"
+#include "settings.hpp"
+#include "tile_renderer.hpp"
+
+#include <QtCore/QString>
+#include <QtCore/QThreadPool>
+#include <QtGui/QImage>
+
+#include <deque>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace QMapLibre {
+
+/*! \cond PRIVATE */
+
+class TileRendererPrivate {
+public:
+    // A headless map rendering one tile at a time.
+    struct Instance {
+        std::unique_ptr<Map> map;
+        // The size the map was created with.
+        int tileSize{};
+        std::optional<TileId> tile;
+        quint64 generation{};
+        // Set once the still is drawn, the next frame starts reading it back.
+        bool reading{};
+    };
+
+    TileRendererPrivate(TileRenderer *q, const Settings &settings);
+    ~TileRendererPrivate();
+
+    bool idle() const;
+    bool createInstances();
+    void start();
+    void restartLater();
+    void next(Instance &instance);
+    void renderInstance(Instance &instance);
+    void stillFinished(Instance &instance, const QString &error);
+    void encode(const TileId &tile, quint64 generation, const QImage &image);
+    void succeed(const TileId &tile, quint64 generation, const QByteArray &data);
+    void fail(const TileId &tile, quint64 generation, const QString &error);
+    void failLater(const TileId &tile, const QString &error);
+    void reported();
+
+    TileRenderer *q_ptr{};
+    Settings m_settings;
+
+    QString m_styleUrl;
+    QString m_styleJson;
+    int m_tileSize{512};
+    qreal m_pixelRatio{1.0};
+    TileRenderer::ImageFormat m_format{TileRenderer::PNG};
+    int m_quality{-1};
+    int m_rendererCount{1};
+
+    // Recreated with the current size and count once all are idle and all
+    // tiles taken are reported, until then they take no more tiles.
+    std::vector<std::unique_ptr<Instance>> m_instances;
+    bool m_instancesChanged{};
+
+    std::deque<TileId> m_queue;
+    // Tiles taken from the queue and not reported yet.
+    qsizetype m_pending{};
+    // Bumped by cancel(), results of earlier tiles are dropped.
+    quint64 m_generation{};
+
+    QThreadPool m_encoderPool;
+};
+
+/*! \endcond */
+
+} // namespace QMapLibre
@@ -0,0 +1,66 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+namespace QMapLibre {
+
+/*! \cond PRIVATE */
+
+// Wait-free single-producer single-consumer handoff of the latest value.
+//
+// The producer writes into its back slot and publishes it by swapping it
+// with the middle slot. The consumer picks up a published value by swapping
+// its front slot with the middle slot. Neither side ever waits for the
+// other, intermediate values the consumer did not pick up are overwritten.
+// The front value stays valid until the consumer picks up a newer one.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+
+    TripleBuffer(const TripleBuffer &) = delete;
+    TripleBuffer &operator=(const TripleBuffer &) = delete;
+    TripleBuffer(TripleBuffer &&) = delete;
+    TripleBuffer &operator=(TripleBuffer &&) = delete;
+
+    // Producer side.
+    void write(T value) {
+        m_slots[m_back] = std::move(value);
+        const std::uint8_t previous = m_middle.exchange(m_back | DirtyBit, std::memory_order_acq_rel);
+        m_back = previous & IndexMask;
+    }
+
+    // Consumer side. Returns true if a newer value has been picked up.
+    bool update() {
+        if ((m_middle.load(std::memory_order_relaxed) & DirtyBit) == 0) {
+            return false;
+        }
+
+        const std::uint8_t previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & IndexMask;
+        return true;
+    }
+
+    // Consumer side.
+    [[nodiscard]] const T &front() const { return m_slots[m_front]; }
+
+private:
+    static constexpr std::uint8_t IndexMask = 0x3;
+    static constexpr std::uint8_t DirtyBit = 0x4;
+
+    std::array<T, 3> m_slots{};
+    std::uint8_t m_back{0};
+    std::atomic<std::uint8_t> m_middle{1};
+    std::uint8_t m_front{2};
+};
+
+/*! \endcond PRIVATE */
+
+} // namespace QMapLibre
@@ -153,6 +153,136 @@ namespace QMapLibre {
     \brief feature identifier
 */
 
+/*!
+    \struct PropertyColumn
+    \brief Typed values of one property for a batch of features.
+    \ingroup QMapLibre
+
+    \headerfile types.hpp <QMapLibre/Types>
+
+    Holds the value of the property \a name for each feature passed to
+    Map::setSourceGeometry(), in feature order. Only the vector matching
+    \a type is used.
+
+    \enum PropertyColumn::Type
+    \brief Property column value type.
+
+    \var PropertyColumn::BoolType
+    Values are stored in \a bools.
+
+    \var PropertyColumn::IntegerType
+    Values are stored in \a integers.
+
+    \var PropertyColumn::DoubleType
+    Values are stored in \a doubles.
+
+    \var PropertyColumn::StringType
+    Values are stored in \a strings.
+
+    \fn PropertyColumn::size
+    \brief Returns the number of values of the column's type.
+
+    \var PropertyColumn::name
+    \brief property name
+
+    \var PropertyColumn::type
+    \brief value type
+
+    \var PropertyColumn::bools
+    \brief boolean values
+
+    \var PropertyColumn::integers
+    \brief integer values
+
+    \var PropertyColumn::doubles
+    \brief floating point values
+
+    \var PropertyColumn::strings
+    \brief string values
+*/
+
+/*!
+    \struct FeatureBatch
+    \brief Columnar storage for many features of the same type.
+    \ingroup QMapLibre
+
+    \headerfile types.hpp <QMapLibre/Types>
+
+    A compact alternative to a list of Feature. Coordinates are kept in two
+    flat vectors and the geometry structure in offset vectors, so a batch
+    needs a handful of allocations no matter how many features, rings and
+    points it has. Properties are stored per column, with each key held once.
+
+    The offsets follow the layout described for Map::setSourceGeometry():
+    feature \c i spans from \c featureOffsets[i] up to
+    \c featureOffsets[i + 1], and what it indexes depends on \a type.
+
+    A batch can be passed as source \c data to Map::addSource() and
+    Map::updateSource() wrapped in a QVariant.
+
+    \code
+        FeatureBatch batch(Feature::PointType);
+        batch.longitudes = {11.5, 13.4};
+        batch.latitudes = {48.1, 52.5};
+        batch.featureOffsets = {0, 1, 2};
+        batch.properties = {PropertyColumn("name", QStringList{"Munich", "Berlin"})};
+
+        QVariantMap source;
+        source["type"] = "geojson";
+        source["data"] = QVariant::fromValue(batch);
+        map->addSource("cities", source);
+    \endcode
+
+    \fn FeatureBatch::size
+    \brief Returns the number of features.
+
+    \var FeatureBatch::type
+    \brief geometry type of all features
+
+    \var FeatureBatch::longitudes
+    \brief longitude of each point
+
+    \var FeatureBatch::latitudes
+    \brief latitude of each point
+
+    \var FeatureBatch::featureOffsets
+    \brief offsets of the first item of each feature
+
+    \var FeatureBatch::partOffsets
+    \brief offsets of the first ring of each polygon
+
+    \var FeatureBatch::ringOffsets
+    \brief offsets of the first point of each line or ring
+
+    \var FeatureBatch::properties
+    \brief property values of each feature
+
+    \var FeatureBatch::ids
+    \brief feature identifiers, either empty or one per feature
+*/
+
+/*!
+    \struct CoordinateQuantization
+    \brief Fixed-point encoding of coordinates.
+    \ingroup QMapLibre
+
+    \headerfile types.hpp <QMapLibre/Types>
+
+    Describes coordinates stored as 32-bit integers relative to an origin,
+    usually the corner of a tile. A value pair \c (x, y) stands for the
+    longitude \c {origin.second + x * resolution} and the latitude
+    \c {origin.first + y * resolution}.
+
+    A resolution of 1e-7 degrees, about a centimeter, covers the whole world
+    from an origin at (0, 0).
+
+    \var CoordinateQuantization::origin
+    \brief coordinate of the integer value 0
+
+    \var CoordinateQuantization::resolution
+    \brief degrees per integer unit, must be positive
+*/
+
 /*!
     \struct FeatureProperty
     \brief %Map feature property helper type.
@@ -356,6 +486,168 @@ namespace QMapLibre {
     The velocity and minZoom options are left unset and can be configured after construction.
 */
 
+/*!
+    \struct SchedulerStatistics
+    \brief Render thread task scheduler counters.
+    \ingroup QMapLibre
+
+    \headerfile types.hpp <QMapLibre/Types>
+
+    Counters of the scheduler that runs MapLibre tasks on a render thread
+    without its own event loop. Tasks are processed after each frame, within
+    the budget set by Settings::setRenderTaskBudget(). Use \a deferredTasks and
+    \a exhaustedBudgets to tune that budget.
+
+    \var SchedulerStatistics::pendingTasks
+    \brief tasks currently queued or running
+
+    \var SchedulerStatistics::processedTasks
+    \brief tasks run since the scheduler was created
+
+    \var SchedulerStatistics::deferredTasks
+    \brief tasks postponed to a later frame because the budget was spent
+
+    \var SchedulerStatistics::exhaustedBudgets
+    \brief frames in which the budget was spent before the queue was empty
+*/
+
+/*!
+    \struct ThreadPoolStatistics
+    \brief Background worker pool counters.
+    \ingroup QMapLibre
+
+    \headerfile types.hpp <QMapLibre/Types>
+
+    Load and throughput of the worker pool the style of a map uses for
+    GeoJSON sources, sprites and source data conversions. Only available for
+    pools configured through Settings::setBackgroundThreadCount() and
+    related settings.
+
+    \var ThreadPoolStatistics::threadCount
+    \brief number of worker threads
+
+    \var ThreadPoolStatistics::busyThreads
+    \brief workers currently running a task
+
+    \var ThreadPoolStatistics::queuedTasks
+    \brief tasks waiting for a free worker
+
+    \var ThreadPoolStatistics::completedTasks
+    \brief tasks run since the pool was created
+
+    \var ThreadPoolStatistics::utilisation
+    \brief share of worker time spent running tasks since the pool was created, from \c 0 to \c 1
+*/
+
+/*!
+    \struct FramePacerStatistics
+    \brief Frame pacing counters.
+    \ingroup QMapLibre
+
+    \headerfile types.hpp <QMapLibre/Types>
+
+    Map updates request a frame through Map::needsRendering(). Updates that
+    arrive while a frame is already pending, for example because the frame
+    rate is capped with Settings::setMaxFrameRate(), are merged into it and
+    counted as dropped frames.
+
+    \var FramePacerStatistics::requestedUpdates
+    \brief updates that needed a new frame
+
+    \var FramePacerStatistics::renderedFrames
+    \brief frames rendered with Map::render()
+
+    \var FramePacerStatistics::droppedFrames
+    \brief updates merged into an already pending frame
+
+    \var FramePacerStatistics::lateFrames
+    \brief frames rendered more than one frame interval and one display refresh after being requested
+
+    \var FramePacerStatistics::frameLatency
+    \brief average time from requesting a frame until it was rendered, in microseconds
+
+    \var FramePacerStatistics::renderTime
+    \brief average time Map::render() took, in microseconds, bounding the frame rate of the render thread
+
+    \var FramePacerStatistics::renderTargetWaits
+    \brief frames that waited for the compositor to release their render target, OpenGL only
+*/
+
+/*!
+    \struct TaskStall
+    \brief A task that kept its queue busy for long.
+    \ingroup QMapLibre
+
+    \headerfile types.hpp <QMapLibre/Types>
+
+    \var TaskStall::task
+    \brief name of the owner the task was scheduled for, shared by all its
+    tasks and empty for tasks without an owner
+
+    Tasks converting the GeoJSON source data of a map are named
+    \c "GeoJSON source data". Tasks of MapLibre Native's own workers, such as
+    tile workers, can't be told apart by type or tile and are named
+    \c "MapLibre worker" followed by a number that stays the same for as long
+    as that worker has tasks among the longest ones.
+
+    \var TaskStall::runTime
+    \brief run time in microseconds
+*/
+
+/*!
+    \struct TaskQueueStatistics
+    \brief Counters of a queue of tasks feeding a map.
+    \ingroup QMapLibre
+
+    \headerfile types.hpp <QMapLibre/Types>
+
+    Histograms have \a BucketCount buckets. Bucket \c 0 counts tasks that
+    took less than a microsecond, bucket \c i counts tasks that took from
+    2^(i-1) up to 2^i microseconds and the last bucket also counts all longer
+    tasks.
+
+    \var TaskQueueStatistics::BucketCount
+    \brief number of histogram buckets
+
+    \var TaskQueueStatistics::queueDepth
+    \brief tasks currently queued or running, always \c 0 for the run loop
+    which does not expose its queue
+
+    \var TaskQueueStatistics::completedTasks
+    \brief tasks measured since collection started
+
+    \var TaskQueueStatistics::latencyHistogram
+    \brief time from scheduling a task until it starts running
+
+    \var TaskQueueStatistics::runTimeHistogram
+    \brief time a task runs
+
+    \var TaskQueueStatistics::longestTasks
+    \brief the longest running tasks, longest first
+*/
+
+/*!
+    \struct MapStatistics
+    \brief Counters of the task queues feeding a map.
+    \ingroup QMapLibre
+
+    \headerfile types.hpp <QMapLibre/Types>
+
+    Collected when Settings::setStatisticsInterval() is set.
+
+    \var MapStatistics::renderThread
+    \brief tasks run after each frame on a render thread without an event loop
+
+    \var MapStatistics::runLoop
+    \brief the run loop of the thread the map lives on, only the latency is
+    sampled periodically as the loop does not expose its tasks, the queue
+    depth and run times stay zero and there are no longest tasks
+
+    \var MapStatistics::backgroundPool
+    \brief the background worker pool, only for pools configured through
+    Settings::setBackgroundThreadCount() and related settings
+*/
+
 /*!
     \struct CustomLayerRenderParameters
     \ingroup QMapLibre
@@ -10,6 +10,7 @@
 
 #include <QtCore/QPair>
 #include <QtCore/QString>
+#include <QtCore/QStringList>
 #include <QtCore/QVariant>
 #include <QtCore/QVector>
 #include <QtGui/QColor>
@@ -78,6 +79,79 @@ struct Q_MAPLIBRE_CORE_EXPORT Feature {
     QVariant id;
 };
 
+struct Q_MAPLIBRE_CORE_EXPORT PropertyColumn {
+    enum Type {
+        BoolType = 1,
+        IntegerType,
+        DoubleType,
+        StringType
+    };
+
+    /*! Class constructor. */
+    explicit PropertyColumn(QString name_ = QString(), QVector<double> values = QVector<double>())
+        : name(std::move(name_)),
+          type(DoubleType),
+          doubles(std::move(values)) {}
+    /*! Class constructor. */
+    explicit PropertyColumn(QString name_, QVector<qint64> values)
+        : name(std::move(name_)),
+          type(IntegerType),
+          integers(std::move(values)) {}
+    /*! Class constructor. */
+    explicit PropertyColumn(QString name_, QVector<bool> values)
+        : name(std::move(name_)),
+          type(BoolType),
+          bools(std::move(values)) {}
+    /*! Class constructor. */
+    explicit PropertyColumn(QString name_, QStringList values)
+        : name(std::move(name_)),
+          type(StringType),
+          strings(std::move(values)) {}
+
+    [[nodiscard]] qsizetype size() const {
+        switch (type) {
+            case BoolType:
+                return bools.size();
+            case IntegerType:
+                return integers.size();
+            case StringType:
+                return strings.size();
+            case DoubleType:
+                break;
+        }
+        return doubles.size();
+    }
+
+    QString name;
+    Type type;
+    QVector<bool> bools;
+    QVector<qint64> integers;
+    QVector<double> doubles;
+    QStringList strings;
+};
+
+struct Q_MAPLIBRE_CORE_EXPORT FeatureBatch {
+    /*! Class constructor. */
+    explicit FeatureBatch(Feature::Type type_ = Feature::PointType)
+        : type(type_) {}
+
+    [[nodiscard]] qsizetype size() const { return featureOffsets.isEmpty() ? 0 : featureOffsets.size() - 1; }
+
+    Feature::Type type;
+    QVector<double> longitudes;
+    QVector<double> latitudes;
+    QVector<qsizetype> featureOffsets;
+    QVector<qsizetype> partOffsets;
+    QVector<qsizetype> ringOffsets;
+    QVector<PropertyColumn> properties;
+    PropertyColumn ids;
+};
+
+struct Q_MAPLIBRE_CORE_EXPORT CoordinateQuantization {
+    Coordinate origin;
+    double resolution{};
+};
+
 struct Q_MAPLIBRE_CORE_EXPORT FeatureProperty {
     enum Type {
         LayoutProperty = 1,
@@ -174,6 +248,52 @@ struct Q_MAPLIBRE_CORE_EXPORT AnimationOptions {
         : duration(duration_) {}
 };
 
+struct Q_MAPLIBRE_CORE_EXPORT SchedulerStatistics {
+    quint64 pendingTasks{};
+    quint64 processedTasks{};
+    quint64 deferredTasks{};
+    quint64 exhaustedBudgets{};
+};
+
+struct Q_MAPLIBRE_CORE_EXPORT ThreadPoolStatistics {
+    int threadCount{};
+    int busyThreads{};
+    quint64 queuedTasks{};
+    quint64 completedTasks{};
+    double utilisation{};
+};
+
+struct Q_MAPLIBRE_CORE_EXPORT FramePacerStatistics {
+    quint64 requestedUpdates{};
+    quint64 renderedFrames{};
+    quint64 droppedFrames{};
+    quint64 lateFrames{};
+    qint64 frameLatency{};
+    qint64 renderTime{};
+    quint64 renderTargetWaits{};
+};
+
+struct Q_MAPLIBRE_CORE_EXPORT TaskStall {
+    QString task;
+    qint64 runTime{};
+};
+
+struct Q_MAPLIBRE_CORE_EXPORT TaskQueueStatistics {
+    static constexpr int BucketCount = 20;
+
+    quint64 queueDepth{};
+    quint64 completedTasks{};
+    QVector<quint64> latencyHistogram;
+    QVector<quint64> runTimeHistogram;
+    QVector<TaskStall> longestTasks;
+};
+
+struct Q_MAPLIBRE_CORE_EXPORT MapStatistics {
+    TaskQueueStatistics renderThread;
+    TaskQueueStatistics runLoop;
+    TaskQueueStatistics backgroundPool;
+};
+
 // This struct is a 1:1 copy of mbgl::CustomLayerRenderParameters.
 struct Q_MAPLIBRE_CORE_EXPORT CustomLayerRenderParameters {
     double width;
@@ -201,10 +321,12 @@ Q_DECLARE_METATYPE(QMapLibre::Coordinates);
 Q_DECLARE_METATYPE(QMapLibre::CoordinatesCollection);
 Q_DECLARE_METATYPE(QMapLibre::CoordinatesCollections);
 Q_DECLARE_METATYPE(QMapLibre::Feature);
+Q_DECLARE_METATYPE(QMapLibre::FeatureBatch);
 
 Q_DECLARE_METATYPE(QMapLibre::SymbolAnnotation);
 Q_DECLARE_METATYPE(QMapLibre::ShapeAnnotationGeometry);
 Q_DECLARE_METATYPE(QMapLibre::LineAnnotation);
 Q_DECLARE_METATYPE(QMapLibre::FillAnnotation);
+Q_DECLARE_METATYPE(QMapLibre::MapStatistics);
 
 #endif // QMAPLIBRE_TYPES_H
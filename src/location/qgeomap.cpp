@@ -31,10 +31,8 @@
 #include <QtLocation/private/qgeoprojection_p.h>
 
 #include <QtCore/QByteArray>
-#include <QtCore/QCoreApplication>
 #include <QtQuick/QQuickWindow>
 #include <QtQuick/QSGImageNode>
-#include <QtQuick/QSGRendererInterface>
 #ifdef MLN_RENDER_BACKEND_OPENGL
 #include <QtQuick/private/qsgcontext_p.h> // for debugging the context name
 #include <QtGui/QOpenGLContext>
@@ -143,11 +141,6 @@ QSGNode *QGeoMapMapLibrePrivate::updateSceneGraph(QSGNode *node, QQuickWindow *w
 
     static_cast<TextureNodeBase *>(node)->render(window);
 
-#ifdef MLN_RENDER_BACKEND_OPENGL
-    // Threaded rendering hack only needd for OpenGL
-    threadedRenderingHack(window, map);
-#endif
-
     m_syncState = NoSync;
 
     return node;
@@ -386,46 +379,12 @@ void QGeoMapMapLibrePrivate::syncStyleChanges(Map *map) {
     m_styleChanges.clear();
 }
 
-void QGeoMapMapLibrePrivate::threadedRenderingHack(QQuickWindow *window, Map *map) {
-    // Detect threaded rendering. Some backends require a hack where we need
-    // to set a timer to update the map until all the resources are loaded,
-    // which is not exactly battery friendly, because might trigger more paints
-    // than we need.
-#ifdef MLN_RENDER_BACKEND_OPENGL
-    if (!m_threadedRenderingChecked) {
-        m_threadedRendering = static_cast<QOpenGLContext *>(window->rendererInterface()->getResource(
-                                                                window, QSGRendererInterface::OpenGLContextResource))
-                                  ->thread() != QCoreApplication::instance()->thread();
-
-        m_threadedRenderingChecked = true;
-    }
-#else
-    Q_UNUSED(window);
-#endif
-
-    // Fallback timer to keep updating until map fully loaded when threaded rendering is active.
-    if (m_threadedRendering) {
-        if (!map->isFullyLoaded()) {
-            QMetaObject::invokeMethod(&m_refresh, "start", Qt::QueuedConnection);
-        } else {
-            QMetaObject::invokeMethod(&m_refresh, "stop", Qt::QueuedConnection);
-        }
-    }
-}
-
 /*
  * QGeoMapMapLibre implementation
  */
 
 QGeoMapMapLibre::QGeoMapMapLibre(QGeoMappingManagerEngine *engine, QObject *parent)
-    : QGeoMap(*new QGeoMapMapLibrePrivate(engine), parent) {
-    Q_D(QGeoMapMapLibre);
-
-    constexpr int refreshInterval{250};
-
-    connect(&d->m_refresh, &QTimer::timeout, this, &QGeoMap::sgNodeChanged);
-    d->m_refresh.setInterval(refreshInterval);
-}
+    : QGeoMap(*new QGeoMapMapLibrePrivate(engine), parent) {}
 
 QGeoMapMapLibre::~QGeoMapMapLibre() = default;
 
@@ -486,10 +445,6 @@ void QGeoMapMapLibre::onMapChanged(Map::MapChange change) {
                                                                                           d->m_mapItemsBefore);
             std::ranges::move(changes, std::back_inserter(d->m_styleChanges));
         }
-    } else if (change == Map::MapChangeDidFinishLoadingMap) {
-        constexpr int refreshInterval{250};
-        // TODO: make it more elegant
-        QTimer::singleShot(refreshInterval, this, &QGeoMapMapLibre::sgNodeChanged);
     }
 }
 
@@ -17,7 +17,6 @@
 #include <QtCore/QList>
 #include <QtCore/QRectF>
 #include <QtCore/QSharedPointer>
-#include <QtCore/QTimer>
 #include <QtCore/QVariant>
 
 namespace QMapLibre {
@@ -57,9 +56,6 @@ public:
 
     QList<StyleParameter *> m_mapParameters;
 
-    QTimer m_refresh;
-    bool m_threadedRenderingChecked = false;
-    bool m_threadedRendering = false;
     bool m_styleLoaded = false;
 
     SyncStates m_syncState = NoSync;
@@ -82,7 +78,6 @@ private:
     Q_DISABLE_COPY(QGeoMapMapLibrePrivate);
 
     void syncStyleChanges(Map *map);
-    void threadedRenderingHack(QQuickWindow *window, Map *map);
 
     QRectF m_visibleArea;
 };
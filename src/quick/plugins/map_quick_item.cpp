@@ -402,9 +402,6 @@ void MapQuickItem::onMapChanged(Map::MapChange change) {
                                                                                           d->m_mapItemsBefore);
             std::ranges::move(changes, std::back_inserter(d->m_styleChanges));
         }
-    } else if (change == Map::MapChangeDidFinishLoadingMap) {
-        // TODO: make it more elegant
-        QTimer::singleShot(intervalTime, this, &QQuickItem::update);
     }
 }
 
@@ -9,8 +9,13 @@
 #include <QtGui/QOpenGLFunctions>
 #include <QtQuick/QQuickOpenGLUtils>
 
+#include <cstddef>
+#include <utility>
+
 namespace {
 constexpr int DefaultSize = 64;
+// More than the renderer's color targets, fewer than a leak would pile up.
+constexpr std::size_t MaxTextureWrappers = 8;
 } // namespace
 
 namespace QMapLibre {
@@ -72,11 +77,10 @@ void TextureNodeOpenGL::render(QQuickWindow *window) {
     // Begin external commands before MapLibre render
     window->beginExternalCommands();
 
+    // Renders into a different texture than the one composited last, no
+    // need to flush before the scene graph samples it
     m_map->render();
 
-    // Ensure we flush the OpenGL commands
-    gl->glFlush();
-
     // End external commands after MapLibre render
     window->endExternalCommands();
 
@@ -86,18 +90,40 @@ void TextureNodeOpenGL::render(QQuickWindow *window) {
     // Try to get MapLibre's OpenGL framebuffer texture ID for zero-copy sharing
     const GLuint maplibreTextureId = m_map->getFramebufferTextureId();
     if (maplibreTextureId > 0) {
-        // Wrap it directly as QSGTexture (zero-copy!)
         const QSize physicalSize = m_size * m_pixelRatio;
-        QSGTexture *qtTexture = QNativeInterface::QSGOpenGLTexture::fromNative(
-            maplibreTextureId, window, physicalSize, QQuickWindow::TextureHasAlphaChannel);
 
-        if (qtTexture != nullptr) {
-            setTexture(qtTexture);
-            setRect(QRectF(QPointF(), m_size));
+        // MapLibre rotates through a few textures that only change when the
+        // renderer resizes them, keep a wrapper for each until then
+        if (m_lastTextureSize != physicalSize || m_qtTextureWrappers.size() > MaxTextureWrappers) {
+            for (auto &entry : m_qtTextureWrappers) {
+                m_staleTextureWrappers.push_back(std::move(entry.second));
+            }
+            m_qtTextureWrappers.clear();
+            m_lastTextureSize = physicalSize;
+        }
+
+        std::unique_ptr<QSGTexture> &wrapper = m_qtTextureWrappers[maplibreTextureId];
+        if (wrapper == nullptr) {
+            // Wrap it directly as QSGTexture (zero-copy!)
+            wrapper.reset(QNativeInterface::QSGOpenGLTexture::fromNative(
+                maplibreTextureId, window, physicalSize, QQuickWindow::TextureHasAlphaChannel));
+            if (wrapper == nullptr) {
+                m_qtTextureWrappers.erase(maplibreTextureId);
+                return;
+            }
+        }
+
+        if (texture() != wrapper.get()) {
+            setTexture(wrapper.get());
             setFiltering(QSGTexture::Linear);
-            setOwnsTexture(false); // Don't delete MapLibre's texture!
-            markDirty(QSGNode::DirtyMaterial);
+            setOwnsTexture(false); // The wrappers are ours, the textures MapLibre's
         }
+
+        // The node no longer refers to the wrappers of the old size
+        m_staleTextureWrappers.clear();
+
+        setRect(QRectF(QPointF(), m_size));
+        markDirty(QSGNode::DirtyMaterial);
     }
 }
 
@@ -7,7 +7,13 @@
 #include "export_quick_p.hpp"
 #include "texture_node_base_p.hpp"
 
+#include <QtCore/QSize>
 #include <QtGui/qopengl.h>
+#include <QtQuick/QSGTexture>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace QMapLibre {
 
@@ -22,6 +28,11 @@ public:
 private:
     bool m_rendererBound{};
     GLuint m_fbo{};
+    // Wrappers of MapLibre's textures by ID, reused while the size stays the same.
+    std::unordered_map<GLuint, std::unique_ptr<QSGTexture>> m_qtTextureWrappers;
+    // Replaced wrappers, deleted once the node uses a new one.
+    std::vector<std::unique_ptr<QSGTexture>> m_staleTextureWrappers;
+    QSize m_lastTextureSize;
 };
 
 } // namespace QMapLibre
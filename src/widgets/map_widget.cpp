@@ -10,7 +10,6 @@
 
 #include <QtGui/rhi/qrhi.h>
 #include <QtCore/QDebug>
-#include <QtCore/QTimer>
 #include <QtGui/QMouseEvent>
 #include <QtGui/QWheelEvent>
 #include <QtGui/QWindow>
@@ -116,13 +115,15 @@ Map *MapWidget::map() {
 
 /*!
     \brief Handle map change events.
+    \deprecated Does nothing, kept for binary compatibility.
+
+    The widget repaints whenever the renderer requests a frame through
+    Map::needsRendering(), including while the map is loading, so no map
+    change needs handling here. Connect to Map::mapChanged() and wait for
+    Map::MapChangeDidBecomeIdle to know when the map is fully rendered.
 */
 void MapWidget::handleMapChange(Map::MapChange change) {
-    if (change == Map::MapChangeDidFinishLoadingMap) {
-        constexpr int refreshInterval{250};
-        // TODO: make it more elegant
-        QTimer::singleShot(refreshInterval, this, qOverload<>(&MapWidget::update));
-    }
+    Q_UNUSED(change);
 }
 
 /*!
@@ -225,8 +226,6 @@ void MapWidget::initialize(QRhiCommandBuffer *cb) {
         d_ptr->m_map = std::make_unique<Map>(this, d_ptr->m_settings, QSize(width(), height()), devicePixelRatio());
         // Connect to needsRendering signal to trigger updates
         QObject::connect(d_ptr->m_map.get(), &Map::needsRendering, this, qOverload<>(&MapWidget::update));
-        // Connect to map changed signal to know when the map is loaded
-        QObject::connect(d_ptr->m_map.get(), &Map::mapChanged, this, &MapWidget::handleMapChange);
     }
 
     // Create the renderer based on the build configuration and runtime API
@@ -41,6 +41,8 @@ signals:
     void onMouseReleaseEvent(QMapLibre::Coordinate coordinate);
 
 public slots:
+    // Does nothing, kept for binary compatibility.
+    Q_DECL_DEPRECATED_X("MapWidget repaints through Map::needsRendering(), map changes need no handling")
     void handleMapChange(QMapLibre::Map::MapChange change);
 
 protected:
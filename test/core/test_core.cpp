@@ -0,0 +1,1668 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "conversion_p.hpp"
+#include "flatgeobuf_p.hpp"
+#include "frame_pacer_p.hpp"
+#include "geobuf_p.hpp"
+#include "geojson_loader_p.hpp"
+#include "geojson_p.hpp"
+#include "scheduler_p.hpp"
+#include "simplification_p.hpp"
+#include "thread_pool_p.hpp"
+#include "triple_buffer_p.hpp"
+
+#include <QMapLibre/Map>
+#include <QMapLibre/Settings>
+#include <QMapLibre/ThreadedMapRenderer>
+#include <QMapLibre/TileRenderer>
+
+#include <QBuffer>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QSet>
+#include <QSignalSpy>
+#include <QTemporaryFile>
+#include <QTest>
+#include <QtEndian>
+
+#ifdef MLN_QT_WITH_HEADLESS
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#endif
+
+#include <mbgl/style/conversion/filter.hpp>
+#include <mbgl/style/conversion/layer.hpp>
+#include <mbgl/style/filter.hpp>
+#include <mbgl/style/layer.hpp>
+#include <mbgl/util/identity.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int ProducerCount = 8;
+constexpr int TasksPerProducer = 20000;
+constexpr int BulkFeatureCount = 200000;
+constexpr int FilterValueCount = 5000;
+constexpr int PropertyFeatureCount = 200000;
+
+QVector<double> bulkCoordinates() {
+    QVector<double> coordinates;
+    coordinates.reserve(2 * BulkFeatureCount);
+    for (int i = 0; i < BulkFeatureCount; ++i) {
+        coordinates.append(-180.0 + 360.0 * i / BulkFeatureCount);
+        coordinates.append(-85.0 + 170.0 * (i % 1000) / 1000);
+    }
+    return coordinates;
+}
+
+void appendVarint(QByteArray &data, quint64 value) {
+    while (value >= 0x80) {
+        data += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    data += static_cast<char>(value);
+}
+
+// Protocol Buffers field with a varint or length delimited value.
+QByteArray protoField(int field, quint64 value) {
+    QByteArray data;
+    appendVarint(data, static_cast<quint64>(field) << 3);
+    appendVarint(data, value);
+    return data;
+}
+
+QByteArray protoField(int field, const QByteArray &value) {
+    QByteArray data;
+    appendVarint(data, static_cast<quint64>(field) << 3 | 2);
+    appendVarint(data, value.size());
+    return data + value;
+}
+
+QByteArray protoPacked(int field, const QVector<qint64> &values, bool zigzag) {
+    QByteArray packed;
+    for (const qint64 value : values) {
+        appendVarint(packed, zigzag ? static_cast<quint64>((value << 1) ^ (value >> 63)) : static_cast<quint64>(value));
+    }
+    return protoField(field, packed);
+}
+
+template <typename T>
+QByteArray littleEndian(T value) {
+    QByteArray data(sizeof(T), '\0');
+    qToLittleEndian(value, data.data());
+    return data;
+}
+
+// FlatBuffers object and the position of the table or vector in it that
+// offsets should point to. Objects are written front to back with each vtable
+// in front of its table, which readers accept as any other layout.
+struct FlatObject {
+    QByteArray data;
+    qsizetype entry{};
+};
+
+FlatObject flatTable(const std::vector<std::pair<int, QByteArray>> &scalars,
+                     const std::vector<std::pair<int, FlatObject>> &children) {
+    int fieldCount = 0;
+    for (const auto &[index, value] : scalars) {
+        fieldCount = std::max(fieldCount, index + 1);
+    }
+    for (const auto &[index, child] : children) {
+        fieldCount = std::max(fieldCount, index + 1);
+    }
+
+    QByteArray vtable(4 + 2 * fieldCount, '\0');
+    QByteArray table(4, '\0');
+    for (const auto &[index, value] : scalars) {
+        qToLittleEndian<quint16>(table.size(), vtable.data() + 4 + 2 * index);
+        table += value;
+    }
+
+    QVector<qsizetype> fields;
+    for (const auto &[index, child] : children) {
+        qToLittleEndian<quint16>(table.size(), vtable.data() + 4 + 2 * index);
+        fields.append(table.size());
+        table += QByteArray(4, '\0');
+    }
+
+    QByteArray tail;
+    for (std::size_t i = 0; i < children.size(); ++i) {
+        const FlatObject &child = children[i].second;
+        qToLittleEndian<quint32>(table.size() + tail.size() + child.entry - fields[i], table.data() + fields[i]);
+        tail += child.data;
+    }
+
+    qToLittleEndian<quint16>(vtable.size(), vtable.data());
+    qToLittleEndian<quint16>(table.size(), vtable.data() + 2);
+    qToLittleEndian<qint32>(vtable.size(), table.data());
+
+    return {vtable + table + tail, vtable.size()};
+}
+
+FlatObject flatVector(const QByteArray &elements, quint32 length) {
+    return {littleEndian(length) + elements, 0};
+}
+
+FlatObject flatTables(const std::vector<FlatObject> &tables) {
+    QByteArray head = littleEndian<quint32>(tables.size()) + QByteArray(4 * tables.size(), '\0');
+    QByteArray tail;
+    for (std::size_t i = 0; i < tables.size(); ++i) {
+        const qsizetype field = 4 + 4 * i;
+        qToLittleEndian<quint32>(head.size() + tail.size() + tables[i].entry - field, head.data() + field);
+        tail += tables[i].data;
+    }
+    return {head + tail, 0};
+}
+
+// Size prefixed FlatBuffer with the object as root.
+QByteArray flatBuffer(const FlatObject &root) {
+    const QByteArray buffer = littleEndian<quint32>(4 + root.entry) + root.data;
+    return littleEndian<quint32>(buffer.size()) + buffer;
+}
+
+} // namespace
+
+class TestCore : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testSchedulerCoalescesWakeUps();
+    void testSchedulerRoundRobin();
+    void testSchedulerWaitForTag();
+    void testSchedulerBudget();
+    void testSchedulerTaskStatistics();
+    void benchmarkSchedulerEnqueue();
+
+    void testThreadPoolWaitForTag();
+    void testThreadPoolSharing();
+
+    void testFramePacerCoalesces();
+    void testFramePacerCap();
+    void testFramePacerLatency();
+
+    void testTripleBufferLatestValue();
+    void testTripleBufferSlowConsumer();
+
+    void testFeatureCollectionFromBuffers();
+    void testFeatureCollectionCompactCoordinates();
+    void testFeatureBatch();
+    void testFeatureSet();
+    void testGeoJSONLoader();
+    void testSourceAsync();
+    void testGeobuf();
+    void testFlatGeobuf();
+    void benchmarkFeatureIngestion_data();
+    void benchmarkFeatureIngestion();
+    void benchmarkCompactFeatureIngestion_data();
+    void benchmarkCompactFeatureIngestion();
+
+    void testConversionNormalized();
+    void benchmarkConversion_data();
+    void benchmarkConversion();
+
+    void testPropertyConverter();
+    void benchmarkPropertyConversion_data();
+    void benchmarkPropertyConversion();
+
+    void testSimplification();
+    void testSimplificationParallel();
+
+    void testHeadlessRendering();
+    void testHeadlessFrameReadback();
+    void testColorTargetRing();
+    void testThreadedMapRenderer();
+    void testTileRenderer();
+};
+
+void TestCore::testSchedulerCoalescesWakeUps() {
+    QMapLibre::Scheduler scheduler;
+
+    std::atomic<int> wakeUps{0};
+    std::atomic<int> executed{0};
+    QObject::connect(
+        &scheduler, &QMapLibre::Scheduler::needsProcessing, &scheduler, [&] { ++wakeUps; }, Qt::DirectConnection);
+
+    std::vector<std::thread> producers;
+    for (int i = 0; i < ProducerCount; ++i) {
+        producers.emplace_back([&] {
+            for (int j = 0; j < 100; ++j) {
+                scheduler.schedule([&] { ++executed; });
+            }
+        });
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+
+    // Nobody processed the queue in between, so a single wake-up is enough.
+    QCOMPARE(wakeUps.load(), 1);
+
+    scheduler.processEvents();
+    QCOMPARE(executed.load(), ProducerCount * 100);
+    QCOMPARE(wakeUps.load(), 1);
+
+    scheduler.waitForEmpty();
+
+    // Tasks scheduled by tasks run in the next round and wake us up again.
+    scheduler.schedule([&] { scheduler.schedule([&] { ++executed; }); });
+    QCOMPARE(wakeUps.load(), 2);
+    scheduler.processEvents();
+    QCOMPARE(wakeUps.load(), 3);
+    scheduler.processEvents();
+    QCOMPARE(executed.load(), ProducerCount * 100 + 1);
+}
+
+void TestCore::testSchedulerRoundRobin() {
+    QMapLibre::Scheduler scheduler;
+
+    const mbgl::util::SimpleIdentity first;
+    const mbgl::util::SimpleIdentity second;
+
+    std::vector<int> order;
+    for (int i = 0; i < 3; ++i) {
+        scheduler.schedule(first, [&] { order.push_back(1); });
+    }
+    for (int i = 0; i < 3; ++i) {
+        scheduler.schedule(second, [&] { order.push_back(2); });
+    }
+
+    scheduler.processEvents();
+
+    QCOMPARE(order.size(), std::size_t{6});
+    for (std::size_t i = 1; i < order.size(); ++i) {
+        QVERIFY(order[i] != order[i - 1]);
+    }
+}
+
+void TestCore::testSchedulerWaitForTag() {
+    QMapLibre::Scheduler scheduler;
+
+    const mbgl::util::SimpleIdentity busy;
+    const mbgl::util::SimpleIdentity quiet;
+
+    // Keeps the scheduler from ever being empty.
+    std::atomic<bool> stop{false};
+    std::function<void()> reschedule = [&] {
+        if (!stop) {
+            scheduler.schedule(busy, std::function<void()>(reschedule));
+        }
+    };
+    scheduler.schedule(busy, std::function<void()>(reschedule));
+
+    std::atomic<int> executed{0};
+    for (int i = 0; i < 10; ++i) {
+        scheduler.schedule(quiet, [&] { ++executed; });
+    }
+
+    std::thread consumer([&] {
+        while (!stop) {
+            scheduler.processEvents();
+        }
+    });
+
+    scheduler.waitForEmpty(quiet);
+    QCOMPARE(executed.load(), 10);
+
+    stop = true;
+    consumer.join();
+    scheduler.processEvents();
+}
+
+void TestCore::testSchedulerBudget() {
+    QMapLibre::Scheduler scheduler;
+
+    std::atomic<int> wakeUps{0};
+    QObject::connect(
+        &scheduler, &QMapLibre::Scheduler::needsProcessing, &scheduler, [&] { ++wakeUps; }, Qt::DirectConnection);
+
+    std::vector<int> order;
+    scheduler.schedule([&] { order.push_back(1); });
+    scheduler.schedule([&] { order.push_back(2); });
+    scheduler.schedule([&] { order.push_back(3); });
+    QCOMPARE(wakeUps.load(), 1);
+
+    // A spent budget still runs one task.
+    scheduler.processEvents(std::chrono::nanoseconds::zero());
+    QCOMPARE(order, std::vector<int>({1}));
+    QCOMPARE(wakeUps.load(), 2);
+
+    QMapLibre::SchedulerStatistics statistics = scheduler.statistics();
+    QCOMPARE(statistics.pendingTasks, quint64{2});
+    QCOMPARE(statistics.processedTasks, quint64{1});
+    QCOMPARE(statistics.deferredTasks, quint64{2});
+    QCOMPARE(statistics.exhaustedBudgets, quint64{1});
+
+    scheduler.processEvents();
+    QCOMPARE(order, std::vector<int>({1, 2, 3}));
+    QCOMPARE(wakeUps.load(), 2);
+
+    statistics = scheduler.statistics();
+    QCOMPARE(statistics.pendingTasks, quint64{0});
+    QCOMPARE(statistics.processedTasks, quint64{3});
+    QCOMPARE(statistics.deferredTasks, quint64{2});
+    QCOMPARE(statistics.exhaustedBudgets, quint64{1});
+}
+
+void TestCore::testSchedulerTaskStatistics() {
+    QMapLibre::Scheduler scheduler;
+    const std::shared_ptr<QMapLibre::TaskStatistics> statistics = scheduler.taskStatistics();
+
+    // Nothing is measured while disabled.
+    scheduler.schedule([] {});
+    scheduler.processEvents();
+    QCOMPARE(statistics->snapshot(0).completedTasks, quint64{0});
+
+    statistics->enable();
+    for (int i = 0; i < 10; ++i) {
+        scheduler.schedule([] {});
+    }
+    const mbgl::util::SimpleIdentity owner;
+    scheduler.schedule(owner, [] { std::this_thread::sleep_for(std::chrono::milliseconds(5)); });
+    scheduler.processEvents();
+    statistics->disable();
+
+    const QMapLibre::TaskQueueStatistics snapshot = statistics->snapshot(0);
+    QCOMPARE(snapshot.completedTasks, quint64{11});
+    QCOMPARE(snapshot.latencyHistogram.size(), qsizetype{QMapLibre::TaskQueueStatistics::BucketCount});
+    QCOMPARE(std::accumulate(snapshot.runTimeHistogram.begin(), snapshot.runTimeHistogram.end(), quint64{0}),
+             quint64{11});
+    // 5 ms fall into the bucket from 4096 to 8192 microseconds or later.
+    QVERIFY(std::accumulate(snapshot.runTimeHistogram.begin() + 13, snapshot.runTimeHistogram.end(), quint64{0}) >= 1);
+
+    QVERIFY(!snapshot.longestTasks.isEmpty());
+    QVERIFY(snapshot.longestTasks.size() <= static_cast<qsizetype>(QMapLibre::TaskStatistics::StallCount));
+    QVERIFY(snapshot.longestTasks.first().runTime >= 5000);
+    // Stalls are told apart by the owner of the task, numbered without a name.
+    QCOMPARE(snapshot.longestTasks.first().task, QStringLiteral("MapLibre worker 1"));
+    QVERIFY(snapshot.longestTasks.last().task.isEmpty());
+
+    // Released names are kept while the owner's tasks are listed.
+    statistics->setOwnerName(owner, QStringLiteral("GeoJSON source data"));
+    QCOMPARE(statistics->snapshot(0).longestTasks.first().task, QStringLiteral("GeoJSON source data"));
+    statistics->releaseOwnerName(owner);
+    QCOMPARE(statistics->snapshot(0).longestTasks.first().task, QStringLiteral("GeoJSON source data"));
+}
+
+void TestCore::benchmarkSchedulerEnqueue() {
+    constexpr int totalTasks = ProducerCount * TasksPerProducer;
+
+    int wakeUpsPerRun = 0;
+    QBENCHMARK {
+        QMapLibre::Scheduler scheduler;
+
+        std::atomic<int> wakeUps{0};
+        std::atomic<int> executed{0};
+        QObject::connect(
+            &scheduler, &QMapLibre::Scheduler::needsProcessing, &scheduler, [&] { ++wakeUps; }, Qt::DirectConnection);
+
+        std::vector<std::thread> producers;
+        producers.reserve(ProducerCount);
+        for (int i = 0; i < ProducerCount; ++i) {
+            producers.emplace_back([&] {
+                for (int j = 0; j < TasksPerProducer; ++j) {
+                    scheduler.schedule([&] { executed.fetch_add(1, std::memory_order_relaxed); });
+                }
+            });
+        }
+
+        // Drain concurrently, like the render thread does.
+        while (executed.load(std::memory_order_relaxed) < totalTasks) {
+            scheduler.processEvents();
+        }
+
+        for (auto &producer : producers) {
+            producer.join();
+        }
+
+        QCOMPARE(executed.load(), totalTasks);
+        wakeUpsPerRun = wakeUps.load();
+    }
+
+    QVERIFY(wakeUpsPerRun <= totalTasks);
+}
+
+void TestCore::testThreadPoolWaitForTag() {
+    QMapLibre::ThreadPool pool({2, QThread::LowPriority, {}});
+
+    const mbgl::util::SimpleIdentity slow;
+    const mbgl::util::SimpleIdentity fast;
+
+    std::atomic<bool> release{false};
+    pool.schedule(slow, [&] {
+        while (!release) {
+            std::this_thread::yield();
+        }
+    });
+
+    std::atomic<int> executed{0};
+    for (int i = 0; i < 100; ++i) {
+        pool.schedule(fast, [&] { ++executed; });
+    }
+
+    // The slow tag holds one worker, the other one drains the fast tag.
+    pool.waitForEmpty(fast);
+    QCOMPARE(executed.load(), 100);
+
+    QMapLibre::ThreadPoolStatistics statistics = pool.statistics();
+    QCOMPARE(statistics.threadCount, 2);
+    QCOMPARE(statistics.busyThreads, 1);
+    QCOMPARE(statistics.queuedTasks, quint64{0});
+    QCOMPARE(statistics.completedTasks, quint64{100});
+
+    release = true;
+    pool.waitForEmpty();
+
+    statistics = pool.statistics();
+    QCOMPARE(statistics.busyThreads, 0);
+    QCOMPARE(statistics.completedTasks, quint64{101});
+    QVERIFY(statistics.utilisation > 0.0 && statistics.utilisation <= 1.0);
+}
+
+void TestCore::testThreadPoolSharing() {
+    QMapLibre::Settings settings;
+    QVERIFY(QMapLibre::ThreadPool::fromSettings(settings) == nullptr);
+
+    settings.setBackgroundThreadCount(2);
+    const auto first = QMapLibre::ThreadPool::fromSettings(settings);
+    const auto second = QMapLibre::ThreadPool::fromSettings(settings);
+    QVERIFY(first != nullptr);
+    QCOMPARE(first, second);
+    QCOMPARE(first->statistics().threadCount, 2);
+
+    settings.setIsolatedBackgroundPool(true);
+    const auto isolated = QMapLibre::ThreadPool::fromSettings(settings);
+    QVERIFY(isolated != nullptr);
+    QVERIFY(isolated != first);
+}
+
+void TestCore::testFramePacerCoalesces() {
+    QMapLibre::FramePacer pacer(0);
+    QSignalSpy spy(&pacer, &QMapLibre::FramePacer::frameRequested);
+
+    for (int i = 0; i < 100; ++i) {
+        pacer.requestFrame();
+    }
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.count(), 1);
+
+    pacer.beginFrame();
+    pacer.endFrame();
+
+    // Idle maps do not request frames.
+    QVERIFY(!spy.wait(100));
+    QCOMPARE(spy.count(), 1);
+
+    const QMapLibre::FramePacerStatistics statistics = pacer.statistics();
+    QCOMPARE(statistics.requestedUpdates, quint64{100});
+    QCOMPARE(statistics.droppedFrames, quint64{99});
+    QCOMPARE(statistics.renderedFrames, quint64{1});
+}
+
+void TestCore::testFramePacerLatency() {
+    QMapLibre::FramePacer pacer(0);
+    QSignalSpy spy(&pacer, &QMapLibre::FramePacer::frameRequested);
+
+    pacer.requestFrame();
+    QVERIFY(spy.wait());
+
+    pacer.beginFrame();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    pacer.endFrame(1);
+
+    // Not requested, counts for the render time only.
+    pacer.beginFrame();
+    pacer.endFrame();
+
+    const QMapLibre::FramePacerStatistics statistics = pacer.statistics();
+    QCOMPARE(statistics.renderedFrames, quint64{2});
+    QCOMPARE(statistics.renderTargetWaits, quint64{1});
+    QVERIFY(statistics.frameLatency >= 10000);
+    QVERIFY(statistics.renderTime >= 5000);
+    QVERIFY(statistics.renderTime < statistics.frameLatency);
+}
+
+void TestCore::testFramePacerCap() {
+    constexpr int frameRate = 20;
+    constexpr int durationMs = 500;
+
+    QMapLibre::FramePacer pacer(frameRate);
+
+    int frames = 0;
+    QObject::connect(&pacer, &QMapLibre::FramePacer::frameRequested, &pacer, [&] {
+        ++frames;
+        pacer.beginFrame();
+        pacer.endFrame();
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < durationMs) {
+        pacer.requestFrame();
+        QTest::qWait(1);
+    }
+
+    // One frame may be emitted right away, the others are one interval apart.
+    QVERIFY(frames > 0);
+    QVERIFY(frames <= frameRate * durationMs / 1000 + 1);
+}
+
+void TestCore::testTripleBufferLatestValue() {
+    QMapLibre::TripleBuffer<int> buffer;
+
+    QVERIFY(!buffer.update());
+    QCOMPARE(buffer.front(), 0);
+
+    buffer.write(1);
+    buffer.write(2);
+    buffer.write(3);
+
+    // Only the latest value is picked up and it stays until a newer one.
+    QVERIFY(buffer.update());
+    QCOMPARE(buffer.front(), 3);
+    QVERIFY(!buffer.update());
+    QCOMPARE(buffer.front(), 3);
+
+    buffer.write(4);
+    QVERIFY(buffer.update());
+    QCOMPARE(buffer.front(), 4);
+}
+
+void TestCore::testTripleBufferSlowConsumer() {
+    using Clock = std::chrono::steady_clock;
+
+    // Long frames, so that only a publish waiting for the renderer, never
+    // scheduling noise on a loaded machine, takes a whole frame.
+    constexpr auto frameTime = std::chrono::milliseconds(250);
+    constexpr int frames = 4;
+
+    QMapLibre::TripleBuffer<std::shared_ptr<int>> buffer;
+    std::atomic<bool> done{false};
+    bool ordered = true;
+
+    // A slow renderer holding on to its frame.
+    std::thread renderer([&] {
+        int previous = 0;
+        for (int i = 0; i < frames; ++i) {
+            buffer.update();
+            if (const std::shared_ptr<int> &value = buffer.front()) {
+                // Values are never picked up out of order.
+                ordered = ordered && *value >= previous;
+                previous = *value;
+            }
+            std::this_thread::sleep_for(frameTime);
+        }
+        done = true;
+    });
+
+    // Map thread side: publish as fast as possible and keep the longest
+    // time a publish took.
+    Clock::duration stall{};
+    for (int i = 1; !done; ++i) {
+        const auto start = Clock::now();
+        buffer.write(std::make_shared<int>(i));
+        stall = std::max(stall, Clock::now() - start);
+    }
+    renderer.join();
+
+    QVERIFY(ordered);
+    QVERIFY(stall < frameTime);
+}
+
+void TestCore::testFeatureCollectionFromBuffers() {
+    using QMapLibre::Feature;
+    using QMapLibre::PropertyColumn;
+
+    std::string error;
+
+    // Two polygons, the second one with a hole, as one multi polygon and a
+    // plain polygon.
+    const QVector<double> coordinates{0, 0, 1, 0, 1, 1, 0, 0, 2, 2, 6, 2, 6, 6, 2, 2, 3, 3, 4, 3, 4, 4, 3, 3};
+    const auto collection = QMapLibre::GeoJSON::asFeatureCollection(
+        Feature::PolygonType,
+        coordinates,
+        {0, 2, 3},
+        {0, 1, 3, 3},
+        {0, 4, 8, 12},
+        {PropertyColumn("name", QStringList{"multi", "empty"}), PropertyColumn("rank", QVector<qint64>{1, 2})},
+        error);
+    QVERIFY2(collection.has_value(), error.c_str());
+    QCOMPARE(collection->size(), std::size_t{2});
+
+    const auto &multiPolygon = collection->at(0).geometry.get<mbgl::MultiPolygon<double>>();
+    QCOMPARE(multiPolygon.size(), std::size_t{2});
+    QCOMPARE(multiPolygon[1].size(), std::size_t{2});
+    QCOMPARE(multiPolygon[1][1][2].x, 4.0);
+    QCOMPARE(collection->at(0).properties.at("name").get<std::string>(), std::string("multi"));
+    QCOMPARE(collection->at(1).properties.at("rank").get<int64_t>(), int64_t{2});
+
+    // Offsets must stay within the next level.
+    QVERIFY(!QMapLibre::GeoJSON::asFeatureCollection(
+                 Feature::PointType, coordinates, {0, 13}, {}, {}, {}, error)
+                 .has_value());
+    // Each column needs a value per feature.
+    QVERIFY(!QMapLibre::GeoJSON::asFeatureCollection(
+                 Feature::PointType, coordinates, {0, 1, 2}, {}, {}, {PropertyColumn("speed", QVector<double>{1})}, error)
+                 .has_value());
+}
+
+void TestCore::testFeatureCollectionCompactCoordinates() {
+    using QMapLibre::Feature;
+
+    std::string error;
+
+    const QVector<float> floats{11.5F, 48.25F, 13.375F, 52.5F};
+    const auto fromFloats = QMapLibre::GeoJSON::asFeatureCollection(
+        Feature::LineStringType, floats, {0, 1}, {}, {0, 2}, {}, error);
+    QVERIFY2(fromFloats.has_value(), error.c_str());
+    const auto &line = fromFloats->at(0).geometry.get<mbgl::LineString<double>>();
+    QCOMPARE(line[1].x, 13.375);
+    QCOMPARE(line[1].y, 52.5);
+
+    // Longitude first, relative to the origin given as latitude, longitude.
+    const QMapLibre::CoordinateQuantization quantization{{48.0, 11.0}, 1e-3};
+    const QVector<qint32> quantized{500, 250, -1000, -2000};
+    const auto fromQuantized = QMapLibre::GeoJSON::asFeatureCollection(
+        Feature::PointType, quantized, quantization, {0, 1, 2}, {}, {}, {}, error);
+    QVERIFY2(fromQuantized.has_value(), error.c_str());
+    QCOMPARE(fromQuantized->size(), std::size_t{2});
+    const auto &first = fromQuantized->at(0).geometry.get<mbgl::Point<double>>();
+    const auto &second = fromQuantized->at(1).geometry.get<mbgl::Point<double>>();
+    QVERIFY(qFuzzyCompare(first.x, 11.5));
+    QVERIFY(qFuzzyCompare(first.y, 48.25));
+    QVERIFY(qFuzzyCompare(second.x, 10.0));
+    QVERIFY(qFuzzyCompare(second.y, 46.0));
+
+    // Coordinates come in pairs and the resolution must be usable.
+    QVERIFY(!QMapLibre::GeoJSON::asFeatureCollection(
+                 Feature::PointType, QVector<float>{1.0F, 2.0F, 3.0F}, {0, 1}, {}, {}, {}, error)
+                 .has_value());
+    QVERIFY(!QMapLibre::GeoJSON::asFeatureCollection(
+                 Feature::PointType, quantized, QMapLibre::CoordinateQuantization{}, {0, 1, 2}, {}, {}, {}, error)
+                 .has_value());
+}
+
+void TestCore::testFeatureBatch() {
+    using QMapLibre::Coordinate;
+    using QMapLibre::Feature;
+    using QMapLibre::PropertyColumn;
+
+    // A multi line string and a line string, the same as batch and features.
+    QMapLibre::FeatureBatch batch(Feature::LineStringType);
+    batch.longitudes = {0, 1, 2, 3, 4, 5, 6};
+    batch.latitudes = {10, 11, 12, 13, 14, 15, 16};
+    batch.featureOffsets = {0, 2, 3};
+    batch.ringOffsets = {0, 2, 4, 7};
+    batch.properties = {PropertyColumn("name", QStringList{"multi", "single"})};
+    batch.ids = PropertyColumn(QString(), QVector<qint64>{7, 8});
+    QCOMPARE(batch.size(), 2);
+
+    const QList<Feature> features{
+        Feature(Feature::LineStringType,
+                {{{Coordinate(10, 0), Coordinate(11, 1)}, {Coordinate(12, 2), Coordinate(13, 3)}}},
+                {{"name", "multi"}},
+                7),
+        Feature(Feature::LineStringType,
+                {{{Coordinate(14, 4), Coordinate(15, 5), Coordinate(16, 6)}}},
+                {{"name", "single"}},
+                8)};
+
+    mbgl::style::conversion::Error error;
+    const auto fromBatch = mbgl::style::conversion::convert<mbgl::GeoJSON>(QVariant::fromValue(batch), error);
+    QVERIFY2(fromBatch, error.message.c_str());
+    const auto fromFeatures = mbgl::style::conversion::convert<mbgl::GeoJSON>(QVariant::fromValue(features), error);
+    QVERIFY2(fromFeatures, error.message.c_str());
+    QVERIFY(fromBatch->get<mbgl::FeatureCollection>() == fromFeatures->get<mbgl::FeatureCollection>());
+
+    // Coordinate vectors must match and identifiers cannot be booleans.
+    batch.latitudes.removeLast();
+    QVERIFY(!mbgl::style::conversion::convert<mbgl::GeoJSON>(QVariant::fromValue(batch), error));
+    batch.latitudes.append(16);
+    batch.ids = PropertyColumn(QString(), QVector<bool>{true, false});
+    QVERIFY(!mbgl::style::conversion::convert<mbgl::GeoJSON>(QVariant::fromValue(batch), error));
+}
+
+void TestCore::testFeatureSet() {
+    using QMapLibre::Feature;
+
+    const auto vehicle = [](const QVariant &id, double longitude) {
+        return Feature(Feature::PointType, {{{QMapLibre::Coordinate(0.0, longitude)}}}, {}, id);
+    };
+
+    QMapLibre::GeoJSON::FeatureSet features;
+    QVERIFY(features.add(vehicle(1, 1.0)));
+    QVERIFY(features.add(vehicle(QStringLiteral("two"), 2.0)));
+    QVERIFY(features.add(vehicle(3, 3.0)));
+    QVERIFY(!features.add(vehicle(QVariant(), 4.0)));
+    QCOMPARE(features.size(), std::size_t{3});
+
+    // Adding an existing identifier replaces the feature.
+    QVERIFY(features.add(vehicle(1, 5.0)));
+    QCOMPARE(features.size(), std::size_t{3});
+
+    QVERIFY(features.update(vehicle(QStringLiteral("two"), 6.0)));
+    QVERIFY(!features.update(vehicle(4, 7.0)));
+
+    QVERIFY(features.remove(1));
+    QVERIFY(!features.remove(1));
+    QCOMPARE(features.size(), std::size_t{2});
+
+    // The last feature moved into the gap must still be found.
+    QVERIFY(features.update(vehicle(3, 8.0)));
+
+    double sum = 0;
+    for (const mbgl::GeoJSONFeature &feature : features.features()) {
+        sum += feature.geometry.get<mbgl::Point<double>>().x;
+    }
+    QCOMPARE(sum, 14.0);
+
+    // Map only changes features of sources added by updateSourceFeatures.
+    QMapLibre::Map map(nullptr, QMapLibre::Settings(), QSize(64, 64));
+    map.setStyleJson(QStringLiteral(R"({"version": 8, "sources": {}, "layers": []})"));
+    map.updateSourceFeatures(QStringLiteral("vehicles"), {vehicle(1, 1.0)}, {}, {});
+    QVERIFY(map.sourceExists(QStringLiteral("vehicles")));
+    map.updateSourceFeatures(QStringLiteral("vehicles"), {}, {vehicle(1, 2.0)}, {});
+
+    QVariantMap points;
+    points[QStringLiteral("type")] = QStringLiteral("geojson");
+    points[QStringLiteral("data")] = QByteArrayLiteral(R"({"type":"FeatureCollection","features":[]})");
+    map.addSource(QStringLiteral("points"), points);
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QStringLiteral("\"points\".*not set by")));
+    map.updateSourceFeatures(QStringLiteral("points"), {vehicle(2, 1.0)}, {}, {});
+
+    // Removing the source hands it over.
+    map.removeSource(QStringLiteral("points"));
+    map.updateSourceFeatures(QStringLiteral("points"), {vehicle(2, 1.0)}, {}, {});
+    QVERIFY(map.sourceExists(QStringLiteral("points")));
+}
+
+void TestCore::testGeoJSONLoader() {
+    QByteArray geojson(R"({"type":"FeatureCollection","features":[)");
+    for (int i = 0; i < BulkFeatureCount / 10; ++i) {
+        geojson += (i == 0 ? "" : ",");
+        geojson += R"({"type":"Feature","properties":{},"geometry":{"type":"Point","coordinates":[)" +
+                   QByteArray::number(i % 180) + ",0]}}";
+    }
+    geojson += "]}";
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(geojson);
+    file.close();
+
+    QStringList applied;
+    std::atomic<std::size_t> featureCount{0};
+    QMapLibre::GeoJSONLoader loader(
+        [&applied](const QString &id, std::shared_ptr<mbgl::style::GeoJSONData> data) {
+            applied.append(id);
+            return data != nullptr;
+        },
+        // Runs on the workers, also for superseded loads.
+        [&featureCount](const QString & /* id */) {
+            return [&featureCount](mbgl::GeoJSON geojson) {
+                featureCount = geojson.get<mbgl::FeatureCollection>().size();
+                return mbgl::style::GeoJSONData::create(geojson);
+            };
+        });
+    QSignalSpy loaded(&loader, &QMapLibre::GeoJSONLoader::loaded);
+    QSignalSpy failed(&loader, &QMapLibre::GeoJSONLoader::failed);
+    QSignalSpy progress(&loader, &QMapLibre::GeoJSONLoader::progress);
+
+    // The first load is superseded by the second one.
+    loader.load(QStringLiteral("points"), file.fileName());
+    loader.load(QStringLiteral("points"), file.fileName());
+    QVERIFY(loader.isLoading(QStringLiteral("points")));
+    QVERIFY(loaded.wait());
+    QCOMPARE(applied, QStringList{QStringLiteral("points")});
+    QCOMPARE(featureCount.load(), std::size_t{BulkFeatureCount / 10});
+    QVERIFY(!progress.isEmpty());
+    QCOMPARE(progress.last().at(1).toLongLong(), geojson.size());
+    QVERIFY(!loader.isLoading(QStringLiteral("points")));
+
+    // Streamed from a device.
+    QBuffer broken;
+    broken.setData(geojson.left(geojson.size() / 2));
+    QVERIFY(broken.open(QIODevice::ReadOnly));
+    loader.load(QStringLiteral("broken"), &broken);
+    QVERIFY(failed.wait());
+    QCOMPARE(failed.first().at(0).toString(), QStringLiteral("broken"));
+
+    // Devices that can't be read fail like any other load.
+    QBuffer closed;
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QStringLiteral("device is not readable")));
+    loader.load(QStringLiteral("closed"), &closed);
+    QVERIFY(failed.wait());
+    QCOMPARE(failed.last().at(0).toString(), QStringLiteral("closed"));
+
+    // Cancelled loads do not report back, not even their progress.
+    loader.load(QStringLiteral("cancelled"), file.fileName());
+    loader.cancel(QStringLiteral("cancelled"));
+    QVERIFY(!loaded.wait(500));
+    QCOMPARE(loaded.size(), 1);
+    QCOMPARE(applied.size(), 1);
+    for (const auto &arguments : std::as_const(progress)) {
+        QVERIFY(arguments.at(0).toString() != QStringLiteral("cancelled"));
+    }
+}
+
+void TestCore::testSourceAsync() {
+    const QByteArray points =
+        R"({"type":"FeatureCollection","features":[)"
+        R"({"type":"Feature","properties":{},"geometry":{"type":"Point","coordinates":[1,2]}}]})";
+    QVariantMap params;
+    params[QStringLiteral("type")] = QStringLiteral("geojson");
+    params[QStringLiteral("data")] = points;
+
+    auto map = std::make_unique<QMapLibre::Map>(nullptr, QMapLibre::Settings(), QSize(64, 64));
+    map->setStyleJson(QStringLiteral(R"({"version": 8, "sources": {}, "layers": []})"));
+
+    QFuture<bool> added = map->addSourceAsync(QStringLiteral("points"), params);
+    QTRY_VERIFY(added.isFinished());
+    QVERIFY(added.result());
+    QVERIFY(map->sourceExists(QStringLiteral("points")));
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QStringLiteral("already exists")));
+    QFuture<bool> again = map->addSourceAsync(QStringLiteral("points"), params);
+    QTRY_VERIFY(again.isFinished());
+    QVERIFY(!again.result());
+
+    params[QStringLiteral("data")] = QByteArrayLiteral("{");
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QStringLiteral("Unable to convert data")));
+    QFuture<bool> invalid = map->updateSourceAsync(QStringLiteral("points"), params);
+    QTRY_VERIFY(invalid.isFinished());
+    QVERIFY(!invalid.result());
+
+    // URLs are loaded by the source, not converted.
+    params[QStringLiteral("data")] = QStringLiteral("https://example.com/points.geojson");
+    QFuture<bool> url = map->updateSourceAsync(QStringLiteral("points"), params);
+    QVERIFY(url.isFinished());
+    QVERIFY(url.result());
+
+    // Only the latest update is applied.
+    params[QStringLiteral("data")] = points;
+    QFuture<bool> first = map->updateSourceAsync(QStringLiteral("points"), params);
+    QFuture<bool> second = map->updateSourceAsync(QStringLiteral("points"), params);
+    QTRY_VERIFY(first.isFinished() && second.isFinished());
+    QVERIFY(first.isCanceled());
+    QVERIFY(second.result());
+
+    // Conversions finishing after the map is gone are dropped.
+    QFuture<bool> orphan = map->updateSourceAsync(QStringLiteral("points"), params);
+    map.reset();
+    QTRY_VERIFY(orphan.isFinished());
+    QVERIFY(orphan.isCanceled());
+
+    // Simplification helpers run on the pool of the map, which goes away
+    // together with an isolated one while they are still busy.
+    QByteArray lines = R"({"type":"FeatureCollection","features":[)";
+    for (int feature = 0; feature < 2000; ++feature) {
+        lines += feature > 0 ? "," : "";
+        lines += R"({"type":"Feature","properties":{},"geometry":{"type":"LineString","coordinates":[)";
+        for (int point = 0; point < 50; ++point) {
+            lines += QByteArray(point > 0 ? "," : "") + "[" + QByteArray::number(point * 0.001) + "," +
+                     QByteArray::number((point % 2) * 0.00001) + "]";
+        }
+        lines += "]}}";
+    }
+    lines += "]}";
+    params[QStringLiteral("data")] = lines;
+
+    QMapLibre::Settings isolated;
+    isolated.setIsolatedBackgroundPool(true);
+    map = std::make_unique<QMapLibre::Map>(nullptr, isolated, QSize(64, 64));
+    map->setStyleJson(QStringLiteral(R"({"version": 8, "sources": {}, "layers": []})"));
+    map->setSourceSimplification(QStringLiteral("lines"), 0.01);
+
+    QFuture<bool> simplified = map->addSourceAsync(QStringLiteral("lines"), params);
+    QTRY_VERIFY(simplified.isFinished());
+    QVERIFY(simplified.result());
+
+    QFuture<bool> simplifying = map->updateSourceAsync(QStringLiteral("lines"), params);
+    map.reset();
+    QVERIFY(simplifying.isFinished());
+    QVERIFY(simplifying.isCanceled());
+}
+
+void TestCore::testGeobuf() {
+    // Geobuf has no magic bytes, it is told apart from GeoJSON text.
+    QVERIFY(!QMapLibre::Geobuf::isGeobuf(" \n{", 3));
+    QVERIFY(!QMapLibre::Geobuf::isGeobuf("\xEF\xBB\xBF{", 4));
+    QVERIFY(!QMapLibre::Geobuf::isGeobuf("[{}]", 4));
+    QVERIFY(!QMapLibre::Geobuf::isGeobuf("null", 4));
+    QVERIFY(!QMapLibre::Geobuf::isGeobuf("\n\n", 2));
+
+    // Precision 2, a point with an integer id and a property, and a polygon.
+    const QByteArray point = protoField(1, 0) + protoPacked(3, {150, -250}, true);
+    const QByteArray polygon = protoField(1, 4) + protoPacked(3, {0, 0, 100, 0, 0, 100}, true);
+    const QByteArray value = protoField(1, QByteArray("a"));
+    QByteArray features = protoField(
+        1, protoField(1, point) + protoField(12, 14) + protoField(13, value) + protoPacked(14, {0, 0}, false));
+    features += protoField(1, protoField(1, polygon) + protoField(11, QByteArray("square")));
+    const QByteArray data = protoField(1, QByteArray("name")) + protoField(3, 2) + protoField(4, features);
+    QVERIFY(QMapLibre::Geobuf::isGeobuf(data.constData(), data.size()));
+
+    mbgl::style::conversion::Error error;
+    const auto geojson = mbgl::style::conversion::convert<mbgl::GeoJSON>(QVariant(data), error);
+    QVERIFY2(geojson, error.message.c_str());
+
+    const auto &collection = geojson->get<mbgl::FeatureCollection>();
+    QCOMPARE(collection.size(), std::size_t{2});
+    QCOMPARE(collection[0].geometry.get<mbgl::Point<double>>(), (mbgl::Point<double>{1.5, -2.5}));
+    QCOMPARE(collection[0].id, mbgl::FeatureIdentifier{std::int64_t{7}});
+    QCOMPARE(collection[0].properties.at("name"), mbgl::Value{std::string("a")});
+
+    // Rings are closed again.
+    const auto &ring = collection[1].geometry.get<mbgl::Polygon<double>>().at(0);
+    QCOMPARE(ring.size(), std::size_t{4});
+    QCOMPARE(ring.back(), (mbgl::Point<double>{0, 0}));
+    QCOMPARE(ring[2], (mbgl::Point<double>{1, 1}));
+    QCOMPARE(collection[1].id, mbgl::FeatureIdentifier{std::string("square")});
+
+    std::string message;
+    QVERIFY(!QMapLibre::Geobuf::decode(data.constData(), data.size() - 1, message));
+    QVERIFY(!message.empty());
+
+    // Positions need at least x and y.
+    for (const quint64 dimensions : {0, 1}) {
+        const QByteArray line = protoField(1, 2) + protoPacked(3, {1, 2, 3, 4}, true);
+        const QByteArray invalid = protoField(2, dimensions) + protoField(6, line);
+        message.clear();
+        QVERIFY(!QMapLibre::Geobuf::decode(invalid.constData(), invalid.size(), message));
+        QVERIFY(!message.empty());
+    }
+
+    // Deeply nested geometry collections are rejected instead of recursing.
+    QByteArray nested = point;
+    for (int depth = 0; depth < 1000; ++depth) {
+        nested = protoField(1, 6) + protoField(4, nested);
+    }
+    const QByteArray deep = protoField(6, nested);
+    message.clear();
+    QVERIFY(!QMapLibre::Geobuf::decode(deep.constData(), deep.size(), message));
+    QVERIFY(!message.empty());
+
+    QByteArray shallow = point;
+    for (int depth = 0; depth < 8; ++depth) {
+        shallow = protoField(1, 6) + protoField(4, shallow);
+    }
+    const QByteArray nestedData = protoField(6, shallow);
+    QVERIFY(QMapLibre::Geobuf::decode(nestedData.constData(), nestedData.size(), message));
+}
+
+void TestCore::testFlatGeobuf() {
+    constexpr quint8 PointGeometry = 1;
+    constexpr quint8 IntColumn = 5;
+    const QVector<double> coordinates{1, 5, 10};
+
+    QByteArray features;
+    QByteArray leaves;
+    for (int i = 0; i < coordinates.size(); ++i) {
+        const double c = coordinates[i];
+        const FlatObject geometry = flatTable({}, {{1, flatVector(littleEndian(c) + littleEndian(c), 2)}});
+        const QByteArray properties = littleEndian<quint16>(0) + littleEndian<qint32>(i);
+        leaves += littleEndian(c) + littleEndian(c) + littleEndian(c) + littleEndian(c) +
+                  littleEndian<quint64>(features.size());
+        features += flatBuffer(flatTable({}, {{0, geometry}, {1, flatVector(properties, properties.size())}}));
+    }
+
+    const FlatObject column = flatTable({{1, littleEndian(IntColumn)}}, {{0, flatVector("rank", 4)}});
+    const QByteArray root = littleEndian(1.0) + littleEndian(1.0) + littleEndian(10.0) + littleEndian(10.0) +
+                            littleEndian<quint64>(1);
+
+    for (const bool indexed : {false, true}) {
+        const FlatObject header = flatTable({{2, littleEndian(PointGeometry)},
+                                             {8, littleEndian<quint64>(coordinates.size())},
+                                             {9, littleEndian<quint16>(indexed ? 16 : 0)}},
+                                            {{7, flatTables({column})}});
+        QByteArray data = QByteArray("fgb\x03" "fgb\x00", 8) + flatBuffer(header);
+        if (indexed) {
+            data += root + leaves;
+        }
+        data += features;
+        QVERIFY(QMapLibre::FlatGeobuf::isFlatGeobuf(data.constData(), data.size()));
+
+        std::string error;
+        const auto all = QMapLibre::FlatGeobuf::decode(data.constData(), data.size(), std::nullopt, error);
+        QVERIFY2(all, error.c_str());
+        QCOMPARE(all->get<mbgl::FeatureCollection>().size(), std::size_t{3});
+
+        // Read through the index if there is one, filtered by envelope if not.
+        const mapbox::geometry::box<double> bounds{{4, 4}, {11, 11}};
+        const auto within = QMapLibre::FlatGeobuf::decode(data.constData(), data.size(), bounds, error);
+        QVERIFY2(within, error.c_str());
+        const auto &collection = within->get<mbgl::FeatureCollection>();
+        QCOMPARE(collection.size(), std::size_t{2});
+        QCOMPARE(collection[0].geometry.get<mbgl::Point<double>>(), (mbgl::Point<double>{5, 5}));
+        QCOMPARE(collection[0].properties.at("rank"), mbgl::Value{std::int64_t{1}});
+        QCOMPARE(collection[1].properties.at("rank"), mbgl::Value{std::int64_t{2}});
+
+        QVERIFY(!QMapLibre::FlatGeobuf::decode(data.constData(), data.size() - 1, std::nullopt, error));
+    }
+
+    // Deeply nested geometry collections are rejected instead of recursing.
+    constexpr quint8 GeometryCollection = 7;
+    const auto nestedData = [&](int depth) {
+        FlatObject nested = flatTable({{6, littleEndian(PointGeometry)}},
+                                      {{1, flatVector(littleEndian(1.0) + littleEndian(1.0), 2)}});
+        for (int i = 0; i < depth; ++i) {
+            nested = flatTable({{6, littleEndian(GeometryCollection)}}, {{7, flatTables({nested})}});
+        }
+
+        const FlatObject header = flatTable({{8, littleEndian<quint64>(1)}, {9, littleEndian<quint16>(0)}}, {});
+        return QByteArray("fgb\x03" "fgb\x00", 8) + flatBuffer(header) + flatBuffer(flatTable({}, {{0, nested}}));
+    };
+
+    std::string error;
+    const QByteArray deep = nestedData(1000);
+    QVERIFY(!QMapLibre::FlatGeobuf::decode(deep.constData(), deep.size(), std::nullopt, error));
+    QVERIFY(!error.empty());
+
+    const QByteArray shallow = nestedData(8);
+    const auto collection = QMapLibre::FlatGeobuf::decode(shallow.constData(), shallow.size(), std::nullopt, error);
+    QVERIFY2(collection, error.c_str());
+    QCOMPARE(collection->get<mbgl::FeatureCollection>().size(), std::size_t{1});
+}
+
+void TestCore::benchmarkFeatureIngestion_data() {
+    QTest::addColumn<bool>("buffers");
+
+    QTest::newRow("features") << false;
+    QTest::newRow("buffers") << true;
+}
+
+void TestCore::benchmarkFeatureIngestion() {
+    using QMapLibre::Feature;
+    using QMapLibre::PropertyColumn;
+
+    QFETCH(bool, buffers);
+
+    const QVector<double> coordinates = bulkCoordinates();
+    QVector<double> speeds(BulkFeatureCount, 42.0);
+
+    if (buffers) {
+        QVector<qsizetype> featureOffsets(BulkFeatureCount + 1);
+        std::iota(featureOffsets.begin(), featureOffsets.end(), 0);
+
+        QBENCHMARK {
+            std::string error;
+            const auto collection = QMapLibre::GeoJSON::asFeatureCollection(Feature::PointType,
+                                                                            coordinates,
+                                                                            featureOffsets,
+                                                                            {},
+                                                                            {},
+                                                                            {PropertyColumn("speed", speeds)},
+                                                                            error);
+            QCOMPARE(collection->size(), std::size_t{BulkFeatureCount});
+        }
+        return;
+    }
+
+    // What a caller of Map::updateSource() has to do today.
+    QBENCHMARK {
+        QList<Feature> features;
+        features.reserve(BulkFeatureCount);
+        for (int i = 0; i < BulkFeatureCount; ++i) {
+            const QMapLibre::Coordinate coordinate{coordinates[2 * i + 1], coordinates[2 * i]};
+            features.append(Feature(Feature::PointType,
+                                    {{{coordinate}}},
+                                    {{QStringLiteral("speed"), speeds[i]}}));
+        }
+
+        mbgl::style::conversion::Error error;
+        const auto geojson = mbgl::style::conversion::convert<mbgl::GeoJSON>(QVariant::fromValue(features), error);
+        QVERIFY(geojson.has_value());
+    }
+}
+
+void TestCore::benchmarkCompactFeatureIngestion_data() {
+    QTest::addColumn<bool>("quantized");
+
+    QTest::newRow("float buffers") << false;
+    QTest::newRow("quantized buffers") << true;
+}
+
+void TestCore::benchmarkCompactFeatureIngestion() {
+    using QMapLibre::Feature;
+    using QMapLibre::PropertyColumn;
+
+    QFETCH(bool, quantized);
+
+    const QVector<double> coordinates = bulkCoordinates();
+    const QVector<double> speeds(BulkFeatureCount, 42.0);
+    const QVector<PropertyColumn> properties{PropertyColumn("speed", speeds)};
+
+    QVector<qsizetype> featureOffsets(BulkFeatureCount + 1);
+    std::iota(featureOffsets.begin(), featureOffsets.end(), 0);
+
+    if (quantized) {
+        const QMapLibre::CoordinateQuantization quantization{{0.0, 0.0}, 1e-7};
+        QVector<qint32> integers(coordinates.size());
+        std::transform(coordinates.cbegin(), coordinates.cend(), integers.begin(), [](double value) {
+            return static_cast<qint32>(std::lround(value / 1e-7));
+        });
+        QBENCHMARK {
+            std::string error;
+            const auto collection = QMapLibre::GeoJSON::asFeatureCollection(
+                Feature::PointType, integers, quantization, featureOffsets, {}, {}, properties, error);
+            QCOMPARE(collection->size(), std::size_t{BulkFeatureCount});
+        }
+        return;
+    }
+
+    QVector<float> floats(coordinates.size());
+    std::transform(coordinates.cbegin(), coordinates.cend(), floats.begin(), [](double value) {
+        return static_cast<float>(value);
+    });
+    QBENCHMARK {
+        std::string error;
+        const auto collection = QMapLibre::GeoJSON::asFeatureCollection(
+            Feature::PointType, floats, featureOffsets, {}, {}, properties, error);
+        QCOMPARE(collection->size(), std::size_t{BulkFeatureCount});
+    }
+}
+
+void TestCore::testConversionNormalized() {
+    using mbgl::style::conversion::normalized;
+
+    // Values made of QVariantList and QVariantMap are not copied.
+    const QVariantList native{QStringLiteral("=="), QStringLiteral("name"), QStringLiteral("Munich")};
+    QCOMPARE(normalized(native).toList().constData(), native.constData());
+
+    const QVariantHash paint{{QStringLiteral("circle-radius"), 4}};
+    const QVariantMap layer{{QStringLiteral("filter"), QStringList{"has", "name"}},
+                            {QStringLiteral("paint"), paint},
+                            {QStringLiteral("type"), QStringLiteral("circle")}};
+
+    const QVariant result = normalized(layer);
+    QCOMPARE(result.typeId(), QMetaType::QVariantMap);
+
+    const QVariantMap map = result.toMap();
+    QCOMPARE(map[QStringLiteral("filter")].typeId(), QMetaType::QVariantList);
+    QCOMPARE(map[QStringLiteral("filter")].toList().size(), 2);
+    QCOMPARE(map[QStringLiteral("paint")].typeId(), QMetaType::QVariantMap);
+    QCOMPARE(map[QStringLiteral("paint")].toMap()[QStringLiteral("circle-radius")].toInt(), 4);
+    QCOMPARE(map[QStringLiteral("type")].toString(), QStringLiteral("circle"));
+}
+
+void TestCore::benchmarkConversion_data() {
+    QTest::addColumn<bool>("layer");
+    QTest::addColumn<bool>("normalize");
+
+    QTest::newRow("filter, converted on access") << false << false;
+    QTest::newRow("filter, normalized") << false << true;
+    QTest::newRow("layer, converted on access") << true << false;
+    QTest::newRow("layer, normalized") << true << true;
+}
+
+void TestCore::benchmarkConversion() {
+    namespace conversion = mbgl::style::conversion;
+
+    QFETCH(bool, layer);
+    QFETCH(bool, normalize);
+
+    // A QStringList is not a QVariantList, so every member access used to
+    // convert the whole list.
+    QStringList filter{QStringLiteral("in"), QStringLiteral("name")};
+    for (int i = 0; i < FilterValueCount; ++i) {
+        filter.append(QString::number(i));
+    }
+
+    const QVariantMap parameters{{QStringLiteral("id"), QStringLiteral("points")},
+                                 {QStringLiteral("type"), QStringLiteral("circle")},
+                                 {QStringLiteral("source"), QStringLiteral("points")},
+                                 {QStringLiteral("filter"), filter},
+                                 {QStringLiteral("paint"), QVariantHash{{QStringLiteral("circle-radius"), 4}}}};
+
+    const QVariant value = layer ? QVariant(parameters) : QVariant(filter);
+    const auto convertible = [&value, normalize] {
+        return conversion::Convertible(normalize ? conversion::normalized(value) : value);
+    };
+
+    if (layer) {
+        QBENCHMARK {
+            conversion::Error error;
+            const auto result = conversion::convert<std::unique_ptr<mbgl::style::Layer>>(convertible(), error);
+            QVERIFY2(result.has_value(), error.message.c_str());
+        }
+        return;
+    }
+
+    QBENCHMARK {
+        conversion::Error error;
+        const auto result = conversion::convert<mbgl::style::Filter>(convertible(), error);
+        QVERIFY2(result.has_value(), error.message.c_str());
+    }
+}
+
+void TestCore::testPropertyConverter() {
+    QMapLibre::GeoJSON::PropertyConverter converter;
+
+    QCOMPARE(converter.value(QVariant(-3)), mbgl::Value{int64_t{-3}});
+    QCOMPARE(converter.value(QVariant(3U)), mbgl::Value{uint64_t{3}});
+    QCOMPARE(converter.value(QVariant(short{-4})), mbgl::Value{int64_t{-4}});
+    QCOMPARE(converter.value(QVariant(1.5F)), mbgl::Value{1.5});
+    QCOMPARE(converter.value(QVariant::fromValue(nullptr)), mbgl::Value{mbgl::NullValue()});
+    QCOMPARE(converter.value(QStringLiteral("stra\u00dfe")), mbgl::Value{std::string("stra\xc3\x9f" "e")});
+    QCOMPARE(converter.value(QStringList{QStringLiteral("a"), QStringLiteral("b")}),
+             (mbgl::Value{std::vector<mbgl::Value>{std::string("a"), std::string("b")}}));
+
+    const QVariantHash nested{{QStringLiteral("count"), 2}};
+    const mbgl::PropertyMap properties = converter.properties({{QStringLiteral("nested"), nested}});
+    QCOMPARE(properties.at("nested"),
+             (mbgl::Value{std::unordered_map<std::string, mbgl::Value>{{"count", int64_t{2}}}}));
+
+    // Keys are converted once.
+    const std::string &key = converter.key(QStringLiteral("count"));
+    QCOMPARE(&converter.key(QStringLiteral("count")), &key);
+    QCOMPARE(key, std::string("count"));
+
+    // Sources with ever new keys do not grow the cache without bound.
+    using QMapLibre::GeoJSON::PropertyConverter;
+    for (std::size_t i = 0; i < 2 * PropertyConverter::MaxKeyCount; ++i) {
+        const mbgl::PropertyMap converted = converter.properties({{QStringLiteral("key %1").arg(i), 1}});
+        QCOMPARE(converted.size(), std::size_t{1});
+        QVERIFY(converter.keyCount() <= PropertyConverter::MaxKeyCount);
+    }
+}
+
+void TestCore::benchmarkPropertyConversion_data() {
+    QTest::addColumn<bool>("shared");
+
+    QTest::newRow("converter per feature") << false;
+    QTest::newRow("shared converter") << true;
+}
+
+void TestCore::benchmarkPropertyConversion() {
+    using QMapLibre::Feature;
+
+    QFETCH(bool, shared);
+
+    // Property maps are implicitly shared, a few distinct ones keep the memory
+    // of the features low while each feature is still converted.
+    QVector<QVariantMap> properties;
+    for (int i = 0; i < 100; ++i) {
+        properties.append({{QStringLiteral("name"), QStringLiteral("feature %1").arg(i)},
+                           {QStringLiteral("category"), QStringLiteral("road")},
+                           {QStringLiteral("rank"), i},
+                           {QStringLiteral("speed"), 1.5F * static_cast<float>(i)},
+                           {QStringLiteral("tags"), QStringList{QStringLiteral("a"), QStringLiteral("b")}}});
+    }
+
+    const QMapLibre::CoordinatesCollections geometry{{{QMapLibre::Coordinate(0.0, 0.0)}}};
+    QList<Feature> features;
+    features.reserve(PropertyFeatureCount);
+    for (int i = 0; i < PropertyFeatureCount; ++i) {
+        features.append(Feature(Feature::PointType, geometry, properties[i % properties.size()]));
+    }
+
+    QBENCHMARK {
+        QMapLibre::GeoJSON::PropertyConverter converter;
+        std::size_t count = 0;
+        for (const Feature &feature : std::as_const(features)) {
+            count += shared ? converter.properties(feature.properties).size()
+                            : QMapLibre::GeoJSON::PropertyConverter().properties(feature.properties).size();
+        }
+        QCOMPARE(count, std::size_t{5} * PropertyFeatureCount);
+    }
+}
+
+void TestCore::testSimplification() {
+    using QMapLibre::Simplification::Algorithm;
+
+    // A zigzag with deviations well below the tolerance.
+    const mbgl::LineString<double> zigzag{{0, 0}, {1, 0.00001}, {2, 0}, {3, 0.00001}, {4, 0}, {5, 1}};
+
+    for (const Algorithm algorithm : {Algorithm::DouglasPeucker, Algorithm::VisvalingamWhyatt}) {
+        mbgl::GeoJSON geojson{mbgl::Geometry<double>{zigzag}};
+        QMapLibre::Simplification::simplify(geojson, {algorithm, 0.01});
+        QCOMPARE(geojson.get<mbgl::Geometry<double>>().get<mbgl::LineString<double>>(),
+                 (mbgl::LineString<double>{{0, 0}, {4, 0}, {5, 1}}));
+
+        // Nothing is removed below the tolerance.
+        geojson = mbgl::Geometry<double>{zigzag};
+        QMapLibre::Simplification::simplify(geojson, {algorithm, 0.000001});
+        QCOMPARE(geojson.get<mbgl::Geometry<double>>().get<mbgl::LineString<double>>(), zigzag);
+
+        // Rings stay closed and holes that collapse are removed.
+        const mbgl::Polygon<double> polygon{{{0, 0}, {0.5, 0}, {1, 0}, {1, 1}, {0, 1}, {0, 0}},
+                                            {{0.5, 0.5}, {0.501, 0.5}, {0.501, 0.501}, {0.5, 0.501}, {0.5, 0.5}}};
+        geojson = mbgl::GeoJSONFeature{polygon};
+        QMapLibre::Simplification::simplify(geojson, {algorithm, 0.01});
+        const auto &simplified = geojson.get<mbgl::GeoJSONFeature>().geometry.get<mbgl::Polygon<double>>();
+        QCOMPARE(simplified.size(), std::size_t{1});
+        QCOMPARE(simplified[0], (mbgl::LinearRing<double>{{0, 0}, {1, 0}, {1, 1}, {0, 1}, {0, 0}}));
+    }
+}
+
+void TestCore::testSimplificationParallel() {
+    const QVector<double> coordinates = bulkCoordinates();
+
+    // Tracks of 100 points each, with noise that simplification removes.
+    mbgl::FeatureCollection features;
+    for (qsizetype i = 0; i + 200 <= coordinates.size(); i += 200) {
+        mbgl::LineString<double> track;
+        for (qsizetype j = i; j < i + 200; j += 2) {
+            track.emplace_back(coordinates[j], coordinates[j + 1] + ((j / 2) % 2) * 1e-7);
+        }
+        features.emplace_back(std::move(track));
+    }
+
+    const QMapLibre::Simplification::Options options{QMapLibre::Simplification::Algorithm::DouglasPeucker, 1e-5};
+    mbgl::GeoJSON sequential{features};
+    QMapLibre::Simplification::simplify(sequential, options);
+
+    QMapLibre::ThreadPool pool({4, QThread::InheritPriority, {}});
+    std::atomic<int> scheduled{0};
+    mbgl::GeoJSON parallel{features};
+    QMapLibre::Simplification::simplify(parallel, options, [&](std::function<void()> task) {
+        ++scheduled;
+        pool.schedule(std::move(task));
+    });
+    pool.waitForEmpty();
+
+    QVERIFY(QThread::idealThreadCount() == 1 || scheduled.load() > 0);
+    QVERIFY(sequential.get<mbgl::FeatureCollection>() == parallel.get<mbgl::FeatureCollection>());
+    QVERIFY(sequential.get<mbgl::FeatureCollection>() != features);
+}
+
+void TestCore::testHeadlessRendering() {
+#ifdef MLN_QT_WITH_HEADLESS
+    QMapLibre::Map map(nullptr, QMapLibre::Settings(), QSize(64, 64));
+    map.setStyleJson(QStringLiteral(R"({
+        "version": 8,
+        "sources": {},
+        "layers": [{"id": "background", "type": "background", "paint": {"background-color": "#ff0000"}}]
+    })"));
+
+    if (!map.createHeadlessRenderer()) {
+        QSKIP("No OpenGL offscreen surface available");
+    }
+
+    QTRY_COMPARE(map.grabFrame().pixelColor(32, 32), QColor(Qt::red));
+
+    // The framebuffer follows the map size.
+    map.resize(QSize(48, 16));
+    const QImage frame = map.grabFrame();
+    QCOMPARE(frame.size(), QSize(48, 16));
+    QCOMPARE(frame.pixelColor(0, 15), QColor(Qt::red));
+
+    map.destroyRenderer();
+    QVERIFY(map.grabFrame().isNull());
+#else
+    QSKIP("Built without MLN_QT_WITH_HEADLESS");
+#endif
+}
+
+void TestCore::testHeadlessFrameReadback() {
+#ifdef MLN_QT_WITH_HEADLESS
+    QMapLibre::Map map(nullptr, QMapLibre::Settings(), QSize(64, 64));
+    map.setStyleJson(QStringLiteral(R"({
+        "version": 8,
+        "sources": {},
+        "layers": [{"id": "background", "type": "background", "paint": {"background-color": "#ff0000"}}]
+    })"));
+
+    if (!map.createHeadlessRenderer()) {
+        QSKIP("No OpenGL offscreen surface available");
+    }
+
+    QObject::connect(&map, &QMapLibre::Map::needsRendering, &map, &QMapLibre::Map::render);
+    QTRY_COMPARE(map.grabFrame().pixelColor(32, 32), QColor(Qt::red));
+
+    // Requests made before the same frame share it.
+    QFuture<QImage> first = map.grabFrameAsync();
+    QFuture<QImage> second = map.grabFrameAsync();
+    QTRY_VERIFY(first.isFinished() && second.isFinished());
+    QVERIFY(!first.isCanceled());
+    QCOMPARE(first.result().size(), QSize(64, 64));
+    QCOMPARE(first.result().pixelColor(32, 32), QColor(Qt::red));
+    QCOMPARE(second.result().pixelColor(0, 63), QColor(Qt::red));
+
+    // Reads still in flight are canceled with the renderer, as well as reads
+    // waiting for the next frame.
+    QFuture<QImage> pending = map.grabFrameAsync();
+    map.render();
+    QFuture<QImage> queued = map.grabFrameAsync();
+    map.destroyRenderer();
+    QVERIFY(pending.isCanceled() || pending.isFinished());
+    QVERIFY(queued.isFinished());
+    QVERIFY(queued.isCanceled());
+#else
+    QSKIP("Built without MLN_QT_WITH_HEADLESS");
+#endif
+}
+
+void TestCore::testColorTargetRing() {
+#ifdef MLN_QT_WITH_HEADLESS
+    // OpenGLRendererBackend::ColorTargetCount
+    constexpr qsizetype ColorTargetCount = 3;
+
+    QMapLibre::Map map(nullptr, QMapLibre::Settings(), QSize(64, 64));
+    map.setStyleJson(QStringLiteral(R"({
+        "version": 8,
+        "sources": {},
+        "layers": [{"id": "background", "type": "background", "paint": {"background-color": "#ff0000"}}]
+    })"));
+
+    if (!map.createHeadlessRenderer()) {
+        QSKIP("No OpenGL offscreen surface available");
+    }
+
+    QObject::connect(&map, &QMapLibre::Map::needsRendering, &map, &QMapLibre::Map::render);
+    QTRY_COMPARE(map.grabFrame().pixelColor(32, 32), QColor(Qt::red));
+    QObject::disconnect(&map, &QMapLibre::Map::needsRendering, &map, &QMapLibre::Map::render);
+
+    const auto renderFrames = [&map](qsizetype count) {
+        QList<unsigned int> textures;
+        for (qsizetype i = 0; i < count; ++i) {
+            map.render();
+            textures.append(map.getFramebufferTextureId());
+        }
+        return textures;
+    };
+
+    // Consecutive frames go to distinct textures and the ring wraps around.
+    const QList<unsigned int> textures = renderFrames(2 * ColorTargetCount);
+    QCOMPARE(QSet<unsigned int>(textures.begin(), textures.end()).size(), ColorTargetCount);
+    QVERIFY(!textures.contains(0));
+    for (qsizetype i = 0; i < ColorTargetCount; ++i) {
+        QCOMPARE(textures[i + ColorTargetCount], textures[i]);
+    }
+
+    // Integrations that update the renderer before every frame with the same
+    // framebuffer and size keep the ring.
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    QVERIFY(context != nullptr);
+    GLint framebuffer{};
+    context->functions()->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    QVERIFY(framebuffer != 0);
+
+    QList<unsigned int> updated;
+    for (qsizetype i = 0; i < 2 * ColorTargetCount; ++i) {
+        map.updateRenderer(QSize(64, 64), 1, static_cast<quint32>(framebuffer));
+        updated += renderFrames(1);
+    }
+    QCOMPARE(QSet<unsigned int>(updated.begin(), updated.end()),
+             QSet<unsigned int>(textures.begin(), textures.end()));
+    QCOMPARE(map.grabFrame().pixelColor(32, 32), QColor(Qt::red));
+#else
+    QSKIP("Built without MLN_QT_WITH_HEADLESS");
+#endif
+}
+
+void TestCore::testThreadedMapRenderer() {
+#ifdef MLN_QT_WITH_HEADLESS
+    QOffscreenSurface surface;
+    surface.create();
+    QOpenGLContext context;
+    if (!surface.isValid() || !context.create() || !context.makeCurrent(&surface)) {
+        QSKIP("No OpenGL offscreen surface available");
+    }
+
+    QMapLibre::Map map(nullptr, QMapLibre::Settings(), QSize(64, 64));
+    map.setStyleJson(QStringLiteral(R"({
+        "version": 8,
+        "sources": {},
+        "layers": [{"id": "background", "type": "background", "paint": {"background-color": "#ff0000"}}]
+    })"));
+
+    QMapLibre::ThreadedMapRenderer renderer(&map, &context);
+    renderer.setSize(QSize(64, 64), 1);
+    QSignalSpy ready(&renderer, &QMapLibre::ThreadedMapRenderer::frameReady);
+    renderer.start();
+    QVERIFY(renderer.isRunning());
+
+    // Textures are shared with our context, framebuffers are not.
+    const auto readTexture = [&context](quint32 texture, const QSize &size) {
+        QOpenGLFunctions *gl = context.functions();
+        GLuint framebuffer{};
+        gl->glGenFramebuffers(1, &framebuffer);
+        gl->glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
+        QImage image(size, QImage::Format_RGBA8888);
+        gl->glReadPixels(0, 0, size.width(), size.height(), GL_RGBA, GL_UNSIGNED_BYTE, image.bits());
+
+        gl->glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        gl->glDeleteFramebuffers(1, &framebuffer);
+        return image;
+    };
+
+    // The first frames may be rendered before the style is loaded.
+    QSize textureSize;
+    QImage frame;
+    QTRY_VERIFY([&] {
+        const quint32 texture = renderer.acquireFrame(&textureSize);
+        if (texture == 0) {
+            return false;
+        }
+        frame = readTexture(texture, textureSize);
+        return frame.pixelColor(32, 32) == QColor(Qt::red);
+    }());
+
+    QVERIFY(!ready.isEmpty());
+    QCOMPARE(textureSize, QSize(64, 64));
+    QCOMPARE(frame.size(), QSize(64, 64));
+    QCOMPARE(frame.pixelColor(0, 0), QColor(Qt::red));
+    QCOMPARE(frame.pixelColor(63, 63), QColor(Qt::red));
+
+    renderer.stop();
+    QVERIFY(!renderer.isRunning());
+    QCOMPARE(renderer.acquireFrame(), quint32{0});
+    context.doneCurrent();
+#else
+    QSKIP("Built without MLN_QT_WITH_HEADLESS");
+#endif
+}
+
+void TestCore::testTileRenderer() {
+#ifdef MLN_QT_WITH_HEADLESS
+    using QMapLibre::TileId;
+    using QMapLibre::TileRenderer;
+
+    const QString style = QStringLiteral(R"({
+        "version": 8,
+        "sources": {},
+        "layers": [{"id": "background", "type": "background", "paint": {"background-color": "#ff0000"}}]
+    })");
+
+    TileRenderer renderer;
+    renderer.setStyleJson(style);
+    renderer.setTileSize(256);
+    renderer.setRendererCount(2);
+
+    QSignalSpy ready(&renderer, &QMapLibre::TileRenderer::tileReady);
+    QSignalSpy failed(&renderer, &QMapLibre::TileRenderer::tileFailed);
+    QSignalSpy finished(&renderer, &QMapLibre::TileRenderer::finished);
+
+    // Out of range, and too low a zoom level for 256 pixel tiles.
+    renderer.render({{1, 0, 0}, {1, 2, 0}, {2, 3, 1}, {0, 0, 0}, {1, 1, 1}});
+    QVERIFY(renderer.isRendering());
+    QVERIFY(finished.wait(30000) || finished.count() == 1);
+
+    if (failed.count() == 5) {
+        QSKIP("No OpenGL offscreen surface available");
+    }
+
+    QCOMPARE(failed.count(), 2);
+    QCOMPARE(ready.count(), 3);
+    QVERIFY(!renderer.isRendering());
+
+    QList<TileId> tiles;
+    for (const auto &arguments : std::as_const(ready)) {
+        tiles.append(arguments.at(0).value<TileId>());
+
+        const QImage image = QImage::fromData(arguments.at(1).toByteArray(), "PNG");
+        QCOMPARE(image.size(), QSize(256, 256));
+        QCOMPARE(image.pixelColor(128, 128), QColor(Qt::red));
+    }
+    QVERIFY(tiles.contains(TileId{1, 0, 0}));
+    QVERIFY(tiles.contains(TileId{2, 3, 1}));
+    QVERIFY(tiles.contains(TileId{1, 1, 1}));
+
+    // Canceled tiles are not reported.
+    renderer.render({{1, 0, 0}, {1, 1, 0}});
+    renderer.cancel();
+    QVERIFY(!renderer.isRendering());
+    QTest::qWait(100);
+    QCOMPARE(ready.count(), 3);
+    QCOMPARE(finished.count(), 1);
+
+    // Tiles queued after a size change get the new size, also while others
+    // are still in flight. Zoom level 0 is only valid for 512 pixel tiles.
+    ready.clear();
+    failed.clear();
+    finished.clear();
+    renderer.render({{1, 0, 0}, {1, 1, 0}});
+    renderer.setTileSize(512);
+    renderer.render({{0, 0, 0}, {1, 0, 1}});
+    QVERIFY(finished.wait(30000) || finished.count() == 1);
+    QCOMPARE(failed.count(), 0);
+    QCOMPARE(ready.count(), 4);
+
+    for (const auto &arguments : std::as_const(ready)) {
+        const auto tile = arguments.at(0).value<TileId>();
+        const QImage image = QImage::fromData(arguments.at(1).toByteArray(), "PNG");
+        const bool resized = tile == TileId{0, 0, 0} || tile == TileId{1, 0, 1};
+        QCOMPARE(image.size(), resized ? QSize(512, 512) : QSize(256, 256));
+    }
+
+    // Tiles in flight are dropped with the renderer.
+    auto inFlight = std::make_unique<TileRenderer>();
+    inFlight->setStyleJson(style);
+    inFlight->setRendererCount(2);
+
+    bool destroying = false;
+    int reportedWhileDestroying = 0;
+    const auto report = [&destroying, &reportedWhileDestroying] { reportedWhileDestroying += destroying ? 1 : 0; };
+    QObject::connect(inFlight.get(), &TileRenderer::tileReady, report);
+    QObject::connect(inFlight.get(), &TileRenderer::tileFailed, report);
+
+    QSignalSpy firstReady(inFlight.get(), &TileRenderer::tileReady);
+    inFlight->render({{2, 0, 0}, {2, 1, 0}, {2, 2, 0}, {2, 3, 0}, {2, 0, 1}, {2, 1, 1}, {2, 2, 1}, {2, 3, 1}});
+    QVERIFY(firstReady.wait(30000));
+    destroying = true;
+    inFlight.reset();
+    QTest::qWait(100);
+    QCOMPARE(reportedWhileDestroying, 0);
+#else
+    QSKIP("Built without MLN_QT_WITH_HEADLESS");
+#endif
+}
+
+// NOLINTNEXTLINE(misc-const-correctness)
+QTEST_MAIN(TestCore)
+#include "test_core.moc"
@@ -0,0 +1,69 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+import QtQuick 2.15
+import QtQuick.Window 2.15
+import QtLocation 6.5
+import QtPositioning 6.5
+
+import MapLibre.Location 4.0
+
+import QtTest 1.0
+
+Item {
+    id: root
+    width: 256
+    height: 256
+
+    property int frames: 0
+
+    Connections {
+        target: root.Window.window
+        function onFrameSwapped() {
+            root.frames++
+        }
+    }
+
+    Plugin {
+        id: mapPlugin
+        name: "maplibre"
+
+        PluginParameter {
+            name: "maplibre.map.styles"
+            value: Qt.resolvedUrl("fixtures/render_style.json").toString()
+        }
+    }
+
+    MapView {
+        id: mapView
+        anchors.fill: parent
+        map.plugin: mapPlugin
+
+        map.zoomLevel: 2
+        map.center: QtPositioning.coordinate(0, 0)
+    }
+
+    TestCase {
+        name: "Render"
+        when: windowShown
+
+        // The polygon is only drawn once its source is tiled in the
+        // background, the frame showing it is requested by the renderer.
+        // Frames stop once the map is idle, nothing polls for it.
+        function test_fully_rendered() {
+            tryVerify(function() { return root.frames > 0 }, 10000)
+
+            var frames = -1
+            for (var i = 0; i < 40 && frames !== root.frames; ++i) {
+                frames = root.frames
+                wait(500)
+            }
+            compare(root.frames, frames, "the map keeps rendering")
+
+            var image = grabImage(mapView)
+            verify(Qt.colorEqual(image.pixel(image.width / 2, image.height / 2), "#00ff00"),
+                   "the GeoJSON source is not drawn")
+        }
+    }
+}
@@ -0,0 +1,179 @@
+// Copyright (C) 2023 MapLibre contributors
+
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include <QFile>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QQuickGraphicsDevice>
+#include <QQuickItem>
+#include <QQuickRenderControl>
+#include <QQuickRenderTarget>
+#include <QQuickWindow>
+#include <QTest>
+
+#include <memory>
+
+namespace {
+
+constexpr int WarmUpFrames = 1000;
+constexpr int DefaultSoakFrames = 100000;
+// Allocator and driver noise, a wrapper leaked per frame adds far more.
+constexpr qint64 MaxGrowth = 4 * 1024 * 1024;
+
+qint64 residentMemory() {
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields.at(1).toLongLong() * 4096 : -1;
+}
+
+// A MapLibre item rendered offscreen through QQuickRenderControl, as fast
+// as the GPU allows.
+class Scene {
+public:
+    Scene() {
+        QQuickWindow::setGraphicsApi(QSGRendererInterface::OpenGL);
+
+        if (!m_context.create()) {
+            m_error = "No OpenGL context available";
+            return;
+        }
+
+        m_surface.setFormat(m_context.format());
+        m_surface.create();
+        if (!m_context.makeCurrent(&m_surface)) {
+            m_error = "Unable to make the OpenGL context current";
+            return;
+        }
+
+        QOpenGLFunctions *gl = m_context.functions();
+        gl->glGenTextures(1, &m_texture);
+        gl->glBindTexture(GL_TEXTURE_2D, m_texture);
+        gl->glTexImage2D(
+            GL_TEXTURE_2D, 0, GL_RGBA, Size.width(), Size.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        m_window.setGraphicsDevice(QQuickGraphicsDevice::fromOpenGLContext(&m_context));
+        m_window.resize(Size);
+        if (!m_control.initialize()) {
+            m_error = "Unable to initialize the scene graph";
+            return;
+        }
+        m_window.setRenderTarget(QQuickRenderTarget::fromOpenGLTexture(m_texture, Size));
+
+        QQmlComponent component(&m_engine);
+        const QByteArray qml = R"(
+            import QtQuick 2.15
+            import MapLibre 4.0
+
+            MapLibre {
+                width: 64
+                height: 64
+            }
+        )";
+        component.setData(qml, QUrl());
+        m_map.reset(qobject_cast<QQuickItem *>(component.create()));
+        if (m_map == nullptr) {
+            m_error = component.errorString().toUtf8();
+            return;
+        }
+        m_map->setParentItem(m_window.contentItem());
+    }
+
+    ~Scene() {
+        m_map.reset();
+        if (m_texture != 0 && m_context.makeCurrent(&m_surface)) {
+            m_context.functions()->glDeleteTextures(1, &m_texture);
+        }
+    }
+
+    [[nodiscard]] const QByteArray &error() const { return m_error; }
+
+    void renderFrame() {
+        // Every frame goes through the texture node.
+        m_map->update();
+        QCoreApplication::processEvents();
+
+        m_control.polishItems();
+        m_control.beginFrame();
+        m_control.sync();
+        m_control.render();
+        m_control.endFrame();
+    }
+
+private:
+    static constexpr QSize Size{64, 64};
+
+    QByteArray m_error;
+    QOpenGLContext m_context;
+    QOffscreenSurface m_surface;
+    GLuint m_texture{};
+    QQuickRenderControl m_control;
+    QQuickWindow m_window{&m_control};
+    QQmlEngine m_engine;
+    std::unique_ptr<QQuickItem> m_map;
+};
+
+} // namespace
+
+class TestQuickSoak : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testMemoryStaysFlat();
+    void benchmarkFrames();
+};
+
+void TestQuickSoak::testMemoryStaysFlat() {
+    if (residentMemory() < 0) {
+        QSKIP("Resident memory is only measured on Linux");
+    }
+
+    Scene scene;
+    if (!scene.error().isEmpty()) {
+        QSKIP(scene.error().constData());
+    }
+
+    // Can be lowered for quick local runs.
+    const int frames = qEnvironmentVariableIsSet("MLN_QT_SOAK_FRAMES")
+                           ? qEnvironmentVariableIntValue("MLN_QT_SOAK_FRAMES")
+                           : DefaultSoakFrames;
+
+    qint64 baseline = 0;
+    for (int frame = 0; frame < WarmUpFrames + frames; ++frame) {
+        if (frame == WarmUpFrames) {
+            baseline = residentMemory();
+        }
+        scene.renderFrame();
+    }
+
+    const qint64 growth = residentMemory() - baseline;
+    QVERIFY2(growth < MaxGrowth,
+             qPrintable(QStringLiteral("Resident memory grew by %1 bytes over %2 frames").arg(growth).arg(frames)));
+}
+
+// Time per frame rendered by MapLibre and composited by the scene graph.
+void TestQuickSoak::benchmarkFrames() {
+    Scene scene;
+    if (!scene.error().isEmpty()) {
+        QSKIP(scene.error().constData());
+    }
+
+    for (int frame = 0; frame < WarmUpFrames; ++frame) {
+        scene.renderFrame();
+    }
+
+    QBENCHMARK {
+        scene.renderFrame();
+    }
+}
+
+QTEST_MAIN(TestQuickSoak)
+
+#include "test_quick_soak.moc"